@@ -0,0 +1,241 @@
+// Microbenchmarks of the gm drawing bindings. Each case calls one binding from a
+// Lua loop against a software renderer drawing into a plain surface, so there is
+// no GPU, window or vsync in the numbers. The cost of the empty loop is
+// subtracted, what is left is the binding plus the software drawing it causes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include "gm_lua.h"
+
+#define GM_BENCH_DEFAULT_ITERATIONS 1000000
+
+// calls per Lua loop, the renderer is flushed between loops so its command queue stays small
+#define GM_BENCH_CHUNK 10000
+
+#define GM_BENCH_CANVAS 64
+
+typedef struct
+{
+    const char *name;
+    const char *body;
+} gm_bench_case_t;
+
+// `gm`, `c` (a packed colour) and the loop counter `i` are in scope in every body
+static const gm_bench_case_t gm_bench_cases[] = {
+    {"loop", ""},
+    {"rgba", "gm.rgba(i & 255, 64, 128, 255)"},
+    {"setColor", "gm:setColor(i & 255, 64, 128, 255)"},
+    {"setColor packed", "gm:setColor(c)"},
+    {"clear", "gm:clear(i & 255, 0, 0, 255)"},
+    {"setPixel", "gm:setPixel(i & 63, (i >> 6) & 63)"},
+    {"setPixel color", "gm:setPixel(i & 63, (i >> 6) & 63, i & 255, 0, 0, 255)"},
+    {"line", "gm:line(0, i & 63, 63, 63 - (i & 63))"},
+    {"fillRect", "gm:fillRect(i & 31, 16, 16, 16)"},
+    {"fillRect color", "gm:fillRect(i & 31, 16, 16, 16, 0, i & 255, 0, 255)"},
+};
+
+// Counts the blocks the Lua allocator hands out, then defers to the original one.
+typedef struct
+{
+    lua_Alloc alloc;
+    void *ud;
+    uint64_t blocks;
+} gm_bench_alloc_t;
+
+static void *gm_bench_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    gm_bench_alloc_t *a = (gm_bench_alloc_t *)ud;
+    if (nsize > 0 && (ptr == NULL || nsize > osize))
+    {
+        a->blocks++;
+    }
+    return a->alloc(a->ud, ptr, osize, nsize);
+}
+
+typedef struct
+{
+    double ns;
+    double allocs;
+} gm_bench_result_t;
+
+// Runs one case for `iterations` calls, returns false if its Lua code fails.
+static bool gm_bench_run(lua_State *L, SDL_Renderer *renderer, gm_bench_alloc_t *counter, const gm_bench_case_t *bc,
+                         int iterations, gm_bench_result_t *result)
+{
+    char code[512];
+    SDL_snprintf(code, sizeof(code), "local gm, n, c = ... for i = 1, n do %s end", bc->body);
+    if (luaL_loadstring(L, code) != LUA_OK)
+    {
+        fprintf(stderr, "%s: %s\n", bc->name, lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return false;
+    }
+    int chunk_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    uint64_t ns = 0;
+    uint64_t blocks = 0;
+    for (int done = 0; done < iterations; done += GM_BENCH_CHUNK)
+    {
+        int n = SDL_min(GM_BENCH_CHUNK, iterations - done);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, chunk_ref);
+        lua_getglobal(L, "gm");
+        lua_pushinteger(L, n);
+        lua_pushinteger(L, 0x336699ff);
+
+        // collect outside the timed part, so garbage from one chunk is not charged to the next
+        lua_gc(L, LUA_GCCOLLECT);
+        uint64_t blocks_before = counter->blocks;
+        uint64_t start = SDL_GetTicksNS();
+        int status = lua_pcall(L, 3, 0, 0);
+        SDL_FlushRenderer(renderer);
+        ns += SDL_GetTicksNS() - start;
+        blocks += counter->blocks - blocks_before;
+
+        if (status != LUA_OK)
+        {
+            fprintf(stderr, "%s: %s\n", bc->name, lua_tostring(L, -1));
+            lua_pop(L, 1);
+            luaL_unref(L, LUA_REGISTRYINDEX, chunk_ref);
+            return false;
+        }
+    }
+    luaL_unref(L, LUA_REGISTRYINDEX, chunk_ref);
+
+    result->ns = (double)ns / iterations;
+    result->allocs = (double)blocks / iterations;
+    return true;
+}
+
+static void gm_bench_usage(const char *program)
+{
+    printf("usage: %s [options]\n", program);
+    printf("  --iterations N  calls per binding (default %d)\n", GM_BENCH_DEFAULT_ITERATIONS);
+    printf("  --filter TEXT   only run the cases whose name contains TEXT\n");
+    printf("  --csv           print name,ns_per_call,allocs_per_call lines, for tracking across commits\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = GM_BENCH_DEFAULT_ITERATIONS;
+    const char *filter = NULL;
+    bool csv = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else
+        {
+            gm_bench_usage(argv[0]);
+            return SDL_strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (iterations < 1)
+    {
+        fprintf(stderr, "Invalid iteration count.\n");
+        return 1;
+    }
+
+    if (!SDL_Init(0))
+    {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // the same software setup as batch renders
+    SDL_Surface *surface = SDL_CreateSurface(GM_BENCH_CANVAS, GM_BENCH_CANVAS, SDL_PIXELFORMAT_RGBA8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    SDL_Texture *canvas = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                                       GM_BENCH_CANVAS, GM_BENCH_CANVAS)
+                                   : NULL;
+    if (canvas == NULL)
+    {
+        fprintf(stderr, "Could not create the software canvas: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_SetRenderTarget(renderer, canvas);
+
+    // no script is loaded, the state is only used to call the bindings
+    gm_lua_t *lua_ctx = NULL;
+    gm_lua_error_t err = gm_lua_init_script(&lua_ctx, NULL, NULL);
+    if (err.code > 100)
+    {
+        fprintf(stderr, "%s\n", err.message);
+        return 1;
+    }
+    gm_lua_register_game_api(lua_ctx, renderer, canvas, GM_BENCH_CANVAS, GM_BENCH_CANVAS);
+    lua_State *L = lua_ctx->L;
+
+    gm_bench_alloc_t counter;
+    counter.alloc = lua_getallocf(L, &counter.ud);
+    counter.blocks = 0;
+    lua_setallocf(L, gm_bench_alloc, &counter);
+
+    if (csv)
+    {
+        printf("name,ns_per_call,allocs_per_call\n");
+    }
+    else
+    {
+        printf("%d calls per binding on a %dx%d software canvas, empty loop subtracted\n\n", iterations,
+               GM_BENCH_CANVAS, GM_BENCH_CANVAS);
+        printf("%-18s %12s %14s\n", "binding", "ns/call", "allocs/call");
+    }
+
+    int failed = 0;
+    gm_bench_result_t loop = {0.0, 0.0};
+    for (size_t i = 0; i < SDL_arraysize(gm_bench_cases); i++)
+    {
+        const gm_bench_case_t *bc = &gm_bench_cases[i];
+        bool baseline = (i == 0);
+        if (!baseline && filter && SDL_strstr(bc->name, filter) == NULL)
+        {
+            continue;
+        }
+
+        gm_bench_result_t r;
+        if (!gm_bench_run(L, renderer, &counter, bc, iterations, &r))
+        {
+            failed++;
+            continue;
+        }
+        if (baseline)
+        {
+            loop = r;
+            continue;
+        }
+
+        double ns = r.ns - loop.ns;
+        double allocs = r.allocs - loop.allocs;
+        if (csv)
+        {
+            printf("%s,%.2f,%.4f\n", bc->name, ns, allocs);
+        }
+        else
+        {
+            printf("%-18s %12.2f %14.4f\n", bc->name, ns, allocs);
+        }
+    }
+
+    // the allocator is restored before the state is closed, the counter lives on this stack
+    lua_setallocf(L, counter.alloc, counter.ud);
+    gm_lua_shutdown(lua_ctx);
+    SDL_DestroyTexture(canvas);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(surface);
+    SDL_Quit();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,6 @@
+function conf(c)
+    c.width = 160
+    c.height = 120
+    c.scale = 4
+    c.vsync = true
+end
@@ -0,0 +1,9 @@
+local t = 0
+
+function draw(dt)
+    t = t + dt
+    gm:clear(0, 0, 40)
+
+    local x = math.floor((t / 20) % gm.width)
+    gm:fillRect(x, gm.height / 2 - 4, 8, 8, 255, 200, 0)
+end
@@ -0,0 +1,24 @@
+local x = 100
+local y = 100
+
+function draw(dt)
+    local speed = dt / 10
+    if gm:keyDown("left") then x = x - speed end
+    if gm:keyDown("right") then x = x + speed end
+    if gm:keyDown("up") then y = y - speed end
+    if gm:keyDown("down") then y = y + speed end
+
+    for i, kind, code, mx, my in gm:events() do
+        if kind == "mousedown" then
+            x = mx
+            y = my
+        end
+    end
+
+    gm:clear(0, 0, 0)
+    gm:fillRect(math.floor(x), math.floor(y), 10, 10, 255, 255, 0)
+
+    if gm.mouse.left then
+        gm:setPixel(gm.mouse.x, gm.mouse.y, 255, 0, 0)
+    end
+end
@@ -0,0 +1,23 @@
+-- press keys a-k to play notes, space for a noise burst
+local notes = { a = 261.63, s = 293.66, d = 329.63, f = 349.23, g = 392.00, h = 440.00, j = 493.88, k = 523.25 }
+
+function draw(dt)
+    for key, freq in pairs(notes) do
+        if gm:keyPressed(key) then
+            gm.sound.tone{wave = "square", freq = freq, duration = 0.2, volume = 0.3, release = 0.15}
+        end
+    end
+
+    if gm:keyPressed("space") then
+        gm.sound.tone{wave = "noise", freq = 4000, duration = 0.05, volume = 0.4, release = 0.2}
+    end
+
+    gm:clear(0, 0, 0)
+    local stats = gm.sound.stats()
+    for i = 0, stats.voices * 8 do
+        gm:setPixel(10 + i, 10, 0, 255, 0)
+    end
+    if stats.underruns > 0 then
+        gm:setPixel(10, 20, 255, 0, 0)
+    end
+end
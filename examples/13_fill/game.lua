@@ -0,0 +1,15 @@
+-- the whole canvas of noise, as a native fill instead of a setPixel per pixel
+local t = 0
+
+function draw(dt)
+    t = t + dt
+
+    gm:fillGradient(0, 0, gm.width, gm.height / 2, 20, 20, 80, 200, 120, 40, true)
+    gm:fillGradient(0, gm.height / 2, gm.width, gm.height / 2, 200, 120, 40, 20, 20, 80, true, true)
+
+    gm:fillNoise(20, 20, 100, 80)
+    gm:fillNoise(140, 20, 100, 80, 42, "rgb")
+
+    local level = (math.sin(t / 500) + 1) / 2
+    gm:fillDither(20, 120, 220, 60, level, 255, 255, 255)
+end
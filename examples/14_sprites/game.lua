@@ -0,0 +1,28 @@
+-- 1000 bouncing sprites drawn with a single batch
+local atlas = gm.loadImage("sprites.bmp")
+local batch = gm.newSpriteBatch(atlas, 1000, 8, 8)
+
+local sprites = {}
+for i = 1, 1000 do
+    sprites[i] = {
+        x = math.random(0, gm.width - 8),
+        y = math.random(0, gm.height - 8),
+        dx = math.random() * 2 - 1,
+        dy = math.random() * 2 - 1,
+        frame = math.random(1, 4),
+    }
+end
+
+function draw(dt)
+    gm:clear(0, 0, 20)
+    batch:clear()
+    for i = 1, #sprites do
+        local s = sprites[i]
+        s.x = s.x + s.dx * dt / 10
+        s.y = s.y + s.dy * dt / 10
+        if s.x < 0 or s.x > gm.width - 8 then s.dx = -s.dx end
+        if s.y < 0 or s.y > gm.height - 8 then s.dy = -s.dy end
+        batch:add(s.frame, s.x, s.y)
+    end
+    gm:drawBatch(batch)
+end
@@ -0,0 +1,31 @@
+-- a starfield drawn once into a canvas, and a HUD layer redrawn only when the score changes
+local background = gm.newCanvas(gm.width, gm.height)
+local hud = gm.newCanvas(gm.width, 16)
+
+gm:setTarget(background)
+gm:clear(0, 0, 30)
+for i = 1, 2000 do
+    local v = math.random(80, 255)
+    gm:setPixel(math.random(0, gm.width - 1), math.random(0, gm.height - 1), v, v, v)
+end
+gm:setTarget()
+
+local score = -1
+local x = 0
+
+function draw(dt)
+    x = (x + dt / 10) % gm.width
+
+    local new_score = math.floor(x / 10)
+    if new_score ~= score then
+        score = new_score
+        gm:setTarget(hud)
+        gm:clear(0, 0, 0, 0)
+        gm:fillRect(2, 2, score * 2, 12, 0, 200, 0)
+        gm:setTarget()
+    end
+
+    gm:drawCanvas(background, 0, 0)
+    gm:fillRect(math.floor(x), gm.height / 2, 8, 8, 255, 255, 0)
+    gm:drawCanvas(hud, 0, 0)
+end
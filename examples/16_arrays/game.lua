@@ -0,0 +1,25 @@
+-- Conway's game of life on a typed array, stepped entirely with native bulk operations
+local W, H = gm.width // 2, gm.height // 2
+local cells = gm.array("u8", W, H)
+local sum = gm.array("f32", W, H)
+local palette = { gm.rgba(10, 10, 30), gm.rgba(120, 255, 120) }
+
+for y = 0, H - 1 do
+    for x = 0, W - 1 do
+        cells:set(x, y, math.random() < 0.3 and 1 or 0)
+    end
+end
+
+-- neighbours count 1 and the cell itself 0.5, so a cell lives on when the sum is 2.5 to 3.5
+local kernel = { 1, 1, 1, 1, 0.5, 1, 1, 1, 1 }
+
+function draw(dt)
+    sum:convolve(cells, kernel, "wrap")
+    sum:map("add", -3)
+    sum:map("abs")
+    sum:map("mul", -1)
+    sum:map("threshold", -0.5)
+    cells:copy(sum)
+
+    gm:drawArray(cells, palette, 0, 0, 2)
+end
@@ -0,0 +1,39 @@
+-- a slow terrain generator spread over many frames, while the main loop keeps animating
+local W, H = gm.width, gm.height
+local height = gm.array("u8", W, H)
+local palette = {}
+for i = 0, 255 do
+    palette[i + 1] = gm.rgba(i // 4, i // 2, i)
+end
+local rows_done = 0
+
+gm.spawnTask(function()
+    for y = 0, H - 1 do
+        for x = 0, W - 1 do
+            local v = 0
+            for octave = 1, 6 do
+                local f = 2 ^ octave / 64
+                v = v + (math.sin(x * f + octave) + math.cos(y * f * 1.3 - octave)) * 32 / octave
+            end
+            height:set(x, y, 128 + v)
+        end
+        rows_done = y + 1
+        coroutine.yield()
+    end
+end, "terrain")
+
+local t = 0
+
+function draw(dt)
+    t = t + dt
+    gm:drawArray(height, palette)
+
+    -- this keeps moving smoothly while the terrain is generated
+    gm:fillRect(math.floor(t / 10) % W, H - 10, 8, 8, 255, 255, 0)
+
+    if rows_done < H then
+        for _, task in ipairs(gm.taskStats()) do
+            gm:fillRect(0, 0, math.floor(task.time / 10), 2, 255, 0, 0)
+        end
+    end
+end
@@ -0,0 +1,40 @@
+-- a Mandelbrot set computed by workers, one band of rows each, while the main loop keeps animating
+local W, H = gm.width, gm.height
+local BANDS = 4
+local palette = {}
+for i = 0, 255 do
+    palette[i + 1] = gm.rgba(i, i // 2, 255 - i)
+end
+
+local workers = {}
+local bands = {}
+for i = 1, BANDS do
+    local y0 = (i - 1) * H // BANDS
+    local y1 = i * H // BANDS
+    workers[i] = gm.worker("mandel.lua")
+    bands[i] = {y = y0, h = y1 - y0}
+
+    -- the array moves to the worker, and comes back filled in
+    workers[i]:send({y = y0, w = W, h = y1 - y0, fullH = H, pixels = gm.array("u8", W, y1 - y0)})
+end
+
+local t = 0
+
+function draw(dt)
+    t = t + dt
+    gm:clear(0, 0, 0, 255)
+    for i, worker in ipairs(workers) do
+        local msg = worker:receive()
+        if msg then
+            bands[i].pixels = msg.pixels
+        end
+        if bands[i].pixels then
+            gm:drawArray(bands[i].pixels, palette, 0, bands[i].y)
+        elseif worker:error() then
+            gm:fillRect(0, bands[i].y, W, bands[i].h, 255, 0, 0)
+        end
+    end
+
+    -- this keeps moving smoothly while the workers compute
+    gm:fillRect(math.floor(t / 10) % W, H - 10, 8, 8, 255, 255, 0)
+end
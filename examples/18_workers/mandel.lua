@@ -0,0 +1,17 @@
+-- runs in a worker: fills the rows it is sent and sends the array back
+function onMessage(msg)
+    local pixels = msg.pixels
+    for y = 0, msg.h - 1 do
+        local ci = ((msg.y + y) / msg.fullH - 0.5) * 2.4
+        for x = 0, msg.w - 1 do
+            local cr = x / msg.w * 3.2 - 2.2
+            local zr, zi, n = 0, 0, 0
+            while n < 255 and zr * zr + zi * zi < 4 do
+                zr, zi = zr * zr - zi * zi + cr, 2 * zr * zi + ci
+                n = n + 1
+            end
+            pixels:set(x, y, n)
+        end
+    end
+    gm.send({pixels = pixels})
+end
@@ -0,0 +1,45 @@
+-- a spinning star of points and balls bouncing around, without allocating per frame
+local W, H = gm.width, gm.height
+local N = 64
+
+local balls = {}
+for i = 1, 200 do
+    balls[i] = {
+        pos = gm.vec2(math.random(0, W - 1), math.random(0, H - 1)),
+        vel = gm.vec2(1, 0):rotate(math.random() * 2 * math.pi):scale(20 + math.random() * 40),
+    }
+end
+
+-- the star's outline around the origin, one point per row
+local star = gm.array("f32", 2, N)
+for i = 0, N - 1 do
+    local r = (i % 2 == 0) and 40 or 16
+    local a = i / N * 2 * math.pi
+    star:set(0, i, math.cos(a) * r)
+    star:set(1, i, math.sin(a) * r)
+end
+local screen = gm.array("f32", 2, N)
+local m = gm.mat3()
+local t = 0
+
+function draw(dt)
+    t = t + dt / 1000
+    gm:clear(0, 0, 0, 255)
+
+    for _, b in ipairs(balls) do
+        b.pos:addScaled(b.vel, dt / 1000)
+        if b.pos.x < 0 or b.pos.x >= W then
+            b.vel.x = -b.vel.x
+        end
+        if b.pos.y < 0 or b.pos.y >= H then
+            b.vel.y = -b.vel.y
+        end
+        gm:fillRect(math.floor(b.pos.x), math.floor(b.pos.y), 2, 2, 0, 200, 255)
+    end
+
+    m:identity():translate(W / 2, H / 2):rotate(t):scale(1 + math.sin(t * 2) * 0.3)
+    m:transformPoints(star, screen)
+    for i = 0, N - 1 do
+        gm:setPixel(math.floor(screen:get(0, i)), math.floor(screen:get(1, i)), 255, 255, 0, 255)
+    end
+end
@@ -0,0 +1,46 @@
+-- a thousand boxes bouncing around, turning red while they touch another one
+local W, H = gm.width, gm.height
+local N, SIZE = 1000, 4
+local sh = gm.newSpatialHash(SIZE * 2)
+
+local boxes = {}
+for i = 1, N do
+    local b = {
+        pos = gm.vec2(math.random(0, W - SIZE), math.random(0, H - SIZE)),
+        vel = gm.vec2(1, 0):rotate(math.random() * 2 * math.pi):scale(20 + math.random() * 30),
+    }
+    b.handle = sh:insert(b.pos.x, b.pos.y, SIZE, SIZE)
+    boxes[b.handle] = b
+end
+
+local pairs_out = {}
+local touching = {}
+
+function draw(dt)
+    gm:clear(0, 0, 0, 255)
+
+    for _, b in pairs(boxes) do
+        b.pos:addScaled(b.vel, dt / 1000)
+        if b.pos.x < 0 or b.pos.x > W - SIZE then
+            b.vel.x = -b.vel.x
+        end
+        if b.pos.y < 0 or b.pos.y > H - SIZE then
+            b.vel.y = -b.vel.y
+        end
+        sh:move(b.handle, b.pos.x, b.pos.y)
+        touching[b.handle] = false
+    end
+
+    local _, n = sh:overlaps(pairs_out)
+    for i = 1, n * 2 do
+        touching[pairs_out[i]] = true
+    end
+
+    for handle, b in pairs(boxes) do
+        if touching[handle] then
+            gm:fillRect(math.floor(b.pos.x), math.floor(b.pos.y), SIZE, SIZE, 255, 64, 64)
+        else
+            gm:fillRect(math.floor(b.pos.x), math.floor(b.pos.y), SIZE, SIZE, 64, 128, 255)
+        end
+    end
+end
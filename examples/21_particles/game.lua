@@ -0,0 +1,30 @@
+-- a fountain of 100k particles, with sparks bursting where the mouse is clicked
+local W, H = gm.width, gm.height
+
+local fountain = gm.newParticles(100000)
+fountain:setEmitter(W / 2, H - 10, 40000)
+fountain:setDirection(-math.pi / 2, 0.5)
+fountain:setSpeed(80, 160)
+fountain:setLife(1.5, 2.5)
+fountain:setGravity(0, 120)
+fountain:setColors(gm.rgba(80, 160, 255, 255), gm.rgba(20, 40, 255, 0))
+fountain:setBlend("add")
+
+local sparks = gm.newParticles(10000)
+sparks:setSpeed(10, 90)
+sparks:setLife(0.3, 1.0)
+sparks:setDrag(2)
+sparks:setColors(gm.rgba(255, 255, 128, 255), gm.rgba(255, 64, 0, 0))
+
+function draw(dt)
+    gm:clear(0, 0, 0, 255)
+
+    if gm.mouse.left then
+        sparks:emit(200, gm.mouse.x, gm.mouse.y)
+    end
+
+    fountain:update(dt)
+    sparks:update(dt)
+    gm:drawParticles(fountain)
+    gm:drawParticles(sparks)
+end
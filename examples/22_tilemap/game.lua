@@ -0,0 +1,46 @@
+-- a 512 x 512 tile world scrolled with the arrow keys, with tiles drawn into a canvas
+local W, H = gm.width, gm.height
+local TILE = 8
+
+-- four tiles side by side: water, sand, grass, rock
+local tileset = gm.newCanvas(TILE * 4, TILE)
+gm:setTarget(tileset)
+local colors = {{20, 60, 160}, {200, 180, 100}, {40, 140, 50}, {110, 110, 110}}
+for i, c in ipairs(colors) do
+    gm:fillRect((i - 1) * TILE, 0, TILE, TILE, c[1], c[2], c[3])
+    gm:fillRect((i - 1) * TILE + 2, 2, 2, 2, c[1] + 30, c[2] + 30, c[3] + 30)
+end
+gm:setTarget()
+
+local MAP = 512
+local map = gm.newTilemap(tileset, MAP, MAP, TILE)
+local tiles = gm.array("u8", MAP, MAP)
+for y = 0, MAP - 1 do
+    for x = 0, MAP - 1 do
+        local v = math.sin(x * 0.05) + math.cos(y * 0.07) + math.sin((x + y) * 0.02)
+        tiles:set(x, y, v < -0.5 and 1 or v < 0 and 2 or v < 1.2 and 3 or 4)
+    end
+end
+map:load(tiles)
+
+local camX, camY = 0, 0
+local SPEED = 0.2
+
+function draw(dt)
+    if gm:keyDown("left") then camX = camX - SPEED * dt end
+    if gm:keyDown("right") then camX = camX + SPEED * dt end
+    if gm:keyDown("up") then camY = camY - SPEED * dt end
+    if gm:keyDown("down") then camY = camY + SPEED * dt end
+    camX = math.max(0, math.min(camX, MAP * TILE - W))
+    camY = math.max(0, math.min(camY, MAP * TILE - H))
+
+    -- clicking turns a tile into rock, only its chunk is drawn again
+    if gm.mouse.left then
+        local tx = (gm.mouse.x + math.floor(camX)) // TILE
+        local ty = (gm.mouse.y + math.floor(camY)) // TILE
+        map:set(tx, ty, 4)
+    end
+
+    gm:clear(0, 0, 0, 255)
+    gm:drawTilemap(map, -camX, -camY)
+end
@@ -0,0 +1,36 @@
+-- post-processing: keys 1 to 5 toggle scanlines, vignette, crt, bloom and a 4 colour palette
+local W, H = gm.width, gm.height
+
+local effects = {"scanlines", "vignette", "crt", "bloom", "palette"}
+local on = {}
+local gameboy = {
+    gm.rgba(15, 56, 15), gm.rgba(48, 98, 48), gm.rgba(139, 172, 15), gm.rgba(155, 188, 15),
+}
+
+local t = 0
+
+function draw(dt)
+    for i, name in ipairs(effects) do
+        if gm:keyPressed(tostring(i)) then
+            on[name] = not on[name]
+            gm.setPostEffect(name, on[name] and (name == "palette" and gameboy or true))
+        end
+    end
+    if gm:keyPressed("0") then
+        on = {}
+        gm.setPostEffect()
+    end
+
+    t = t + dt / 1000
+    gm:clear(10, 10, 30, 255)
+    for i = 0, 15 do
+        local x = math.floor(W / 2 + math.cos(t + i * 0.4) * W * 0.35)
+        local y = math.floor(H / 2 + math.sin(t * 1.3 + i * 0.4) * H * 0.35)
+        gm:fillRect(x - 4, y - 4, 8, 8, 255, 120 + i * 8, 40, 255)
+    end
+    gm:fillRect(0, H - 12, W, 12, 40, 40, 80, 255)
+
+    if gm:keyPressed("p") then
+        print(string.format("composite %.3f ms", gm.postStats()))
+    end
+end
@@ -0,0 +1,43 @@
+-- assets loaded in the background; edit level.txt while this runs and it is reloaded
+local atlas = gm.loadAsync("../14_sprites/sprites.bmp")
+local level = gm.loadAsync("level.txt")
+
+local TILE = 8
+local rows, version = {}, 0
+
+local function parse(text)
+    rows = {}
+    for line in text:gmatch("[^\n]+") do
+        rows[#rows + 1] = line
+    end
+end
+
+function draw(dt)
+    gm:clear(0, 0, 20)
+
+    if not (atlas:ready() and level:ready()) then
+        -- the frame goes on while the loader threads work
+        local queued, live = gm.assetStats()
+        gm:fillRect(10, 10, 10 + queued * 20, 4, 200, 200, 200, 255)
+        return
+    end
+
+    if level:version() ~= version then
+        version = level:version()
+        parse(level:data())
+    end
+
+    local img = atlas:image()
+    for y, line in ipairs(rows) do
+        for x = 1, #line do
+            local c = line:sub(x, x)
+            local px, py = (x - 1) * TILE, (y - 1) * TILE
+            if c == "#" then
+                gm:fillRect(px, py, TILE, TILE, 90, 90, 120, 255)
+            elseif c:match("%d") then
+                local frame = tonumber(c) - 1
+                gm:drawImage(img, px, py, (frame % 4) * 8, 0, 8, 8)
+            end
+        end
+    end
+end
@@ -0,0 +1,596 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_array.h"
+#include "gm_lua.h"
+
+#define GM_ARRAY_MAX_PALETTE 256
+
+static const char *gm_array_types[] = {"u8", "i32", "f32", "f64", NULL};
+
+typedef enum
+{
+    GM_ARRAY_OP_ADD,
+    GM_ARRAY_OP_MUL,
+    GM_ARRAY_OP_MIN,
+    GM_ARRAY_OP_MAX,
+    GM_ARRAY_OP_CLAMP,
+    GM_ARRAY_OP_ABS,
+    GM_ARRAY_OP_THRESHOLD
+} gm_array_op_t;
+
+static const char *gm_array_ops[] = {"add", "mul", "min", "max", "clamp", "abs", "threshold", NULL};
+
+int gm_array_init(gm_array_ctx_t **ctx, SDL_Renderer *renderer)
+{
+    (*ctx) = (gm_array_ctx_t *)calloc(sizeof(gm_array_ctx_t), 1);
+    if ((*ctx) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_array_ctx_t.\n");
+        return 1;
+    }
+
+    (*ctx)->renderer = renderer;
+    return 0;
+}
+
+void gm_array_shutdown(gm_array_ctx_t *ctx)
+{
+    if (ctx)
+    {
+        free(ctx);
+    }
+}
+
+size_t gm_array_elem_size(gm_array_type_t type)
+{
+    switch (type)
+    {
+    case GM_ARRAY_U8:
+        return sizeof(uint8_t);
+    case GM_ARRAY_I32:
+        return sizeof(int32_t);
+    case GM_ARRAY_F32:
+        return sizeof(float);
+    default:
+        return sizeof(double);
+    }
+}
+
+// stores saturate instead of wrapping, NaN becomes 0 in the integer types
+static inline uint8_t gm_array_to_u8(double v)
+{
+    return (v >= 255.0) ? 255 : (v > 0.0) ? (uint8_t)v : 0;
+}
+
+static inline int32_t gm_array_to_i32(double v)
+{
+    return (v >= 2147483647.0) ? INT32_MAX : (v <= -2147483648.0) ? INT32_MIN : (v == v) ? (int32_t)v : 0;
+}
+
+#define gm_array_to_f32(v) ((float)(v))
+#define gm_array_to_f64(v) ((double)(v))
+
+static inline double gm_array_load(const gm_array_t *arr, size_t i)
+{
+    switch (arr->type)
+    {
+    case GM_ARRAY_U8:
+        return (double)((const uint8_t *)arr->data)[i];
+    case GM_ARRAY_I32:
+        return (double)((const int32_t *)arr->data)[i];
+    case GM_ARRAY_F32:
+        return (double)((const float *)arr->data)[i];
+    default:
+        return ((const double *)arr->data)[i];
+    }
+}
+
+static inline void gm_array_store(gm_array_t *arr, size_t i, double v)
+{
+    switch (arr->type)
+    {
+    case GM_ARRAY_U8:
+        ((uint8_t *)arr->data)[i] = gm_array_to_u8(v);
+        break;
+    case GM_ARRAY_I32:
+        ((int32_t *)arr->data)[i] = gm_array_to_i32(v);
+        break;
+    case GM_ARRAY_F32:
+        ((float *)arr->data)[i] = (float)v;
+        break;
+    default:
+        ((double *)arr->data)[i] = v;
+        break;
+    }
+}
+
+// Runs BODY(T, TO) with the element type and its saturating conversion,
+// so bulk loops are compiled once per type instead of switching per element.
+#define GM_ARRAY_DISPATCH(arr, BODY)              \
+    switch ((arr)->type)                          \
+    {                                             \
+    case GM_ARRAY_U8:                             \
+        BODY(uint8_t, gm_array_to_u8);            \
+        break;                                    \
+    case GM_ARRAY_I32:                            \
+        BODY(int32_t, gm_array_to_i32);           \
+        break;                                    \
+    case GM_ARRAY_F32:                            \
+        BODY(float, gm_array_to_f32);             \
+        break;                                    \
+    default:                                      \
+        BODY(double, gm_array_to_f64);            \
+        break;                                    \
+    }
+
+gm_array_t *gm_array_push(lua_State *L, gm_array_type_t type, int w, int h, void *data)
+{
+    gm_array_t *arr = (gm_array_t *)lua_newuserdatauv(L, sizeof(gm_array_t), 0);
+    memset(arr, 0, sizeof(gm_array_t));
+    luaL_setmetatable(L, GM_ARRAY_MT);
+
+    size_t count = (size_t)w * (size_t)h;
+    if (data == NULL)
+    {
+        data = calloc(count, gm_array_elem_size(type));
+        if (data == NULL)
+        {
+            return NULL;
+        }
+    }
+    arr->type = type;
+    arr->w = w;
+    arr->h = h;
+    arr->count = count;
+    arr->data = data;
+    return arr;
+}
+
+gm_array_t *gm_array_check(lua_State *L, int idx)
+{
+    gm_array_t *arr = (gm_array_t *)luaL_checkudata(L, idx, GM_ARRAY_MT);
+    luaL_argcheck(L, arr->data != NULL, idx, "array has been handed off");
+    return arr;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_array_ctx_t *gm_array_upvalue(lua_State *L)
+{
+    return (gm_array_ctx_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// gm.array(type, w [, h]), zero filled
+static int gm_array_lua_new(lua_State *L)
+{
+    int type = luaL_checkoption(L, 1, NULL, gm_array_types);
+    lua_Integer w = luaL_checkinteger(L, 2);
+    lua_Integer h = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, w > 0 && w <= GM_ARRAY_MAX_SIZE, 2, "width out of range");
+    luaL_argcheck(L, h > 0 && h <= GM_ARRAY_MAX_SIZE, 3, "height out of range");
+    luaL_argcheck(L, w * h <= GM_ARRAY_MAX_COUNT, 3, "array too large");
+
+    if (gm_array_push(L, (gm_array_type_t)type, (int)w, (int)h, NULL) == NULL)
+    {
+        return luaL_error(L, "could not allocate a %dx%d array", (int)w, (int)h);
+    }
+    return 1;
+}
+
+static int gm_array_lua_gc(lua_State *L)
+{
+    gm_array_t *arr = (gm_array_t *)luaL_checkudata(L, 1, GM_ARRAY_MT);
+    free(arr->data);
+    arr->data = NULL;
+    if (arr->texture)
+    {
+        SDL_DestroyTexture(arr->texture);
+        arr->texture = NULL;
+    }
+    return 0;
+}
+
+static size_t gm_array_check_index(lua_State *L, const gm_array_t *arr, int idx)
+{
+    lua_Integer x = luaL_checkinteger(L, idx);
+    lua_Integer y = luaL_checkinteger(L, idx + 1);
+    luaL_argcheck(L, x >= 0 && x < arr->w, idx, "x out of range");
+    luaL_argcheck(L, y >= 0 && y < arr->h, idx + 1, "y out of range");
+    return (size_t)y * (size_t)arr->w + (size_t)x;
+}
+
+static void gm_array_push_value(lua_State *L, const gm_array_t *arr, size_t i)
+{
+    if (arr->type == GM_ARRAY_U8 || arr->type == GM_ARRAY_I32)
+    {
+        lua_pushinteger(L, (lua_Integer)gm_array_load(arr, i));
+    }
+    else
+    {
+        lua_pushnumber(L, (lua_Number)gm_array_load(arr, i));
+    }
+}
+
+// arr:get(x [, y]), 0-based like canvas coordinates
+static int gm_array_lua_get(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    if (lua_gettop(L) < 3)
+    {
+        lua_settop(L, 2);
+        lua_pushinteger(L, 0);
+    }
+    gm_array_push_value(L, arr, gm_array_check_index(L, arr, 2));
+    return 1;
+}
+
+// arr:set(x, v) or arr:set(x, y, v)
+static int gm_array_lua_set(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    if (lua_gettop(L) < 4)
+    {
+        lua_pushinteger(L, 0);
+        lua_insert(L, 3);
+    }
+    size_t i = gm_array_check_index(L, arr, 2);
+    gm_array_store(arr, i, (double)luaL_checknumber(L, 4));
+    return 0;
+}
+
+static int gm_array_lua_width(lua_State *L)
+{
+    lua_pushinteger(L, gm_array_check(L, 1)->w);
+    return 1;
+}
+
+static int gm_array_lua_height(lua_State *L)
+{
+    lua_pushinteger(L, gm_array_check(L, 1)->h);
+    return 1;
+}
+
+static int gm_array_lua_type(lua_State *L)
+{
+    lua_pushstring(L, gm_array_types[gm_array_check(L, 1)->type]);
+    return 1;
+}
+
+static int gm_array_lua_len(lua_State *L)
+{
+    gm_array_t *arr = (gm_array_t *)luaL_checkudata(L, 1, GM_ARRAY_MT);
+    lua_pushinteger(L, (lua_Integer)(arr->data ? arr->count : 0));
+    return 1;
+}
+
+// arr:fill(v)
+static int gm_array_lua_fill(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    double v = (double)luaL_checknumber(L, 2);
+
+#define GM_ARRAY_FILL(T, TO)                    \
+    {                                           \
+        T *d = (T *)arr->data;                  \
+        T value = TO(v);                        \
+        for (size_t i = 0; i < arr->count; i++) \
+        {                                       \
+            d[i] = value;                       \
+        }                                       \
+    }
+    GM_ARRAY_DISPATCH(arr, GM_ARRAY_FILL)
+#undef GM_ARRAY_FILL
+    return 0;
+}
+
+// arr:copy(src), converting between types when they differ
+static int gm_array_lua_copy(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    gm_array_t *src = gm_array_check(L, 2);
+    luaL_argcheck(L, src->count == arr->count, 2, "arrays differ in size");
+
+    if (src->type == arr->type)
+    {
+        memmove(arr->data, src->data, arr->count * gm_array_elem_size(arr->type));
+        return 0;
+    }
+    for (size_t i = 0; i < arr->count; i++)
+    {
+        gm_array_store(arr, i, gm_array_load(src, i));
+    }
+    return 0;
+}
+
+static inline double gm_array_apply(gm_array_op_t op, double v, double a, double b)
+{
+    switch (op)
+    {
+    case GM_ARRAY_OP_ADD:
+        return v + a;
+    case GM_ARRAY_OP_MUL:
+        return v * a;
+    case GM_ARRAY_OP_MIN:
+        return (v < a) ? v : a;
+    case GM_ARRAY_OP_MAX:
+        return (v > a) ? v : a;
+    case GM_ARRAY_OP_CLAMP:
+        return (v < a) ? a : (v > b) ? b : v;
+    case GM_ARRAY_OP_ABS:
+        return (v < 0.0) ? -v : v;
+    default:
+        return (v >= a) ? 1.0 : 0.0;
+    }
+}
+
+// arr:map(op [, a [, b]]) applies a built-in op to every element in place
+static int gm_array_lua_map(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    gm_array_op_t op = (gm_array_op_t)luaL_checkoption(L, 2, NULL, gm_array_ops);
+    double a = (double)luaL_optnumber(L, 3, 0.0);
+    double b = (double)luaL_optnumber(L, 4, 0.0);
+
+#define GM_ARRAY_MAP(T, TO)                                    \
+    {                                                          \
+        T *d = (T *)arr->data;                                 \
+        for (size_t i = 0; i < arr->count; i++)                \
+        {                                                      \
+            d[i] = TO(gm_array_apply(op, (double)d[i], a, b)); \
+        }                                                      \
+    }
+    GM_ARRAY_DISPATCH(arr, GM_ARRAY_MAP)
+#undef GM_ARRAY_MAP
+    return 0;
+}
+
+// arr:sum()
+static int gm_array_lua_sum(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    double sum = 0.0;
+
+#define GM_ARRAY_SUM(T, TO)                     \
+    {                                           \
+        const T *d = (const T *)arr->data;      \
+        for (size_t i = 0; i < arr->count; i++) \
+        {                                       \
+            sum += (double)d[i];                \
+        }                                       \
+    }
+    GM_ARRAY_DISPATCH(arr, GM_ARRAY_SUM)
+#undef GM_ARRAY_SUM
+
+    lua_pushnumber(L, (lua_Number)sum);
+    return 1;
+}
+
+// arr:convolve(src [, kernel [, "wrap"]]) writes the 3x3 convolution of src into arr.
+// The default kernel counts the 8 neighbours; outside cells are 0 unless wrapping.
+static int gm_array_lua_convolve(lua_State *L)
+{
+    gm_array_t *arr = gm_array_check(L, 1);
+    gm_array_t *src = gm_array_check(L, 2);
+    luaL_argcheck(L, src != arr, 2, "source and destination must differ");
+    luaL_argcheck(L, src->w == arr->w && src->h == arr->h, 2, "arrays differ in size");
+
+    double k[9] = {1, 1, 1, 1, 0, 1, 1, 1, 1};
+    if (!lua_isnoneornil(L, 3))
+    {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        for (int i = 0; i < 9; i++)
+        {
+            lua_rawgeti(L, 3, i + 1);
+            k[i] = (double)luaL_checknumber(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    bool wrap = !lua_isnoneornil(L, 4) && SDL_strcmp(luaL_checkstring(L, 4), "wrap") == 0;
+
+    int w = arr->w;
+    int h = arr->h;
+
+    // compiled for every source and destination type pair
+#define GM_ARRAY_CONVOLVE(S, T, TO)                                         \
+    {                                                                       \
+        const S *s = (const S *)src->data;                                  \
+        T *d = (T *)arr->data;                                              \
+        for (int y = 0; y < h; y++)                                         \
+        {                                                                   \
+            for (int x = 0; x < w; x++)                                     \
+            {                                                               \
+                double sum = 0.0;                                           \
+                for (int ky = -1; ky <= 1; ky++)                            \
+                {                                                           \
+                    int sy = y + ky;                                        \
+                    if (sy < 0 || sy >= h)                                  \
+                    {                                                       \
+                        if (!wrap)                                          \
+                        {                                                   \
+                            continue;                                       \
+                        }                                                   \
+                        sy = (sy + h) % h;                                  \
+                    }                                                       \
+                    const S *srow = s + (size_t)sy * (size_t)w;             \
+                    for (int kx = -1; kx <= 1; kx++)                        \
+                    {                                                       \
+                        double weight = k[(ky + 1) * 3 + kx + 1];           \
+                        int sx = x + kx;                                    \
+                        if (weight == 0.0)                                  \
+                        {                                                   \
+                            continue;                                       \
+                        }                                                   \
+                        if (sx < 0 || sx >= w)                              \
+                        {                                                   \
+                            if (!wrap)                                      \
+                            {                                               \
+                                continue;                                   \
+                            }                                               \
+                            sx = (sx + w) % w;                              \
+                        }                                                   \
+                        sum += weight * (double)srow[sx];                   \
+                    }                                                       \
+                }                                                           \
+                d[(size_t)y * (size_t)w + (size_t)x] = TO(sum);             \
+            }                                                               \
+        }                                                                   \
+    }
+#define GM_ARRAY_CONVOLVE_TO(T, TO)                     \
+    switch (src->type)                                  \
+    {                                                   \
+    case GM_ARRAY_U8:                                   \
+        GM_ARRAY_CONVOLVE(uint8_t, T, TO);              \
+        break;                                          \
+    case GM_ARRAY_I32:                                  \
+        GM_ARRAY_CONVOLVE(int32_t, T, TO);              \
+        break;                                          \
+    case GM_ARRAY_F32:                                  \
+        GM_ARRAY_CONVOLVE(float, T, TO);                \
+        break;                                          \
+    default:                                            \
+        GM_ARRAY_CONVOLVE(double, T, TO);               \
+        break;                                          \
+    }
+    GM_ARRAY_DISPATCH(arr, GM_ARRAY_CONVOLVE_TO)
+#undef GM_ARRAY_CONVOLVE_TO
+#undef GM_ARRAY_CONVOLVE
+    return 0;
+}
+
+// Reads a palette of packed colours, from an i32 array or a table of integers.
+static const uint32_t *gm_array_check_palette(lua_State *L, int idx, uint32_t *buf, int *n)
+{
+    if (lua_isuserdata(L, idx))
+    {
+        gm_array_t *pal = gm_array_check(L, idx);
+        luaL_argcheck(L, pal->type == GM_ARRAY_I32, idx, "palette array must be i32");
+        *n = (int)pal->count;
+        return (const uint32_t *)pal->data;
+    }
+
+    luaL_checktype(L, idx, LUA_TTABLE);
+    *n = (int)lua_rawlen(L, idx);
+    luaL_argcheck(L, *n > 0 && *n <= GM_ARRAY_MAX_PALETTE, idx, "palette needs 1-256 colours");
+    for (int i = 0; i < *n; i++)
+    {
+        lua_rawgeti(L, idx, i + 1);
+        buf[i] = (uint32_t)luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+    }
+    return buf;
+}
+
+// gm:drawArray(arr, palette [, x, y [, scale]])
+// Integer values index the palette from 0, values outside it are transparent.
+// Float values from 0 to 1 are spread over the whole palette, NaN counts as 0.
+static int gm_array_lua_draw(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_array_ctx_t *ctx = gm_array_upvalue(L);
+    gm_array_t *arr = gm_array_check(L, 2);
+    uint32_t buf[GM_ARRAY_MAX_PALETTE];
+    int n = 0;
+    const uint32_t *pal = gm_array_check_palette(L, 3, buf, &n);
+    luaL_argcheck(L, n > 0, 3, "palette is empty");
+    float scale = (float)luaL_optnumber(L, 6, 1.0);
+
+    if (arr->texture == NULL)
+    {
+        arr->texture = SDL_CreateTexture(ctx->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, arr->w, arr->h);
+        if (arr->texture == NULL)
+        {
+            return luaL_error(L, "could not create array texture: %s", SDL_GetError());
+        }
+        SDL_SetTextureScaleMode(arr->texture, SDL_SCALEMODE_NEAREST);
+        SDL_SetTextureBlendMode(arr->texture, SDL_BLENDMODE_BLEND);
+    }
+
+    void *pixels = NULL;
+    int pitch = 0;
+    if (!SDL_LockTexture(arr->texture, NULL, &pixels, &pitch))
+    {
+        return luaL_error(L, "could not lock array texture: %s", SDL_GetError());
+    }
+
+    bool integer = (arr->type == GM_ARRAY_U8 || arr->type == GM_ARRAY_I32);
+    double top = (double)(n - 1);
+#define GM_ARRAY_DRAW(T, TO)                                                            \
+    {                                                                                   \
+        const T *d = (const T *)arr->data;                                              \
+        for (int y = 0; y < arr->h; y++)                                                \
+        {                                                                               \
+            uint32_t *row = (uint32_t *)((uint8_t *)pixels + (size_t)y * (size_t)pitch); \
+            const T *src = d + (size_t)y * (size_t)arr->w;                              \
+            for (int x = 0; x < arr->w; x++)                                            \
+            {                                                                           \
+                double v = (double)src[x];                                              \
+                if (integer)                                                            \
+                {                                                                       \
+                    row[x] = (v >= 0.0 && v < (double)n) ? pal[(int)v] : 0u;            \
+                }                                                                       \
+                else                                                                    \
+                {                                                                       \
+                    double t = !(v > 0.0) ? 0.0 : (v > 1.0) ? 1.0 : v;                  \
+                    row[x] = pal[(int)(t * top + 0.5)];                                 \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+    }
+    GM_ARRAY_DISPATCH(arr, GM_ARRAY_DRAW)
+#undef GM_ARRAY_DRAW
+    SDL_UnlockTexture(arr->texture);
+
+    SDL_FRect dst = {
+        .x = (float)luaL_optnumber(L, 4, 0.0),
+        .y = (float)luaL_optnumber(L, 5, 0.0),
+        .w = (float)arr->w * scale,
+        .h = (float)arr->h * scale};
+    SDL_RenderTexture(ctx->renderer, arr->texture, NULL, &dst);
+    return 0;
+}
+
+void gm_array_register_lua(gm_array_ctx_t *ctx, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"get", gm_array_lua_get},
+        {"set", gm_array_lua_set},
+        {"width", gm_array_lua_width},
+        {"height", gm_array_lua_height},
+        {"type", gm_array_lua_type},
+        {"fill", gm_array_lua_fill},
+        {"copy", gm_array_lua_copy},
+        {"map", gm_array_lua_map},
+        {"sum", gm_array_lua_sum},
+        {"convolve", gm_array_lua_convolve},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"array", gm_array_lua_new},
+        {"drawArray", gm_array_lua_draw},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_ARRAY_MT);
+    lua_pushcfunction(L, gm_array_lua_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, gm_array_lua_len);
+    lua_setfield(L, -2, "__len");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, ctx);
+    luaL_setfuncs(L, funcs, 1);
+
+    // states without a renderer (workers) get the arrays but cannot draw them
+    if (ctx == NULL)
+    {
+        lua_pushnil(L);
+        lua_setfield(L, -2, "drawArray");
+    }
+    lua_pop(L, 1);
+}
@@ -0,0 +1,55 @@
+#ifndef __GM_ARRAY_H__
+#define __GM_ARRAY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#define GM_ARRAY_MT "gm.array"
+
+// upper bound for one side, and for the element count
+#define GM_ARRAY_MAX_SIZE 16384
+#define GM_ARRAY_MAX_COUNT (64 * 1024 * 1024)
+
+typedef enum
+{
+    GM_ARRAY_U8,
+    GM_ARRAY_I32,
+    GM_ARRAY_F32,
+    GM_ARRAY_F64
+} gm_array_type_t;
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+} gm_array_ctx_t;
+
+// Lua userdata behind gm.array, a w x h grid of numbers in one malloc'd block.
+// The block can be detached and handed to another array without copying.
+typedef struct
+{
+    gm_array_type_t type;
+    int w;
+    int h;
+    size_t count;
+    void *data;
+
+    // created by the first gm:drawArray, freed with the array
+    SDL_Texture *texture;
+} gm_array_t;
+
+int gm_array_init(gm_array_ctx_t **ctx, SDL_Renderer *renderer);
+void gm_array_shutdown(gm_array_ctx_t *ctx);
+
+size_t gm_array_elem_size(gm_array_type_t type);
+
+// Pushes a new array owning data (malloc'd, or NULL to allocate a zeroed one), NULL on failure.
+gm_array_t *gm_array_push(lua_State *L, gm_array_type_t type, int w, int h, void *data);
+gm_array_t *gm_array_check(lua_State *L, int idx);
+
+// Adds gm.array and gm:drawArray to the game API, ctx may be NULL for a state that never draws.
+void gm_array_register_lua(gm_array_ctx_t *ctx, lua_State *L);
+
+#endif // __GM_ARRAY_H__
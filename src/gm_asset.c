@@ -0,0 +1,595 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_asset.h"
+#include "gm_lua.h"
+#include "gm_sprite.h"
+#include "gm_trace.h"
+#include "gm_util.h"
+
+// registry table of live handles, by path and by asset pointer, with weak values
+#define GM_ASSET_HANDLES "gm.assets"
+
+// Lua userdata behind gm.loadAsync. User value 1 is the gm.image once an image is
+// loaded, user value 2 the contents of a data file.
+typedef struct
+{
+    gm_asset_t *asset;
+} gm_asset_handle_t;
+
+static void gm_asset_unref(gm_asset_t *a)
+{
+    if (--a->refs > 0)
+    {
+        return;
+    }
+    if (a->surface)
+    {
+        SDL_DestroySurface(a->surface);
+    }
+    SDL_free(a->data);
+    free(a);
+}
+
+//----------------------------------------------------------------------------
+// Loader threads
+//----------------------------------------------------------------------------
+
+// Reads and decodes one file, without touching the renderer or Lua.
+static void gm_asset_load(gm_asset_mgr_t *mgr, gm_asset_t *a)
+{
+    uint64_t span = gm_trace_begin();
+    a->load_error[0] = '\0';
+
+    // a packed copy wins over the file on disk, like everywhere else, and is never watched
+    size_t packed = 0;
+    a->loaded_mtime = gm_pack_find(mgr->pack, a->path, &packed) ? 0 : get_file_mtime(a->path);
+
+    if (a->kind == GM_ASSET_IMAGE)
+    {
+        a->surface = gm_sprite_load_surface(mgr->pack, a->path);
+        if (a->surface == NULL)
+        {
+            SDL_snprintf(a->load_error, sizeof(a->load_error), "could not load image %s", a->path);
+        }
+    }
+    else
+    {
+        SDL_IOStream *io = gm_pack_open_io(mgr->pack, a->path);
+        if (io == NULL)
+        {
+            io = SDL_IOFromFile(a->path, "rb");
+        }
+        a->data = io ? SDL_LoadFile_IO(io, &a->size, true) : NULL;
+        if (a->data == NULL)
+        {
+            SDL_snprintf(a->load_error, sizeof(a->load_error), "could not read %s: %s", a->path, SDL_GetError());
+        }
+    }
+    gm_trace_end("asset_load", span);
+}
+
+static void gm_asset_push_done(gm_asset_mgr_t *mgr, gm_asset_t *a)
+{
+    a->next = NULL;
+    if (mgr->done_tail)
+    {
+        mgr->done_tail->next = a;
+    }
+    else
+    {
+        mgr->done_head = a;
+    }
+    mgr->done_tail = a;
+}
+
+static int gm_asset_thread(void *data)
+{
+    gm_asset_mgr_t *mgr = (gm_asset_mgr_t *)data;
+    gm_trace_thread_name("asset loader");
+    for (;;)
+    {
+        SDL_LockMutex(mgr->lock);
+        while (mgr->queue_head == NULL && !mgr->quit)
+        {
+            SDL_WaitCondition(mgr->wake, mgr->lock);
+        }
+        if (mgr->quit)
+        {
+            SDL_UnlockMutex(mgr->lock);
+            break;
+        }
+        gm_asset_t *a = mgr->queue_head;
+        mgr->queue_head = a->next;
+        if (mgr->queue_head == NULL)
+        {
+            mgr->queue_tail = NULL;
+        }
+        mgr->queued--;
+        SDL_UnlockMutex(mgr->lock);
+
+        gm_asset_load(mgr, a);
+
+        SDL_LockMutex(mgr->lock);
+        gm_asset_push_done(mgr, a);
+        SDL_UnlockMutex(mgr->lock);
+    }
+    return 0;
+}
+
+static bool gm_asset_start(gm_asset_mgr_t *mgr)
+{
+    if (mgr->thread_count > 0)
+    {
+        return true;
+    }
+
+    // file reads wait on the disk more than the CPU, a few threads are enough
+    int count = SDL_clamp(SDL_GetNumLogicalCPUCores() - 1, 1, GM_ASSET_MAX_THREADS);
+    for (int i = 0; i < count; i++)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "gm_asset_%d", i);
+        mgr->threads[mgr->thread_count] = SDL_CreateThread(gm_asset_thread, name, mgr);
+        if (mgr->threads[mgr->thread_count] == NULL)
+        {
+            SDL_Log("Could not start asset loader thread %d: %s\n", i, SDL_GetError());
+            break;
+        }
+        mgr->thread_count++;
+    }
+    return mgr->thread_count > 0;
+}
+
+// Hands an asset to the loaders, the load holds a reference until it is finished.
+static void gm_asset_request(gm_asset_mgr_t *mgr, gm_asset_t *a)
+{
+    a->refs++;
+    a->in_flight = true;
+
+    if (!mgr->threaded || !gm_asset_start(mgr))
+    {
+        gm_asset_load(mgr, a);
+        SDL_LockMutex(mgr->lock);
+        gm_asset_push_done(mgr, a);
+        SDL_UnlockMutex(mgr->lock);
+        return;
+    }
+
+    SDL_LockMutex(mgr->lock);
+    a->next = NULL;
+    if (mgr->queue_tail)
+    {
+        mgr->queue_tail->next = a;
+    }
+    else
+    {
+        mgr->queue_head = a;
+    }
+    mgr->queue_tail = a;
+    mgr->queued++;
+    SDL_SignalCondition(mgr->wake);
+    SDL_UnlockMutex(mgr->lock);
+}
+
+//----------------------------------------------------------------------------
+// Manager
+//----------------------------------------------------------------------------
+
+int gm_asset_init(gm_asset_mgr_t **mgr, SDL_Renderer *renderer, const gm_pack_t *pack, bool threaded)
+{
+    (*mgr) = (gm_asset_mgr_t *)calloc(sizeof(gm_asset_mgr_t), 1);
+    if ((*mgr) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_asset_mgr_t.\n");
+        return 1;
+    }
+
+    (*mgr)->renderer = renderer;
+    (*mgr)->pack = pack;
+    (*mgr)->threaded = threaded;
+    (*mgr)->lock = SDL_CreateMutex();
+    (*mgr)->wake = SDL_CreateCondition();
+    if ((*mgr)->lock == NULL || (*mgr)->wake == NULL)
+    {
+        SDL_Log("Could not create the asset loader lock: %s\n", SDL_GetError());
+        return 1;
+    }
+    return 0;
+}
+
+void gm_asset_shutdown(gm_asset_mgr_t *mgr)
+{
+    if (mgr == NULL)
+    {
+        return;
+    }
+
+    if (mgr->lock)
+    {
+        SDL_LockMutex(mgr->lock);
+        mgr->quit = true;
+        SDL_BroadcastCondition(mgr->wake);
+        SDL_UnlockMutex(mgr->lock);
+    }
+    for (int i = 0; i < mgr->thread_count; i++)
+    {
+        SDL_WaitThread(mgr->threads[i], NULL);
+    }
+
+    // loads that never ran or were never picked up still hold their reference
+    while (mgr->queue_head)
+    {
+        gm_asset_t *a = mgr->queue_head;
+        mgr->queue_head = a->next;
+        gm_asset_unref(a);
+    }
+    while (mgr->done_head)
+    {
+        gm_asset_t *a = mgr->done_head;
+        mgr->done_head = a->next;
+        gm_asset_unref(a);
+    }
+
+    if (mgr->wake)
+    {
+        SDL_DestroyCondition(mgr->wake);
+    }
+    if (mgr->lock)
+    {
+        SDL_DestroyMutex(mgr->lock);
+    }
+    free(mgr);
+}
+
+// Pushes the live handle of an asset, or nothing and returns false once it was collected.
+static bool gm_asset_push_handle(lua_State *L, gm_asset_t *a)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, GM_ASSET_HANDLES);
+    lua_rawgetp(L, -1, a);
+    lua_remove(L, -2);
+    if (luaL_testudata(L, -1, GM_ASSET_MT) == NULL)
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+    return true;
+}
+
+// Turns a finished load into the handle's image or string. A failed reload keeps
+// what was loaded before. Returns the bytes uploaded.
+static size_t gm_asset_finish(gm_asset_mgr_t *mgr, lua_State *L, gm_asset_t *a)
+{
+    size_t uploaded = 0;
+    a->in_flight = false;
+    a->mtime = a->loaded_mtime;
+
+    if (gm_asset_push_handle(L, a))
+    {
+        if (a->load_error[0] == '\0' && a->kind == GM_ASSET_IMAGE)
+        {
+            SDL_Texture *texture = gm_sprite_create_texture(mgr->renderer, a->surface, a->path);
+            if (texture)
+            {
+                // a reload swaps the texture inside the same gm.image, so whatever holds it sees the new one
+                lua_getiuservalue(L, -1, 1);
+                gm_image_t *img = (gm_image_t *)luaL_testudata(L, -1, GM_IMAGE_MT);
+                if (img == NULL)
+                {
+                    lua_pop(L, 1);
+                    img = gm_sprite_push_image(L);
+                    lua_pushvalue(L, -1);
+                    lua_setiuservalue(L, -3, 1);
+                }
+                if (img->texture)
+                {
+                    SDL_DestroyTexture(img->texture);
+                }
+                img->texture = texture;
+                img->w = a->surface->w;
+                img->h = a->surface->h;
+                lua_pop(L, 1);
+                uploaded = (size_t)a->surface->pitch * (size_t)a->surface->h;
+            }
+            else
+            {
+                SDL_snprintf(a->load_error, sizeof(a->load_error), "could not create texture for %s", a->path);
+            }
+        }
+        else if (a->load_error[0] == '\0')
+        {
+            lua_pushlstring(L, (const char *)a->data, a->size);
+            lua_setiuservalue(L, -2, 2);
+        }
+        lua_pop(L, 1);
+
+        if (a->load_error[0] == '\0')
+        {
+            a->state = GM_ASSET_READY;
+            a->error[0] = '\0';
+            a->version++;
+        }
+        else
+        {
+            SDL_Log("Asset %s: %s\n", a->path, a->load_error);
+            SDL_strlcpy(a->error, a->load_error, sizeof(a->error));
+            if (a->state != GM_ASSET_READY)
+            {
+                a->state = GM_ASSET_FAILED;
+            }
+        }
+    }
+
+    if (a->surface)
+    {
+        SDL_DestroySurface(a->surface);
+        a->surface = NULL;
+    }
+    SDL_free(a->data);
+    a->data = NULL;
+    a->size = 0;
+    gm_asset_unref(a);
+    return uploaded;
+}
+
+void gm_asset_update(gm_asset_mgr_t *mgr, lua_State *L)
+{
+    uint64_t span = gm_trace_begin();
+    size_t budget = GM_ASSET_UPLOAD_BYTES;
+    for (;;)
+    {
+        SDL_LockMutex(mgr->lock);
+        gm_asset_t *a = mgr->done_head;
+        if (a)
+        {
+            mgr->done_head = a->next;
+            if (mgr->done_head == NULL)
+            {
+                mgr->done_tail = NULL;
+            }
+        }
+        SDL_UnlockMutex(mgr->lock);
+        if (a == NULL)
+        {
+            break;
+        }
+
+        size_t uploaded = gm_asset_finish(mgr, L, a);
+        if (uploaded >= budget)
+        {
+            break;
+        }
+        budget -= uploaded;
+    }
+
+    // files edited on disk go through the loaders again
+    uint64_t now = SDL_GetTicksNS();
+    if (now >= mgr->next_watch_ns)
+    {
+        mgr->next_watch_ns = now + (uint64_t)GM_ASSET_WATCH_MS * SDL_NS_PER_MS;
+        for (gm_asset_t *a = mgr->live; a; a = a->live_next)
+        {
+            if (a->in_flight || a->mtime == 0)
+            {
+                continue;
+            }
+            time_t mtime = get_file_mtime(a->path);
+            if (mtime != 0 && mtime != a->mtime)
+            {
+                SDL_Log("Reloading asset %s\n", a->path);
+                gm_asset_request(mgr, a);
+            }
+        }
+    }
+    gm_trace_end("assets", span);
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_asset_mgr_t *gm_asset_upvalue(lua_State *L)
+{
+    return (gm_asset_mgr_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static gm_asset_t *gm_asset_check(lua_State *L, int idx)
+{
+    return ((gm_asset_handle_t *)luaL_checkudata(L, idx, GM_ASSET_MT))->asset;
+}
+
+// gm.loadAsync(path) starts loading a file and returns its handle at once.
+// PNG and BMP files become images, anything else a string. Loading the same path
+// again while its handle is alive returns that handle.
+static int gm_asset_lua_load(lua_State *L)
+{
+    gm_asset_mgr_t *mgr = gm_asset_upvalue(L);
+    size_t len = 0;
+    const char *path = luaL_checklstring(L, 1, &len);
+    luaL_argcheck(L, len < sizeof(((gm_asset_t *)0)->path), 1, "path too long");
+
+    lua_getfield(L, LUA_REGISTRYINDEX, GM_ASSET_HANDLES);
+    if (lua_getfield(L, -1, path) == LUA_TUSERDATA)
+    {
+        return 1;
+    }
+    lua_pop(L, 1);
+
+    gm_asset_t *a = (gm_asset_t *)calloc(sizeof(gm_asset_t), 1);
+    if (a == NULL)
+    {
+        return luaL_error(L, "out of memory loading %s", path);
+    }
+    SDL_strlcpy(a->path, path, sizeof(a->path));
+    const char *ext = SDL_strrchr(path, '.');
+    a->kind = (ext && (SDL_strcasecmp(ext, ".png") == 0 || SDL_strcasecmp(ext, ".bmp") == 0)) ? GM_ASSET_IMAGE
+                                                                                              : GM_ASSET_DATA;
+    a->state = GM_ASSET_LOADING;
+    a->refs = 1;
+
+    gm_asset_handle_t *h = (gm_asset_handle_t *)lua_newuserdatauv(L, sizeof(gm_asset_handle_t), 2);
+    h->asset = a;
+    luaL_setmetatable(L, GM_ASSET_MT);
+
+    a->live_next = mgr->live;
+    if (mgr->live)
+    {
+        mgr->live->live_prev = a;
+    }
+    mgr->live = a;
+    mgr->live_count++;
+
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -3, path);
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, -3, a);
+
+    gm_asset_request(mgr, a);
+
+    // without loader threads the asset is ready before this returns
+    if (!mgr->threaded)
+    {
+        gm_asset_update(mgr, L);
+    }
+    return 1;
+}
+
+static int gm_asset_lua_gc(lua_State *L)
+{
+    gm_asset_mgr_t *mgr = gm_asset_upvalue(L);
+    gm_asset_handle_t *h = (gm_asset_handle_t *)luaL_checkudata(L, 1, GM_ASSET_MT);
+    gm_asset_t *a = h->asset;
+    if (a == NULL)
+    {
+        return 0;
+    }
+    h->asset = NULL;
+
+    if (a->live_prev)
+    {
+        a->live_prev->live_next = a->live_next;
+    }
+    else
+    {
+        mgr->live = a->live_next;
+    }
+    if (a->live_next)
+    {
+        a->live_next->live_prev = a->live_prev;
+    }
+    mgr->live_count--;
+    gm_asset_unref(a);
+    return 0;
+}
+
+// asset:ready() is true once the file is loaded, and stays true through reloads
+static int gm_asset_lua_ready(lua_State *L)
+{
+    lua_pushboolean(L, gm_asset_check(L, 1)->state == GM_ASSET_READY);
+    return 1;
+}
+
+// asset:state() returns "loading", "ready" or "failed"
+static int gm_asset_lua_state(lua_State *L)
+{
+    static const char *names[] = {"loading", "ready", "failed"};
+    lua_pushstring(L, names[gm_asset_check(L, 1)->state]);
+    return 1;
+}
+
+// asset:error() returns why the last load failed, or nil
+static int gm_asset_lua_error(lua_State *L)
+{
+    gm_asset_t *a = gm_asset_check(L, 1);
+    if (a->error[0] == '\0')
+    {
+        lua_pushnil(L);
+    }
+    else
+    {
+        lua_pushstring(L, a->error);
+    }
+    return 1;
+}
+
+// asset:image() returns the gm.image, nil until it is loaded. Reloads change its
+// texture in place, so it can be kept.
+static int gm_asset_lua_image(lua_State *L)
+{
+    gm_asset_check(L, 1);
+    lua_getiuservalue(L, 1, 1);
+    return 1;
+}
+
+// asset:data() returns the file's contents as a string, nil until it is loaded
+static int gm_asset_lua_data(lua_State *L)
+{
+    gm_asset_check(L, 1);
+    lua_getiuservalue(L, 1, 2);
+    return 1;
+}
+
+// asset:version() counts completed loads, it goes up each time the file is reloaded
+static int gm_asset_lua_version(lua_State *L)
+{
+    lua_pushinteger(L, gm_asset_check(L, 1)->version);
+    return 1;
+}
+
+static int gm_asset_lua_path(lua_State *L)
+{
+    lua_pushstring(L, gm_asset_check(L, 1)->path);
+    return 1;
+}
+
+// gm.assetStats() returns the loads waiting for a thread and the number of live handles
+static int gm_asset_lua_stats(lua_State *L)
+{
+    gm_asset_mgr_t *mgr = gm_asset_upvalue(L);
+    SDL_LockMutex(mgr->lock);
+    int queued = mgr->queued;
+    SDL_UnlockMutex(mgr->lock);
+    lua_pushinteger(L, queued);
+    lua_pushinteger(L, mgr->live_count);
+    return 2;
+}
+
+void gm_asset_register_lua(gm_asset_mgr_t *mgr, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"ready", gm_asset_lua_ready},
+        {"state", gm_asset_lua_state},
+        {"error", gm_asset_lua_error},
+        {"image", gm_asset_lua_image},
+        {"data", gm_asset_lua_data},
+        {"version", gm_asset_lua_version},
+        {"path", gm_asset_lua_path},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"loadAsync", gm_asset_lua_load},
+        {"assetStats", gm_asset_lua_stats},
+        {NULL, NULL}};
+
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushstring(L, "v");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_setfield(L, LUA_REGISTRYINDEX, GM_ASSET_HANDLES);
+
+    // __gc needs the manager too, to leave the watch list
+    luaL_newmetatable(L, GM_ASSET_MT);
+    lua_pushlightuserdata(L, mgr);
+    lua_pushcclosure(L, gm_asset_lua_gc, 1);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, mgr);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
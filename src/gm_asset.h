@@ -0,0 +1,105 @@
+#ifndef __GM_ASSET_H__
+#define __GM_ASSET_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_pack.h"
+
+#define GM_ASSET_MT "gm.asset"
+#define GM_ASSET_MAX_THREADS 4
+
+// decoded pixels uploaded to textures per frame, at least one image always goes
+#define GM_ASSET_UPLOAD_BYTES (4 * 1024 * 1024)
+
+// how often files on disk are checked for changes
+#define GM_ASSET_WATCH_MS 500
+
+typedef enum
+{
+    GM_ASSET_IMAGE,
+    GM_ASSET_DATA
+} gm_asset_kind_t;
+
+typedef enum
+{
+    GM_ASSET_LOADING,
+    GM_ASSET_READY,
+    GM_ASSET_FAILED
+} gm_asset_state_t;
+
+// One file loaded in the background. A loader thread reads and decodes it, the
+// render thread turns the result into a gm.image or a string. Referenced by its
+// Lua handle and by the load in flight, freed when both let go.
+typedef struct gm_asset_t
+{
+    char path[256];
+    gm_asset_kind_t kind;
+    int refs;
+
+    // written by the loader thread, read once the load is back on the render thread
+    SDL_Surface *surface;
+    void *data;
+    size_t size;
+    time_t loaded_mtime;
+    char load_error[128];
+
+    // render thread only
+    gm_asset_state_t state;
+    bool in_flight;
+    uint32_t version;
+    time_t mtime;
+    char error[128];
+
+    // load queue or finished list, an asset is in one at most
+    struct gm_asset_t *next;
+
+    // assets with a live handle, watched for changes
+    struct gm_asset_t *live_prev;
+    struct gm_asset_t *live_next;
+} gm_asset_t;
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+    const gm_pack_t *pack;
+
+    // loads run on the calling thread when the manager has no threads, as in batch renders
+    bool threaded;
+
+    // guards both lists and quit
+    SDL_Mutex *lock;
+    SDL_Condition *wake;
+    gm_asset_t *queue_head;
+    gm_asset_t *queue_tail;
+    gm_asset_t *done_head;
+    gm_asset_t *done_tail;
+    int queued;
+    bool quit;
+
+    SDL_Thread *threads[GM_ASSET_MAX_THREADS];
+    int thread_count;
+
+    gm_asset_t *live;
+    int live_count;
+    uint64_t next_watch_ns;
+} gm_asset_mgr_t;
+
+// threaded is false to load everything at once on the calling thread.
+int gm_asset_init(gm_asset_mgr_t **mgr, SDL_Renderer *renderer, const gm_pack_t *pack, bool threaded);
+
+// Stops the loader threads. Call after the Lua state is closed.
+void gm_asset_shutdown(gm_asset_mgr_t *mgr);
+
+// Uploads what the loaders finished, within the per frame budget, and requeues
+// changed files. Called on the render thread once per frame, before draw.
+void gm_asset_update(gm_asset_mgr_t *mgr, lua_State *L);
+
+// Adds gm.loadAsync(path) and gm.assetStats() to the game API.
+void gm_asset_register_lua(gm_asset_mgr_t *mgr, lua_State *L);
+
+#endif // __GM_ASSET_H__
@@ -0,0 +1,752 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_audio.h"
+#include "gm_trace.h"
+#include "gm_lua.h"
+
+#define GM_AUDIO_RING_MASK (GM_AUDIO_RING_SIZE - 1)
+
+// shortest release, so stopping a voice never clicks
+#define GM_AUDIO_MIN_RELEASE_FRAMES 48
+
+static const char *gm_audio_wave_names[] = {"sine", "square", "triangle", "saw", "noise", NULL};
+
+static void SDLCALL gm_audio_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount);
+
+int gm_audio_init(gm_audio_t **audio, const gm_pack_t *pack, int buffer_frames)
+{
+    (*audio) = (gm_audio_t *)calloc(sizeof(gm_audio_t), 1);
+    if ((*audio) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_audio_t.\n");
+        return 1;
+    }
+
+    gm_audio_t *a = (*audio);
+    a->pack = pack;
+    a->master = 1.0f;
+    a->next_voice_id = 1;
+    for (int i = 0; i < GM_AUDIO_WAVETABLE_SIZE; i++)
+    {
+        a->wavetable[i] = SDL_sinf(2.0f * SDL_PI_F * (float)i / (float)GM_AUDIO_WAVETABLE_SIZE);
+    }
+
+    if (buffer_frames < 0)
+    {
+        SDL_Log("Audio disabled.\n");
+        return 0;
+    }
+
+    // the device buffer size can only be requested through a hint, before the device opens
+    if (buffer_frames > 0)
+    {
+        char frames[16];
+        SDL_snprintf(frames, sizeof(frames), "%d", buffer_frames);
+        SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, frames);
+    }
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO))
+    {
+        SDL_Log("Audio disabled, SDL audio init failed: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_AudioSpec spec;
+    spec.format = SDL_AUDIO_F32;
+    spec.channels = GM_AUDIO_CHANNELS;
+    spec.freq = GM_AUDIO_RATE;
+    a->stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, gm_audio_callback, a);
+    if (a->stream == NULL)
+    {
+        SDL_Log("Audio disabled, could not open playback device: %s\n", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return 0;
+    }
+
+    SDL_AudioSpec device;
+    int frames = 0;
+    if (SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(a->stream), &device, &frames) && device.freq > 0)
+    {
+        a->buffer_frames = frames;
+        a->period_ns = (uint64_t)frames * SDL_NS_PER_SECOND / (uint64_t)device.freq;
+        SDL_Log("Audio: %d Hz device, %d frame buffer (%.1f ms)\n",
+                device.freq, a->buffer_frames, (double)a->period_ns / 1e6);
+    }
+    else
+    {
+        SDL_Log("Audio: device format unknown, underruns are not counted\n");
+    }
+
+    // the trace buffer is allocated here, the audio thread never allocates
+    a->trace = gm_trace_thread_reserve("audio");
+    SDL_ResumeAudioStreamDevice(a->stream);
+    return 0;
+}
+
+void gm_audio_shutdown(gm_audio_t *audio)
+{
+    if (audio == NULL)
+    {
+        return;
+    }
+
+    if (audio->stream)
+    {
+        // destroying the stream waits for a running callback, voices and samples are free after this
+        SDL_DestroyAudioStream(audio->stream);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        SDL_Log("Audio: %u callbacks, %u underruns, %u slow mixes, %u dropped commands\n",
+                SDL_GetAtomicU32(&audio->callbacks), SDL_GetAtomicU32(&audio->underruns),
+                SDL_GetAtomicU32(&audio->slow_mixes), SDL_GetAtomicU32(&audio->dropped));
+    }
+
+    for (int i = 0; i < audio->sample_count; i++)
+    {
+        SDL_free(audio->samples[i].data);
+    }
+    free(audio);
+}
+
+bool gm_audio_send(gm_audio_t *audio, const gm_audio_cmd_t *cmd)
+{
+    if (audio->stream == NULL)
+    {
+        return false;
+    }
+
+    uint32_t w = SDL_GetAtomicU32(&audio->write);
+    uint32_t r = SDL_GetAtomicU32(&audio->read);
+    if (w - r >= GM_AUDIO_RING_SIZE)
+    {
+        SDL_SetAtomicU32(&audio->dropped, SDL_GetAtomicU32(&audio->dropped) + 1);
+        return false;
+    }
+
+    audio->ring[w & GM_AUDIO_RING_MASK] = *cmd;
+
+    // the slot (and any sample it refers to) must be visible before the new write index
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicU32(&audio->write, w + 1);
+    return true;
+}
+
+int gm_audio_load_sample(gm_audio_t *audio, const char *path)
+{
+    if (audio->sample_count >= GM_AUDIO_MAX_SAMPLES)
+    {
+        SDL_Log("Cannot load %s, the sample limit of %d is reached.\n", path, GM_AUDIO_MAX_SAMPLES);
+        return -1;
+    }
+
+    SDL_IOStream *io = gm_pack_open_io(audio->pack, path);
+    if (io == NULL)
+    {
+        io = SDL_IOFromFile(path, "rb");
+    }
+    if (io == NULL)
+    {
+        SDL_Log("Could not open sound %s: %s\n", path, SDL_GetError());
+        return -1;
+    }
+
+    SDL_AudioSpec spec;
+    Uint8 *wav = NULL;
+    Uint32 wav_len = 0;
+    if (!SDL_LoadWAV_IO(io, true, &spec, &wav, &wav_len))
+    {
+        SDL_Log("Could not load sound %s: %s\n", path, SDL_GetError());
+        return -1;
+    }
+
+    // convert once here so the mixer only ever reads stereo float at its own rate
+    SDL_AudioSpec mixer;
+    mixer.format = SDL_AUDIO_F32;
+    mixer.channels = GM_AUDIO_CHANNELS;
+    mixer.freq = GM_AUDIO_RATE;
+    Uint8 *data = NULL;
+    int len = 0;
+    bool ok = SDL_ConvertAudioSamples(&spec, wav, (int)wav_len, &mixer, &data, &len);
+    SDL_free(wav);
+    if (!ok)
+    {
+        SDL_Log("Could not convert sound %s: %s\n", path, SDL_GetError());
+        return -1;
+    }
+
+    int idx = audio->sample_count;
+    audio->samples[idx].data = (float *)data;
+    audio->samples[idx].frames = (uint32_t)len / (sizeof(float) * GM_AUDIO_CHANNELS);
+    audio->sample_count++;
+    return idx;
+}
+
+//----------------------------------------------------------------------------
+// Audio thread: no locks, no allocation, no Lua
+//----------------------------------------------------------------------------
+
+static gm_audio_voice_t *gm_audio_find_voice(gm_audio_t *a, uint32_t id)
+{
+    for (int i = 0; i < GM_AUDIO_VOICES; i++)
+    {
+        if (a->voices[i].stage != GM_AUDIO_ENV_OFF && a->voices[i].id == id)
+        {
+            return &a->voices[i];
+        }
+    }
+    return NULL;
+}
+
+static gm_audio_voice_t *gm_audio_alloc_voice(gm_audio_t *a)
+{
+    // take a free voice, or steal the quietest one
+    gm_audio_voice_t *quietest = &a->voices[0];
+    for (int i = 0; i < GM_AUDIO_VOICES; i++)
+    {
+        gm_audio_voice_t *v = &a->voices[i];
+        if (v->stage == GM_AUDIO_ENV_OFF)
+        {
+            return v;
+        }
+        if (v->level < quietest->level)
+        {
+            quietest = v;
+        }
+    }
+    return quietest;
+}
+
+static void gm_audio_voice_release(gm_audio_voice_t *v)
+{
+    if (v->stage == GM_AUDIO_ENV_OFF || v->stage == GM_AUDIO_ENV_RELEASE)
+    {
+        return;
+    }
+    float frames = v->release_time * (float)GM_AUDIO_RATE;
+    if (frames < GM_AUDIO_MIN_RELEASE_FRAMES)
+    {
+        frames = GM_AUDIO_MIN_RELEASE_FRAMES;
+    }
+    v->release_step = v->level / frames;
+    v->stage = GM_AUDIO_ENV_RELEASE;
+}
+
+static void gm_audio_voice_start(gm_audio_voice_t *v, const gm_audio_cmd_t *cmd)
+{
+    memset(v, 0, sizeof(gm_audio_voice_t));
+    v->id = cmd->voice;
+
+    // equal power pan, normalized so a centered voice plays at its volume
+    float p = (SDL_clamp(cmd->pan, -1.0f, 1.0f) + 1.0f) * 0.25f * SDL_PI_F;
+    v->gain_l = SDL_cosf(p) * 1.41421356f * cmd->volume;
+    v->gain_r = SDL_sinf(p) * 1.41421356f * cmd->volume;
+
+    if (cmd->attack > 0.0f)
+    {
+        v->attack_step = 1.0f / (cmd->attack * (float)GM_AUDIO_RATE);
+        v->stage = GM_AUDIO_ENV_ATTACK;
+    }
+    else
+    {
+        v->level = 1.0f;
+        v->stage = GM_AUDIO_ENV_DECAY;
+    }
+    v->sustain = SDL_clamp(cmd->sustain, 0.0f, 1.0f);
+    v->decay_step = (cmd->decay > 0.0f) ? (1.0f - v->sustain) / (cmd->decay * (float)GM_AUDIO_RATE) : 1.0f;
+    v->release_time = cmd->release;
+    v->hold_frames = (cmd->duration > 0.0f) ? (uint32_t)(cmd->duration * (float)GM_AUDIO_RATE) + 1 : 0;
+}
+
+static void gm_audio_process(gm_audio_t *a, const gm_audio_cmd_t *cmd)
+{
+    gm_audio_voice_t *v = NULL;
+    switch (cmd->type)
+    {
+    case GM_AUDIO_CMD_TONE:
+        v = gm_audio_alloc_voice(a);
+        gm_audio_voice_start(v, cmd);
+        v->sample = -1;
+        v->wave = cmd->wave;
+        v->phase_inc = cmd->freq / (float)GM_AUDIO_RATE;
+        v->noise_state = (cmd->voice * 2654435761u) | 1u;
+        break;
+    case GM_AUDIO_CMD_SAMPLE:
+        if (cmd->sample < 0 || cmd->sample >= GM_AUDIO_MAX_SAMPLES || a->samples[cmd->sample].data == NULL)
+        {
+            break;
+        }
+        v = gm_audio_alloc_voice(a);
+        gm_audio_voice_start(v, cmd);
+        v->sample = cmd->sample;
+        v->pitch = cmd->pitch;
+        v->loop = cmd->loop;
+        break;
+    case GM_AUDIO_CMD_STOP:
+        if ((v = gm_audio_find_voice(a, cmd->voice)) != NULL)
+        {
+            gm_audio_voice_release(v);
+        }
+        break;
+    case GM_AUDIO_CMD_STOP_ALL:
+        for (int i = 0; i < GM_AUDIO_VOICES; i++)
+        {
+            gm_audio_voice_release(&a->voices[i]);
+        }
+        break;
+    case GM_AUDIO_CMD_FREQ:
+        if ((v = gm_audio_find_voice(a, cmd->voice)) != NULL)
+        {
+            v->phase_inc = cmd->freq / (float)GM_AUDIO_RATE;
+        }
+        break;
+    case GM_AUDIO_CMD_PITCH:
+        if ((v = gm_audio_find_voice(a, cmd->voice)) != NULL)
+        {
+            v->pitch = cmd->pitch;
+        }
+        break;
+    case GM_AUDIO_CMD_MASTER:
+        a->master = cmd->volume;
+        break;
+    default:
+        break;
+    }
+}
+
+static void gm_audio_drain_commands(gm_audio_t *a)
+{
+    uint32_t r = SDL_GetAtomicU32(&a->read);
+    uint32_t w = SDL_GetAtomicU32(&a->write);
+    SDL_MemoryBarrierAcquire();
+
+    while (r != w)
+    {
+        gm_audio_process(a, &a->ring[r & GM_AUDIO_RING_MASK]);
+        r++;
+    }
+
+    // the slots are free for the producer again once read is published
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicU32(&a->read, r);
+}
+
+static inline float gm_audio_envelope(gm_audio_voice_t *v)
+{
+    if (v->hold_frames > 0 && --v->hold_frames == 0)
+    {
+        gm_audio_voice_release(v);
+    }
+
+    switch (v->stage)
+    {
+    case GM_AUDIO_ENV_ATTACK:
+        v->level += v->attack_step;
+        if (v->level >= 1.0f)
+        {
+            v->level = 1.0f;
+            v->stage = GM_AUDIO_ENV_DECAY;
+        }
+        break;
+    case GM_AUDIO_ENV_DECAY:
+        v->level -= v->decay_step;
+        if (v->level <= v->sustain)
+        {
+            v->level = v->sustain;
+            v->stage = GM_AUDIO_ENV_SUSTAIN;
+        }
+        break;
+    case GM_AUDIO_ENV_RELEASE:
+        v->level -= v->release_step;
+        if (v->level <= 0.0f)
+        {
+            v->level = 0.0f;
+            v->stage = GM_AUDIO_ENV_OFF;
+        }
+        break;
+    default:
+        break;
+    }
+    return v->level;
+}
+
+static inline float gm_audio_oscillator(const gm_audio_t *a, gm_audio_voice_t *v)
+{
+    float out;
+    switch (v->wave)
+    {
+    case GM_AUDIO_WAVE_SQUARE:
+        out = (v->phase < 0.5f) ? 1.0f : -1.0f;
+        break;
+    case GM_AUDIO_WAVE_TRIANGLE:
+        out = 4.0f * SDL_fabsf(v->phase - 0.5f) - 1.0f;
+        break;
+    case GM_AUDIO_WAVE_SAW:
+        out = 2.0f * v->phase - 1.0f;
+        break;
+    case GM_AUDIO_WAVE_NOISE:
+        out = v->noise_value;
+        break;
+    default:
+        out = a->wavetable[(int)(v->phase * (float)GM_AUDIO_WAVETABLE_SIZE) & (GM_AUDIO_WAVETABLE_SIZE - 1)];
+        break;
+    }
+
+    v->phase += v->phase_inc;
+    if (v->phase >= 1.0f)
+    {
+        v->phase -= SDL_floorf(v->phase);
+
+        // noise is sample-and-hold at the oscillator frequency, so it can be pitched
+        uint32_t x = v->noise_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        v->noise_state = x;
+        v->noise_value = (float)(x >> 8) / 8388608.0f - 1.0f;
+    }
+    return out;
+}
+
+static void gm_audio_mix_voice(gm_audio_t *a, gm_audio_voice_t *v, float *out, int frames)
+{
+    if (v->sample < 0)
+    {
+        for (int i = 0; i < frames && v->stage != GM_AUDIO_ENV_OFF; i++)
+        {
+            float s = gm_audio_oscillator(a, v) * gm_audio_envelope(v);
+            out[2 * i] += s * v->gain_l;
+            out[2 * i + 1] += s * v->gain_r;
+        }
+        return;
+    }
+
+    const gm_audio_sample_t *smp = &a->samples[v->sample];
+    for (int i = 0; i < frames && v->stage != GM_AUDIO_ENV_OFF; i++)
+    {
+        uint32_t idx = (uint32_t)v->position;
+        if (idx >= smp->frames)
+        {
+            if (!v->loop || smp->frames == 0)
+            {
+                v->stage = GM_AUDIO_ENV_OFF;
+                break;
+            }
+            v->position -= (double)smp->frames * SDL_floor(v->position / (double)smp->frames);
+            idx = (uint32_t)v->position;
+        }
+        uint32_t next = idx + 1;
+        if (next >= smp->frames)
+        {
+            next = v->loop ? 0 : idx;
+        }
+
+        float t = (float)(v->position - (double)idx);
+        float env = gm_audio_envelope(v);
+        float l = smp->data[2 * idx] + (smp->data[2 * next] - smp->data[2 * idx]) * t;
+        float r = smp->data[2 * idx + 1] + (smp->data[2 * next + 1] - smp->data[2 * idx + 1]) * t;
+        out[2 * i] += l * env * v->gain_l;
+        out[2 * i + 1] += r * env * v->gain_r;
+        v->position += v->pitch;
+    }
+}
+
+static void gm_audio_mix(gm_audio_t *a, float *out, int frames)
+{
+    memset(out, 0, sizeof(float) * GM_AUDIO_CHANNELS * (size_t)frames);
+
+    uint32_t active = 0;
+    for (int i = 0; i < GM_AUDIO_VOICES; i++)
+    {
+        gm_audio_voice_t *v = &a->voices[i];
+        if (v->stage != GM_AUDIO_ENV_OFF)
+        {
+            gm_audio_mix_voice(a, v, out, frames);
+            active++;
+        }
+    }
+    SDL_SetAtomicU32(&a->active_voices, active);
+
+    for (int i = 0; i < frames * GM_AUDIO_CHANNELS; i++)
+    {
+        out[i] = SDL_clamp(out[i] * a->master, -1.0f, 1.0f);
+    }
+}
+
+static void gm_audio_max_u32(SDL_AtomicU32 *a, uint32_t value)
+{
+    // only the audio thread writes the maxima, so load-compare-store is enough
+    if (value > SDL_GetAtomicU32(a))
+    {
+        SDL_SetAtomicU32(a, value);
+    }
+}
+
+static void SDLCALL gm_audio_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
+{
+    (void)total_amount;
+    gm_audio_t *a = (gm_audio_t *)userdata;
+    uint64_t start = SDL_GetTicksNS();
+    if (a->last_callback_ns == 0)
+    {
+        gm_trace_thread_attach(a->trace);
+    }
+
+    // a gap longer than two device buffers means the device ran dry at least once
+    if (a->last_callback_ns != 0 && a->period_ns != 0)
+    {
+        uint64_t gap = start - a->last_callback_ns;
+        if (gap > 2 * a->period_ns)
+        {
+            SDL_SetAtomicU32(&a->underruns, SDL_GetAtomicU32(&a->underruns) + 1);
+        }
+        gm_audio_max_u32(&a->max_gap_us, (uint32_t)(gap / 1000));
+    }
+    a->last_callback_ns = start;
+
+    gm_audio_drain_commands(a);
+
+    int frames = additional_amount / (int)(sizeof(float) * GM_AUDIO_CHANNELS);
+    while (frames > 0)
+    {
+        int chunk = SDL_min(frames, GM_AUDIO_MIX_FRAMES);
+        gm_audio_mix(a, a->mix, chunk);
+        SDL_PutAudioStreamData(stream, a->mix, chunk * (int)(sizeof(float) * GM_AUDIO_CHANNELS));
+        frames -= chunk;
+    }
+
+    uint64_t mix_ns = SDL_GetTicksNS() - start;
+    if (a->period_ns != 0 && mix_ns > a->period_ns)
+    {
+        SDL_SetAtomicU32(&a->slow_mixes, SDL_GetAtomicU32(&a->slow_mixes) + 1);
+    }
+    gm_audio_max_u32(&a->max_mix_us, (uint32_t)(mix_ns / 1000));
+    SDL_SetAtomicU32(&a->callbacks, SDL_GetAtomicU32(&a->callbacks) + 1);
+    gm_trace_end("audio_mix", start);
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings, gm.sound.*
+//----------------------------------------------------------------------------
+
+static gm_audio_t *gm_audio_upvalue(lua_State *L)
+{
+    return (gm_audio_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static float gm_audio_opt_field(lua_State *L, int idx, const char *key, float def)
+{
+    lua_getfield(L, idx, key);
+    float value = (float)luaL_optnumber(L, -1, def);
+    lua_pop(L, 1);
+    return value;
+}
+
+static void gm_audio_push_voice(lua_State *L, gm_audio_t *audio, gm_audio_cmd_t *cmd)
+{
+    cmd->voice = audio->next_voice_id++;
+    if (audio->next_voice_id == 0)
+    {
+        audio->next_voice_id = 1;
+    }
+
+    if (gm_audio_send(audio, cmd))
+    {
+        lua_pushinteger(L, cmd->voice);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+}
+
+// gm.sound.tone(freq [, duration [, wave [, volume]]]) or gm.sound.tone{freq=, wave=, ...}
+static int gm_audio_lua_tone(lua_State *L)
+{
+    gm_audio_t *audio = gm_audio_upvalue(L);
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_TONE;
+    cmd.attack = 0.005f;
+    cmd.decay = 0.05f;
+    cmd.sustain = 0.8f;
+    cmd.release = 0.05f;
+
+    if (lua_istable(L, 1))
+    {
+        lua_getfield(L, 1, "wave");
+        cmd.wave = (uint8_t)luaL_checkoption(L, -1, "sine", gm_audio_wave_names);
+        lua_pop(L, 1);
+        cmd.freq = gm_audio_opt_field(L, 1, "freq", 440.0f);
+        cmd.duration = gm_audio_opt_field(L, 1, "duration", 0.25f);
+        cmd.volume = gm_audio_opt_field(L, 1, "volume", 0.5f);
+        cmd.pan = gm_audio_opt_field(L, 1, "pan", 0.0f);
+        cmd.attack = gm_audio_opt_field(L, 1, "attack", cmd.attack);
+        cmd.decay = gm_audio_opt_field(L, 1, "decay", cmd.decay);
+        cmd.sustain = gm_audio_opt_field(L, 1, "sustain", cmd.sustain);
+        cmd.release = gm_audio_opt_field(L, 1, "release", cmd.release);
+    }
+    else
+    {
+        cmd.freq = (float)luaL_checknumber(L, 1);
+        cmd.duration = (float)luaL_optnumber(L, 2, 0.25);
+        cmd.wave = (uint8_t)luaL_checkoption(L, 3, "sine", gm_audio_wave_names);
+        cmd.volume = (float)luaL_optnumber(L, 4, 0.5);
+    }
+
+    gm_audio_push_voice(L, audio, &cmd);
+    return 1;
+}
+
+// gm.sound.load(path), loading the same path twice returns the same sound
+static int gm_audio_lua_load(lua_State *L)
+{
+    gm_audio_t *audio = gm_audio_upvalue(L);
+    const char *path = luaL_checkstring(L, 1);
+
+    lua_pushvalue(L, 1);
+    if (lua_rawget(L, lua_upvalueindex(2)) == LUA_TNUMBER)
+    {
+        return 1;
+    }
+    lua_pop(L, 1);
+
+    int idx = gm_audio_load_sample(audio, path);
+    if (idx < 0)
+    {
+        return luaL_error(L, "could not load sound %s", path);
+    }
+    lua_pushinteger(L, idx + 1);
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, lua_upvalueindex(2));
+    return 1;
+}
+
+// gm.sound.play(sound [, volume [, pan [, pitch [, loop]]]])
+static int gm_audio_lua_play(lua_State *L)
+{
+    gm_audio_t *audio = gm_audio_upvalue(L);
+    lua_Integer sound = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, sound >= 1 && sound <= audio->sample_count, 1, "invalid sound");
+
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_SAMPLE;
+    cmd.sample = (int32_t)(sound - 1);
+    cmd.volume = (float)luaL_optnumber(L, 2, 1.0);
+    cmd.pan = (float)luaL_optnumber(L, 3, 0.0);
+    lua_Number pitch = luaL_optnumber(L, 4, 1.0);
+    luaL_argcheck(L, pitch >= 0.0 && pitch <= GM_AUDIO_MAX_PITCH, 4, "pitch out of range");
+    cmd.pitch = (float)pitch;
+    cmd.loop = (uint8_t)lua_toboolean(L, 5);
+    cmd.sustain = 1.0f;
+    cmd.release = 0.005f;
+
+    gm_audio_push_voice(L, audio, &cmd);
+    return 1;
+}
+
+static int gm_audio_lua_stop(lua_State *L)
+{
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_STOP;
+    cmd.voice = (uint32_t)luaL_checkinteger(L, 1);
+    gm_audio_send(gm_audio_upvalue(L), &cmd);
+    return 0;
+}
+
+static int gm_audio_lua_stop_all(lua_State *L)
+{
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_STOP_ALL;
+    gm_audio_send(gm_audio_upvalue(L), &cmd);
+    return 0;
+}
+
+// gm.sound.setFreq(voice, hz), the frequency of a tone
+static int gm_audio_lua_set_freq(lua_State *L)
+{
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_FREQ;
+    cmd.voice = (uint32_t)luaL_checkinteger(L, 1);
+    cmd.freq = (float)luaL_checknumber(L, 2);
+    gm_audio_send(gm_audio_upvalue(L), &cmd);
+    return 0;
+}
+
+// gm.sound.setPitch(voice, rate), the playback rate of a sample, 1 for the original speed
+static int gm_audio_lua_set_pitch(lua_State *L)
+{
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_PITCH;
+    cmd.voice = (uint32_t)luaL_checkinteger(L, 1);
+    lua_Number pitch = luaL_checknumber(L, 2);
+    luaL_argcheck(L, pitch >= 0.0 && pitch <= GM_AUDIO_MAX_PITCH, 2, "pitch out of range");
+    cmd.pitch = (float)pitch;
+    gm_audio_send(gm_audio_upvalue(L), &cmd);
+    return 0;
+}
+
+static int gm_audio_lua_volume(lua_State *L)
+{
+    gm_audio_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = GM_AUDIO_CMD_MASTER;
+    cmd.volume = SDL_clamp((float)luaL_checknumber(L, 1), 0.0f, 1.0f);
+    gm_audio_send(gm_audio_upvalue(L), &cmd);
+    return 0;
+}
+
+static void gm_audio_set_stat(lua_State *L, const char *k, lua_Number v)
+{
+    lua_pushnumber(L, v);
+    lua_setfield(L, -2, k);
+}
+
+static int gm_audio_lua_stats(lua_State *L)
+{
+    gm_audio_t *a = gm_audio_upvalue(L);
+    lua_createtable(L, 0, 9);
+    gm_audio_set_stat(L, "callbacks", SDL_GetAtomicU32(&a->callbacks));
+    gm_audio_set_stat(L, "underruns", SDL_GetAtomicU32(&a->underruns));
+    gm_audio_set_stat(L, "slowMixes", SDL_GetAtomicU32(&a->slow_mixes));
+    gm_audio_set_stat(L, "dropped", SDL_GetAtomicU32(&a->dropped));
+    gm_audio_set_stat(L, "voices", SDL_GetAtomicU32(&a->active_voices));
+    gm_audio_set_stat(L, "maxGapMs", SDL_GetAtomicU32(&a->max_gap_us) / 1000.0);
+    gm_audio_set_stat(L, "maxMixMs", SDL_GetAtomicU32(&a->max_mix_us) / 1000.0);
+    gm_audio_set_stat(L, "bufferFrames", a->buffer_frames);
+    gm_audio_set_stat(L, "bufferMs", (double)a->period_ns / 1e6);
+    return 1;
+}
+
+void gm_audio_register_lua(gm_audio_t *audio, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"tone", gm_audio_lua_tone},
+        {"load", gm_audio_lua_load},
+        {"play", gm_audio_lua_play},
+        {"stop", gm_audio_lua_stop},
+        {"stopAll", gm_audio_lua_stop_all},
+        {"setFreq", gm_audio_lua_set_freq},
+        {"setPitch", gm_audio_lua_set_pitch},
+        {"volume", gm_audio_lua_volume},
+        {"stats", gm_audio_lua_stats},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_newtable(L);
+
+    // upvalues: the audio context and the path to sound cache
+    lua_pushlightuserdata(L, audio);
+    lua_newtable(L);
+    luaL_setfuncs(L, funcs, 2);
+
+    lua_setfield(L, -2, "sound");
+    lua_pop(L, 1);
+}
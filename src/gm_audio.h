@@ -0,0 +1,161 @@
+#ifndef __GM_AUDIO_H__
+#define __GM_AUDIO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_pack.h"
+#include "gm_trace.h"
+
+// mixer output: interleaved stereo float, converted to the device format by SDL
+#define GM_AUDIO_RATE 48000
+#define GM_AUDIO_CHANNELS 2
+#define GM_AUDIO_VOICES 32
+#define GM_AUDIO_MAX_SAMPLES 64
+#define GM_AUDIO_MIX_FRAMES 1024
+#define GM_AUDIO_WAVETABLE_SIZE 2048
+
+// command ring between the Lua thread (producer) and the audio thread (consumer), power of two
+#define GM_AUDIO_RING_SIZE 256
+
+// highest sample playback rate, keeps the play position within the sample plus a step
+#define GM_AUDIO_MAX_PITCH 64.0
+
+typedef enum
+{
+    GM_AUDIO_WAVE_SINE,
+    GM_AUDIO_WAVE_SQUARE,
+    GM_AUDIO_WAVE_TRIANGLE,
+    GM_AUDIO_WAVE_SAW,
+    GM_AUDIO_WAVE_NOISE,
+    GM_AUDIO_WAVE_COUNT
+} gm_audio_wave_t;
+
+typedef enum
+{
+    GM_AUDIO_CMD_TONE,
+    GM_AUDIO_CMD_SAMPLE,
+    GM_AUDIO_CMD_STOP,
+    GM_AUDIO_CMD_STOP_ALL,
+    GM_AUDIO_CMD_FREQ,
+    GM_AUDIO_CMD_PITCH,
+    GM_AUDIO_CMD_MASTER
+} gm_audio_cmd_type_t;
+
+// A fixed-size mixer command, everything the audio thread needs is copied in.
+typedef struct
+{
+    uint8_t type;
+    uint8_t wave;
+    uint8_t loop;
+    int32_t sample;
+    uint32_t voice;
+    float freq;
+    float volume;
+    float pan;
+    float pitch;
+    float attack;
+    float decay;
+    float sustain;
+    float release;
+    float duration;
+} gm_audio_cmd_t;
+
+typedef enum
+{
+    GM_AUDIO_ENV_OFF,
+    GM_AUDIO_ENV_ATTACK,
+    GM_AUDIO_ENV_DECAY,
+    GM_AUDIO_ENV_SUSTAIN,
+    GM_AUDIO_ENV_RELEASE
+} gm_audio_env_stage_t;
+
+// Voice state, owned by the audio thread.
+typedef struct
+{
+    uint32_t id;
+    int32_t sample; // -1 for oscillators
+    uint8_t wave;
+    bool loop;
+
+    float phase;
+    float phase_inc;
+    double position;
+    float pitch;
+    uint32_t noise_state;
+    float noise_value;
+
+    float gain_l;
+    float gain_r;
+
+    uint8_t stage;
+    float level;
+    float attack_step;
+    float decay_step;
+    float sustain;
+    float release_time;
+    float release_step;
+    uint32_t hold_frames;
+} gm_audio_voice_t;
+
+// A decoded sample, stereo float at GM_AUDIO_RATE. Immutable once published.
+typedef struct
+{
+    float *data;
+    uint32_t frames;
+} gm_audio_sample_t;
+
+typedef struct
+{
+    SDL_AudioStream *stream;
+    const gm_pack_t *pack;
+
+    // SPSC ring, write is only advanced by the producer, read only by the consumer
+    gm_audio_cmd_t ring[GM_AUDIO_RING_SIZE];
+    SDL_AtomicU32 write;
+    SDL_AtomicU32 read;
+    uint32_t next_voice_id;
+
+    // samples are loaded on the main thread and published before any command uses them
+    gm_audio_sample_t samples[GM_AUDIO_MAX_SAMPLES];
+    int sample_count;
+
+    // audio thread only
+    gm_audio_voice_t voices[GM_AUDIO_VOICES];
+    float mix[GM_AUDIO_MIX_FRAMES * GM_AUDIO_CHANNELS];
+    float wavetable[GM_AUDIO_WAVETABLE_SIZE];
+    float master;
+    uint64_t last_callback_ns;
+    gm_trace_buffer_t *trace;
+
+    // device buffer, period_ns is the time one buffer lasts
+    int buffer_frames;
+    uint64_t period_ns;
+
+    // instrumentation, written by the audio thread, read by gm.sound.stats()
+    SDL_AtomicU32 callbacks;
+    SDL_AtomicU32 underruns;
+    SDL_AtomicU32 slow_mixes;
+    SDL_AtomicU32 max_gap_us;
+    SDL_AtomicU32 max_mix_us;
+    SDL_AtomicU32 active_voices;
+    SDL_AtomicU32 dropped;
+} gm_audio_t;
+
+// Opens the default playback device, buffer_frames 0 keeps SDL's default and -1 disables audio.
+// Failing to open a device is not fatal, gm.sound calls then do nothing.
+int gm_audio_init(gm_audio_t **audio, const gm_pack_t *pack, int buffer_frames);
+void gm_audio_shutdown(gm_audio_t *audio);
+
+// Producer side, called from the Lua thread. Returns false if the ring is full.
+bool gm_audio_send(gm_audio_t *audio, const gm_audio_cmd_t *cmd);
+
+// Decodes a WAV file from the pack or disk, returns the sample index or -1.
+int gm_audio_load_sample(gm_audio_t *audio, const char *path);
+
+// Adds the gm.sound table to the game API.
+void gm_audio_register_lua(gm_audio_t *audio, lua_State *L);
+
+#endif // __GM_AUDIO_H__
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gm_batch.h"
+#include "gm_lua.h"
+#include "gm_input.h"
+#include "gm_audio.h"
+#include "gm_fill.h"
+#include "gm_sprite.h"
+#include "gm_canvas.h"
+#include "gm_trace.h"
+#include "gm_array.h"
+#include "gm_task.h"
+#include "gm_vec.h"
+#include "gm_spatial.h"
+#include "gm_particles.h"
+#include "gm_tilemap.h"
+#include "gm_post.h"
+#include "gm_asset.h"
+#include "gm_hook.h"
+#include "gm_watchdog.h"
+
+// Everything one job renders with, created and destroyed on the worker thread
+typedef struct
+{
+    SDL_Surface *surface;
+    SDL_Renderer *renderer;
+    SDL_Texture *canvas;
+    gm_lua_t *lua_ctx;
+    gm_input_t *input;
+    gm_audio_t *audio;
+    gm_fill_t *fill;
+    gm_sprite_t *sprite;
+    gm_canvas_ctx_t *canvas_ctx;
+    gm_array_ctx_t *array;
+    gm_particles_ctx_t *particles;
+    gm_tilemap_ctx_t *tilemap;
+    gm_post_t *post;
+    gm_asset_mgr_t *assets;
+    gm_task_sched_t *tasks;
+    gm_hook_t *hook;
+    gm_watchdog_t *watchdog;
+} gm_batch_instance_t;
+
+static char *gm_batch_next_field(char **cursor)
+{
+    char *s = *cursor;
+    while (*s == ' ' || *s == '\t')
+    {
+        s++;
+    }
+    if (*s == '\0')
+    {
+        *cursor = s;
+        return NULL;
+    }
+
+    char *start = s;
+    while (*s != '\0' && *s != ' ' && *s != '\t')
+    {
+        s++;
+    }
+    if (*s != '\0')
+    {
+        *s++ = '\0';
+    }
+    *cursor = s;
+    return start;
+}
+
+static int gm_batch_parse(gm_batch_t *b, char *text, const char *list_path)
+{
+    int capacity = 0;
+    int line_no = 0;
+    char *line = text;
+    while (line != NULL && *line != '\0')
+    {
+        char *end = SDL_strchr(line, '\n');
+        if (end != NULL)
+        {
+            *end = '\0';
+        }
+        size_t len = SDL_strlen(line);
+        if (len > 0 && line[len - 1] == '\r')
+        {
+            line[len - 1] = '\0';
+        }
+        line_no++;
+
+        char *cursor = line;
+        char *script = gm_batch_next_field(&cursor);
+        if (script != NULL && script[0] != '#')
+        {
+            if (b->count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 64;
+                gm_batch_job_t *jobs = (gm_batch_job_t *)realloc(b->jobs, sizeof(gm_batch_job_t) * (size_t)capacity);
+                if (jobs == NULL)
+                {
+                    SDL_Log("Unable to allocate memory for the batch jobs.\n");
+                    return 1;
+                }
+                b->jobs = jobs;
+            }
+
+            gm_batch_job_t *job = &b->jobs[b->count];
+            char *seed = gm_batch_next_field(&cursor);
+            char *output = gm_batch_next_field(&cursor);
+            if (SDL_strlen(script) >= sizeof(job->script) || (output && SDL_strlen(output) >= sizeof(job->output)))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s:%d: path too long\n", list_path, line_no);
+                return 1;
+            }
+
+            SDL_strlcpy(job->script, script, sizeof(job->script));
+            job->seed = seed ? SDL_strtoull(seed, NULL, 0) : (uint64_t)line_no;
+            if (output)
+            {
+                SDL_strlcpy(job->output, output, sizeof(job->output));
+            }
+            else
+            {
+                SDL_snprintf(job->output, sizeof(job->output), "batch_%05d.png", b->count + 1);
+            }
+            b->count++;
+        }
+
+        line = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+int gm_batch_init(gm_batch_t **batch, const char *list_path, const gm_pack_t *pack, int w, int h, int frames,
+                  int watchdog_ms)
+{
+    (*batch) = (gm_batch_t *)calloc(sizeof(gm_batch_t), 1);
+    if ((*batch) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_batch_t.\n");
+        return 1;
+    }
+
+    gm_batch_t *b = (*batch);
+    b->pack = pack;
+    b->cvs_width = w;
+    b->cvs_height = h;
+    b->frames = frames;
+    b->watchdog_ms = watchdog_ms;
+
+    char *text = (char *)SDL_LoadFile(list_path, NULL);
+    if (text == NULL)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not read batch list %s: %s\n", list_path, SDL_GetError());
+        return 1;
+    }
+    int ret = gm_batch_parse(b, text, list_path);
+    SDL_free(text);
+    if (ret == 0 && b->count == 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Batch list %s has no jobs.\n", list_path);
+        ret = 1;
+    }
+    return ret;
+}
+
+void gm_batch_shutdown(gm_batch_t *batch)
+{
+    if (batch)
+    {
+        free(batch->jobs);
+        free(batch);
+    }
+}
+
+static void gm_batch_instance_shutdown(gm_batch_instance_t *in)
+{
+    // the watchdog stops checking before the Lua state is closed, the hook goes once it is
+    gm_watchdog_shutdown(in->watchdog);
+
+    // then the Lua state, before the rest: its finalizers release textures owned by the renderer
+    gm_lua_shutdown(in->lua_ctx);
+    gm_hook_shutdown(in->hook);
+    gm_task_shutdown(in->tasks);
+    gm_audio_shutdown(in->audio);
+    gm_input_shutdown(in->input);
+    gm_fill_shutdown(in->fill);
+    gm_sprite_shutdown(in->sprite);
+    gm_canvas_shutdown(in->canvas_ctx);
+    gm_array_shutdown(in->array);
+    gm_particles_shutdown(in->particles);
+    gm_tilemap_shutdown(in->tilemap);
+    gm_post_shutdown(in->post);
+    gm_asset_shutdown(in->assets);
+    if (in->canvas)
+    {
+        SDL_DestroyTexture(in->canvas);
+    }
+    if (in->renderer)
+    {
+        SDL_DestroyRenderer(in->renderer);
+    }
+    if (in->surface)
+    {
+        SDL_DestroySurface(in->surface);
+    }
+}
+
+static bool gm_batch_instance_init(gm_batch_instance_t *in, const gm_batch_t *b, const gm_batch_job_t *job)
+{
+    // the software renderer draws into a plain surface, no window or GPU is involved
+    in->surface = SDL_CreateSurface(b->cvs_width, b->cvs_height, SDL_PIXELFORMAT_RGBA8888);
+    in->renderer = in->surface ? SDL_CreateSoftwareRenderer(in->surface) : NULL;
+    in->canvas = in->renderer ? SDL_CreateTexture(in->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, b->cvs_width, b->cvs_height) : NULL;
+    if (in->canvas == NULL)
+    {
+        SDL_Log("%s: could not create the software canvas: %s\n", job->script, SDL_GetError());
+        return false;
+    }
+    SDL_SetRenderTarget(in->renderer, in->canvas);
+
+    gm_lua_error_t err = gm_lua_init_script(&in->lua_ctx, b->pack, job->script);
+    if (err.code > 100)
+    {
+        SDL_Log("%s: %s\n", job->script, err.message);
+        return false;
+    }
+    gm_lua_seed_random(in->lua_ctx, job->seed);
+    gm_lua_register_game_api(in->lua_ctx, in->renderer, in->canvas, b->cvs_width, b->cvs_height);
+
+    // cleared through the colour cache, so the cache matches the renderer from the start
+    gm_lua_set_draw_color(in->lua_ctx->gm, 0x000000ffu);
+    SDL_RenderClear(in->renderer);
+
+    // input is never fed, audio is never opened and post effects are never composited, they are there so scripts run unchanged;
+    // assets load on this thread, ready as soon as gm.loadAsync returns, so every run draws the same
+    SDL_FRect rect = {0.0f, 0.0f, (float)b->cvs_width, (float)b->cvs_height};
+    if (gm_input_init(&in->input, rect, 1) ||
+        gm_audio_init(&in->audio, b->pack, -1) ||
+        gm_fill_init(&in->fill, in->renderer, b->cvs_width, b->cvs_height) ||
+        gm_sprite_init(&in->sprite, in->renderer, b->pack) ||
+        gm_canvas_init(&in->canvas_ctx, in->renderer, in->lua_ctx->gm) ||
+        gm_array_init(&in->array, in->renderer) ||
+        gm_particles_init(&in->particles, in->renderer, b->cvs_width, b->cvs_height) ||
+        gm_tilemap_init(&in->tilemap, in->renderer, in->lua_ctx->gm) ||
+        gm_post_init(&in->post, in->renderer, b->cvs_width, b->cvs_height) ||
+        gm_asset_init(&in->assets, in->renderer, b->pack, false) ||
+        gm_task_init(&in->tasks, in->lua_ctx, GM_TASK_DEFAULT_BUDGET_MS) ||
+        gm_hook_init(&in->hook, in->lua_ctx->L) ||
+        gm_watchdog_init(&in->watchdog, in->hook, b->watchdog_ms))
+    {
+        return false;
+    }
+    gm_input_register_lua(in->input, in->lua_ctx->L);
+    gm_audio_register_lua(in->audio, in->lua_ctx->L);
+    gm_fill_register_lua(in->fill, in->lua_ctx->L);
+    gm_sprite_register_lua(in->sprite, in->lua_ctx->L);
+    gm_canvas_register_lua(in->canvas_ctx, in->lua_ctx->L);
+    gm_array_register_lua(in->array, in->lua_ctx->L);
+    gm_vec_register_lua(in->lua_ctx->L);
+    gm_spatial_register_lua(in->lua_ctx->L);
+    gm_particles_register_lua(in->particles, in->lua_ctx->L);
+    gm_tilemap_register_lua(in->tilemap, in->lua_ctx->L);
+    gm_post_register_lua(in->post, in->lua_ctx->L);
+    gm_asset_register_lua(in->assets, in->lua_ctx->L);
+    gm_task_register_lua(in->tasks, in->lua_ctx->L);
+    gm_watchdog_register_lua(in->watchdog, in->lua_ctx->L);
+    gm_trace_register_lua(in->lua_ctx->L);
+    return true;
+}
+
+static bool gm_batch_render(const gm_batch_t *b, const gm_batch_job_t *job)
+{
+    gm_batch_instance_t in;
+    memset(&in, 0, sizeof(in));
+    bool ok = gm_batch_instance_init(&in, b, job);
+
+    if (ok)
+    {
+        gm_watchdog_arm(in.watchdog, "script load");
+        gm_lua_error_t err = gm_lua_load_file(in.lua_ctx);
+        gm_watchdog_disarm(in.watchdog);
+        ok = (err.code == 0);
+    }
+
+    // gm:noLoop() ends the job early, the image is whatever was drawn so far
+    for (int frame = 0; ok && frame < b->frames && !in.lua_ctx->gm->stop_running; frame++)
+    {
+        gm_trace_lua_reset();
+        gm_input_begin_frame(in.input);
+        gm_input_consume(in.input, SDL_GetTicksNS());
+        SDL_SetRenderTarget(in.renderer, in.canvas);
+        gm_watchdog_arm(in.watchdog, "draw");
+        gm_lua_error_t err = gm_lua_call_draw(in.lua_ctx, GM_BATCH_DT);
+        gm_watchdog_arm(in.watchdog, "tasks");
+        ok = (err.code == 0) && gm_task_run(in.tasks, NULL, 0) == 0;
+        gm_watchdog_disarm(in.watchdog);
+    }
+
+    if (ok)
+    {
+        SDL_SetRenderTarget(in.renderer, in.canvas);
+        SDL_Surface *pixels = SDL_RenderReadPixels(in.renderer, NULL);
+        ok = pixels && SDL_SavePNG(pixels, job->output);
+        if (!ok)
+        {
+            SDL_Log("%s: could not save %s: %s\n", job->script, job->output, SDL_GetError());
+        }
+        SDL_DestroySurface(pixels);
+    }
+
+    gm_batch_instance_shutdown(&in);
+    return ok;
+}
+
+static int gm_batch_worker(void *data)
+{
+    gm_batch_t *b = (gm_batch_t *)data;
+    gm_trace_thread_name("batch worker");
+    for (;;)
+    {
+        // jobs are handed out one at a time, so slow scripts do not hold up a whole share
+        int i = SDL_AddAtomicInt(&b->next, 1);
+        if (i >= b->count)
+        {
+            break;
+        }
+
+        const gm_batch_job_t *job = &b->jobs[i];
+        uint64_t span = gm_trace_begin();
+        bool ok = gm_batch_render(b, job);
+        gm_trace_end(job->script, span);
+        if (!ok)
+        {
+            SDL_AddAtomicInt(&b->failed, 1);
+            SDL_Log("job %d (%s, seed %llu) failed\n", i + 1, job->script, (unsigned long long)job->seed);
+        }
+
+        int done = SDL_AddAtomicInt(&b->done, 1) + 1;
+        if (done % 100 == 0)
+        {
+            SDL_Log("batch: %d/%d jobs done\n", done, b->count);
+        }
+    }
+    return 0;
+}
+
+int gm_batch_run(gm_batch_t *batch, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = SDL_GetNumLogicalCPUCores();
+    }
+    threads = SDL_clamp(threads, 1, SDL_min(batch->count, GM_BATCH_MAX_THREADS));
+
+    SDL_SetAtomicInt(&batch->next, 0);
+    SDL_SetAtomicInt(&batch->failed, 0);
+    SDL_SetAtomicInt(&batch->done, 0);
+
+    SDL_Log("batch: %d jobs, %d frames each, %dx%d, %d threads\n",
+            batch->count, batch->frames, batch->cvs_width, batch->cvs_height, threads);
+    uint64_t start = SDL_GetTicksNS();
+
+    SDL_Thread *workers[GM_BATCH_MAX_THREADS];
+    int started = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "gm_batch_%d", i);
+        workers[started] = SDL_CreateThread(gm_batch_worker, name, batch);
+        if (workers[started] == NULL)
+        {
+            SDL_Log("Could not start batch worker %d: %s\n", i, SDL_GetError());
+            break;
+        }
+        started++;
+    }
+
+    // with no worker at all the main thread does the work
+    if (started == 0)
+    {
+        gm_batch_worker(batch);
+    }
+    for (int i = 0; i < started; i++)
+    {
+        SDL_WaitThread(workers[i], NULL);
+    }
+
+    double seconds = (double)(SDL_GetTicksNS() - start) / 1e9;
+    int failed = SDL_GetAtomicInt(&batch->failed);
+    SDL_Log("batch: %d jobs, %d failed, %.2f s, %.1f jobs/s\n",
+            batch->count, failed, seconds, seconds > 0.0 ? (double)batch->count / seconds : 0.0);
+    return failed;
+}
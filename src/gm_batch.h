@@ -0,0 +1,52 @@
+#ifndef __GM_BATCH_H__
+#define __GM_BATCH_H__
+
+#include <stdint.h>
+#include <SDL3/SDL.h>
+
+#include "gm_pack.h"
+
+#define GM_BATCH_MAX_THREADS 256
+#define GM_BATCH_MAX_FRAMES 100000
+
+// fixed frame time passed to draw(dt), in milliseconds
+#define GM_BATCH_DT (1000.0f / 60.0f)
+
+// One line of the job list: `script [seed [output.png]]`
+typedef struct
+{
+    char script[256];
+    uint64_t seed;
+    char output[256];
+} gm_batch_job_t;
+
+// A list of independent renders. Every job gets its own Lua state, software
+// renderer and CPU canvas, so workers share nothing but the read-only pack.
+typedef struct
+{
+    const gm_pack_t *pack;
+    int cvs_width;
+    int cvs_height;
+    int frames;
+    int watchdog_ms;
+
+    gm_batch_job_t *jobs;
+    int count;
+
+    // next job to hand out and jobs that failed, shared by the workers
+    SDL_AtomicInt next;
+    SDL_AtomicInt failed;
+    SDL_AtomicInt done;
+} gm_batch_t;
+
+// Reads the job list. Blank lines and lines starting with # are skipped, the seed
+// defaults to the line number and the output to batch_NNNNN.png.
+// watchdog_ms stops a job whose script runs that long at a time, 0 never does.
+int gm_batch_init(gm_batch_t **batch, const char *list_path, const gm_pack_t *pack, int w, int h, int frames,
+                  int watchdog_ms);
+void gm_batch_shutdown(gm_batch_t *batch);
+
+// Renders every job on `threads` workers (0 for one per core), returns the number of failed jobs.
+int gm_batch_run(gm_batch_t *batch, int threads);
+
+#endif // __GM_BATCH_H__
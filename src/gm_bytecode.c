@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_bytecode.h"
+#include "gm_util.h"
+
+#define GM_BYTECODE_MAGIC "GMBC"
+#define GM_BYTECODE_HEADER_SIZE 24
+
+// Cache file header, stored in native byte order since Lua bytecode is not portable anyway.
+typedef struct
+{
+    char magic[4];
+    uint32_t lua_version;
+    uint64_t source_hash;
+    uint64_t source_size;
+} gm_bytecode_header_t;
+
+// Flattens the relative path into a single file name inside the cache dir. '_' is
+// written as "__" and separators as "_s", so two paths never share a cache file.
+// Returns false if the name does not fit, the script is then not cached.
+static bool gm_bytecode_cache_path(const char *path, char *out, size_t out_size)
+{
+    size_t n = (size_t)SDL_snprintf(out, out_size, "%s/", GM_BYTECODE_CACHE_DIR);
+    for (const char *p = path; *p; p++)
+    {
+        bool sep = (*p == '/' || *p == '\\');
+        if (n + 3 >= out_size)
+        {
+            return false;
+        }
+        if (sep || *p == '_')
+        {
+            out[n++] = '_';
+            out[n++] = sep ? 's' : '_';
+        }
+        else
+        {
+            out[n++] = *p;
+        }
+    }
+    if (n + 2 > out_size)
+    {
+        return false;
+    }
+    out[n++] = 'c';
+    out[n] = '\0';
+    return true;
+}
+
+static void gm_bytecode_chunk_name(const char *path, char *out, size_t out_size)
+{
+    // same "@file" convention as luaL_loadfile, so error messages look identical
+    SDL_snprintf(out, out_size, "@%s", path);
+}
+
+static void gm_bytecode_make_header(gm_bytecode_header_t *hdr, const void *src, size_t src_size)
+{
+    memcpy(hdr->magic, GM_BYTECODE_MAGIC, 4);
+    hdr->lua_version = LUA_VERSION_NUM;
+    hdr->source_hash = gm_hash_fnv1a(src, src_size);
+    hdr->source_size = src_size;
+}
+
+static int gm_bytecode_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    (void)L;
+    gm_bytecode_buf_t *buf = (gm_bytecode_buf_t *)ud;
+    if (buf->size + sz > buf->capacity)
+    {
+        size_t cap = buf->capacity ? buf->capacity : 4096;
+        while (cap < buf->size + sz)
+        {
+            cap *= 2;
+        }
+        char *data = (char *)realloc(buf->data, cap);
+        if (data == NULL)
+        {
+            return 1;
+        }
+        buf->data = data;
+        buf->capacity = cap;
+    }
+    memcpy(buf->data + buf->size, p, sz);
+    buf->size += sz;
+    return 0;
+}
+
+int gm_bytecode_dump(lua_State *L, gm_bytecode_buf_t *buf, bool strip)
+{
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+    if (lua_dump(L, gm_bytecode_writer, buf, strip ? 1 : 0) != 0)
+    {
+        free(buf->data);
+        buf->data = NULL;
+        buf->size = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static void gm_bytecode_store(lua_State *L, const char *cache_path, const gm_bytecode_header_t *hdr)
+{
+    gm_bytecode_buf_t buf;
+    // reserve room for the header, the dump is appended after it
+    buf.data = (char *)malloc(4096);
+    buf.size = GM_BYTECODE_HEADER_SIZE;
+    buf.capacity = buf.data ? 4096 : 0;
+    if (buf.data == NULL)
+    {
+        return;
+    }
+
+    if (lua_dump(L, gm_bytecode_writer, &buf, 0) == 0)
+    {
+        memcpy(buf.data, hdr, GM_BYTECODE_HEADER_SIZE);
+        SDL_CreateDirectory(GM_BYTECODE_CACHE_DIR);
+
+        // write a private file and rename it into place, so batch workers loading the
+        // same script never read a half written cache entry
+        char tmp_path[544];
+        SDL_snprintf(tmp_path, sizeof(tmp_path), "%s.%llu.tmp", cache_path, (unsigned long long)SDL_GetCurrentThreadID());
+        if (!SDL_SaveFile(tmp_path, buf.data, buf.size) || !SDL_RenamePath(tmp_path, cache_path))
+        {
+            SDL_Log("could not write bytecode cache %s: %s\n", cache_path, SDL_GetError());
+            SDL_RemovePath(tmp_path);
+        }
+    }
+    free(buf.data);
+}
+
+int gm_bytecode_load(lua_State *L, const char *path)
+{
+    size_t src_size = 0;
+    char *src = (char *)SDL_LoadFile(path, &src_size);
+    if (src == NULL)
+    {
+        lua_pushfstring(L, "cannot open %s", path);
+        return LUA_ERRFILE;
+    }
+
+    char chunk_name[512];
+    char cache_path[512];
+    gm_bytecode_chunk_name(path, chunk_name, sizeof(chunk_name));
+    bool cacheable = gm_bytecode_cache_path(path, cache_path, sizeof(cache_path));
+
+    gm_bytecode_header_t hdr;
+    gm_bytecode_make_header(&hdr, src, src_size);
+
+    // 1. try the cache, any mismatch or load failure falls back to the source
+    size_t cached_size = 0;
+    char *cached = cacheable ? (char *)SDL_LoadFile(cache_path, &cached_size) : NULL;
+    if (cached != NULL)
+    {
+        int status = LUA_ERRSYNTAX;
+        if (cached_size > GM_BYTECODE_HEADER_SIZE && memcmp(cached, &hdr, GM_BYTECODE_HEADER_SIZE) == 0)
+        {
+            status = luaL_loadbufferx(L, cached + GM_BYTECODE_HEADER_SIZE, cached_size - GM_BYTECODE_HEADER_SIZE, chunk_name, "b");
+            if (status != LUA_OK)
+            {
+                lua_pop(L, 1);
+            }
+        }
+        SDL_free(cached);
+        if (status == LUA_OK)
+        {
+            SDL_free(src);
+            return LUA_OK;
+        }
+    }
+
+    // 2. compile from source and refresh the cache
+    int status = luaL_loadbufferx(L, src, src_size, chunk_name, "t");
+    if (status == LUA_OK && cacheable)
+    {
+        gm_bytecode_store(L, cache_path, &hdr);
+    }
+    SDL_free(src);
+    return status;
+}
+
+typedef struct
+{
+    lua_State *L;
+    int compiled;
+    int failed;
+} gm_bytecode_compile_t;
+
+static SDL_EnumerationResult gm_bytecode_compile_entry(void *userdata, const char *dirname, const char *fname)
+{
+    gm_bytecode_compile_t *ctx = (gm_bytecode_compile_t *)userdata;
+
+    // skip hidden entries, which includes the cache directory itself
+    if (fname[0] == '.')
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    char path[512];
+    SDL_snprintf(path, sizeof(path), "%s%s", dirname, fname);
+    const char *rel = (SDL_strncmp(path, "./", 2) == 0) ? path + 2 : path;
+
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        SDL_EnumerateDirectory(path, gm_bytecode_compile_entry, ctx);
+        return SDL_ENUM_CONTINUE;
+    }
+
+    size_t len = SDL_strlen(fname);
+    if (info.type != SDL_PATHTYPE_FILE || len < 5 || SDL_strcmp(fname + len - 4, ".lua") != 0)
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    if (gm_bytecode_load(ctx->L, rel) != LUA_OK)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "compile error: %s\n", lua_tostring(ctx->L, -1));
+        ctx->failed++;
+    }
+    else
+    {
+        SDL_Log("compiled %s\n", rel);
+        ctx->compiled++;
+    }
+    lua_settop(ctx->L, 0);
+    return SDL_ENUM_CONTINUE;
+}
+
+int gm_bytecode_compile_dir(const char *dir)
+{
+    gm_bytecode_compile_t ctx;
+    ctx.L = luaL_newstate();
+    ctx.compiled = 0;
+    ctx.failed = 0;
+    if (!ctx.L)
+    {
+        SDL_Log("failed to create lua state\n");
+        return 1;
+    }
+
+    SDL_EnumerateDirectory(dir, gm_bytecode_compile_entry, &ctx);
+    SDL_Log("bytecode cache: %d compiled, %d failed\n", ctx.compiled, ctx.failed);
+
+    lua_close(ctx.L);
+    return ctx.failed;
+}
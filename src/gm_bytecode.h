@@ -0,0 +1,29 @@
+#ifndef __GM_BYTECODE_H__
+#define __GM_BYTECODE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <lua.h>
+
+#define GM_BYTECODE_CACHE_DIR ".gmcache"
+
+// Compiled chunk as produced by lua_dump, heap allocated.
+typedef struct
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+} gm_bytecode_buf_t;
+
+// Loads a Lua source file as a chunk on top of the stack, like luaL_loadfile.
+// Uses the cached bytecode when the source hash and Lua version match,
+// otherwise compiles the source and refreshes the cache.
+int gm_bytecode_load(lua_State *L, const char *path);
+
+// Dumps the function on top of the stack into buf, the caller frees buf->data.
+int gm_bytecode_dump(lua_State *L, gm_bytecode_buf_t *buf, bool strip);
+
+// Precompiles every .lua file below dir into the cache, returns the number of failures.
+int gm_bytecode_compile_dir(const char *dir);
+
+#endif // __GM_BYTECODE_H__
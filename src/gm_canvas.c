@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_canvas.h"
+
+int gm_canvas_init(gm_canvas_ctx_t **ctx, SDL_Renderer *renderer, gm_lua_game_t *game)
+{
+    (*ctx) = (gm_canvas_ctx_t *)calloc(sizeof(gm_canvas_ctx_t), 1);
+    if ((*ctx) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_canvas_ctx_t.\n");
+        return 1;
+    }
+
+    (*ctx)->renderer = renderer;
+    (*ctx)->game = game;
+    return 0;
+}
+
+void gm_canvas_shutdown(gm_canvas_ctx_t *ctx)
+{
+    if (ctx)
+    {
+        free(ctx);
+    }
+}
+
+static gm_canvas_ctx_t *gm_canvas_upvalue(lua_State *L)
+{
+    return (gm_canvas_ctx_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static gm_canvas_t *gm_canvas_check(lua_State *L, int idx)
+{
+    gm_canvas_t *cvs = (gm_canvas_t *)luaL_checkudata(L, idx, GM_CANVAS_MT);
+    luaL_argcheck(L, cvs->texture != NULL, idx, "canvas has been released");
+    return cvs;
+}
+
+static void gm_canvas_set_target(gm_canvas_ctx_t *ctx, SDL_Texture *texture, int w, int h)
+{
+    gm_lua_game_t *game = ctx->game;
+    if (game->target == texture)
+    {
+        return;
+    }
+    game->target = texture;
+    game->target_w = w;
+    game->target_h = h;
+    SDL_SetRenderTarget(ctx->renderer, texture);
+}
+
+// gm.newCanvas(w, h), starts out transparent
+static int gm_canvas_lua_new(lua_State *L)
+{
+    gm_canvas_ctx_t *ctx = gm_canvas_upvalue(L);
+    lua_Integer w = luaL_checkinteger(L, 1);
+    lua_Integer h = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, w > 0 && w <= GM_CANVAS_MAX_SIZE, 1, "width out of range");
+    luaL_argcheck(L, h > 0 && h <= GM_CANVAS_MAX_SIZE, 2, "height out of range");
+
+    gm_canvas_t *cvs = (gm_canvas_t *)lua_newuserdatauv(L, sizeof(gm_canvas_t), 0);
+    memset(cvs, 0, sizeof(gm_canvas_t));
+    luaL_setmetatable(L, GM_CANVAS_MT);
+
+    cvs->texture = SDL_CreateTexture(ctx->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, (int)w, (int)h);
+    if (cvs->texture == NULL)
+    {
+        return luaL_error(L, "could not create a %dx%d canvas: %s", (int)w, (int)h, SDL_GetError());
+    }
+    cvs->w = (int)w;
+    cvs->h = (int)h;
+    SDL_SetTextureScaleMode(cvs->texture, SDL_SCALEMODE_NEAREST);
+    SDL_SetTextureBlendMode(cvs->texture, SDL_BLENDMODE_BLEND);
+
+    // clear it once, without disturbing the current target or draw colour
+    gm_lua_game_t *game = ctx->game;
+    SDL_SetRenderTarget(ctx->renderer, cvs->texture);
+    gm_lua_set_draw_color(game, 0x00000000u);
+    SDL_RenderClear(ctx->renderer);
+    SDL_SetRenderTarget(ctx->renderer, game->target);
+    return 1;
+}
+
+static int gm_canvas_lua_gc(lua_State *L)
+{
+    gm_canvas_ctx_t *ctx = gm_canvas_upvalue(L);
+    gm_canvas_t *cvs = (gm_canvas_t *)luaL_checkudata(L, 1, GM_CANVAS_MT);
+    if (cvs->texture)
+    {
+        // never leave the renderer pointing at a destroyed texture
+        if (ctx->game->target == cvs->texture)
+        {
+            gm_canvas_set_target(ctx, ctx->game->canvas_texture, ctx->game->w, ctx->game->h);
+        }
+        SDL_DestroyTexture(cvs->texture);
+        cvs->texture = NULL;
+    }
+    return 0;
+}
+
+static int gm_canvas_lua_width(lua_State *L)
+{
+    lua_pushinteger(L, gm_canvas_check(L, 1)->w);
+    return 1;
+}
+
+static int gm_canvas_lua_height(lua_State *L)
+{
+    lua_pushinteger(L, gm_canvas_check(L, 1)->h);
+    return 1;
+}
+
+// gm:setTarget(canvas), or gm:setTarget() to draw into the game canvas again
+static int gm_canvas_lua_set_target(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_canvas_ctx_t *ctx = gm_canvas_upvalue(L);
+    if (lua_isnoneornil(L, 2))
+    {
+        gm_canvas_set_target(ctx, ctx->game->canvas_texture, ctx->game->w, ctx->game->h);
+        return 0;
+    }
+
+    gm_canvas_t *cvs = gm_canvas_check(L, 2);
+    gm_canvas_set_target(ctx, cvs->texture, cvs->w, cvs->h);
+    return 0;
+}
+
+// gm:drawCanvas(canvas, x, y [, scale])
+static int gm_canvas_lua_draw(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_canvas_ctx_t *ctx = gm_canvas_upvalue(L);
+    gm_canvas_t *cvs = gm_canvas_check(L, 2);
+    luaL_argcheck(L, cvs->texture != ctx->game->target, 2, "cannot draw a canvas into itself");
+
+    float scale = (float)luaL_optnumber(L, 5, 1.0);
+    SDL_FRect dst = {
+        .x = (float)luaL_checknumber(L, 3),
+        .y = (float)luaL_checknumber(L, 4),
+        .w = (float)cvs->w * scale,
+        .h = (float)cvs->h * scale};
+    SDL_RenderTexture(ctx->renderer, cvs->texture, NULL, &dst);
+    return 0;
+}
+
+void gm_canvas_register_lua(gm_canvas_ctx_t *ctx, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"width", gm_canvas_lua_width},
+        {"height", gm_canvas_lua_height},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"newCanvas", gm_canvas_lua_new},
+        {"setTarget", gm_canvas_lua_set_target},
+        {"drawCanvas", gm_canvas_lua_draw},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_CANVAS_MT);
+    lua_pushlightuserdata(L, ctx);
+    lua_pushcclosure(L, gm_canvas_lua_gc, 1);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, ctx);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
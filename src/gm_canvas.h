@@ -0,0 +1,32 @@
+#ifndef __GM_CANVAS_H__
+#define __GM_CANVAS_H__
+
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_lua.h"
+
+#define GM_CANVAS_MT "gm.canvas"
+#define GM_CANVAS_MAX_SIZE 4096
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+    gm_lua_game_t *game;
+} gm_canvas_ctx_t;
+
+// Lua userdata behind gm.newCanvas, a render target texture freed when collected.
+typedef struct
+{
+    SDL_Texture *texture;
+    int w;
+    int h;
+} gm_canvas_t;
+
+int gm_canvas_init(gm_canvas_ctx_t **ctx, SDL_Renderer *renderer, gm_lua_game_t *game);
+void gm_canvas_shutdown(gm_canvas_ctx_t *ctx);
+
+// Adds gm.newCanvas, gm:setTarget and gm:drawCanvas to the game API.
+void gm_canvas_register_lua(gm_canvas_ctx_t *ctx, lua_State *L);
+
+#endif // __GM_CANVAS_H__
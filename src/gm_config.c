@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "gm_config.h"
+#include "gm_batch.h"
+#include "gm_profile.h"
+#include "gm_watchdog.h"
+#include "gm_util.h"
+
+#define GM_CONFIG_MIN_CNV 16
+#define GM_CONFIG_MAX_CNV 4096
+#define GM_CONFIG_MAX_SCALE 16
+#define GM_CONFIG_MAX_AUDIO_FRAMES 8192
+
+void gm_config_defaults(gm_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(gm_config_t));
+    cfg->cvs_width = GM_CONFIG_DEFAULT_CNV_W;
+    cfg->cvs_height = GM_CONFIG_DEFAULT_CNV_H;
+    cfg->scale = GM_CONFIG_DEFAULT_SCALE;
+    cfg->renderer[0] = '\0';
+    cfg->vsync = true;
+    cfg->audio = true;
+    cfg->audio_frames = 0;
+    cfg->batch_frames = 1;
+    cfg->profile_hz = GM_PROFILE_DEFAULT_HZ;
+    cfg->watchdog_ms = GM_WATCHDOG_DEFAULT_MS;
+    SDL_strlcpy(cfg->pack_path, GM_PACK_FILE, sizeof(cfg->pack_path));
+}
+
+static bool gm_config_set_int(int *field, int value, int min, int max, const char *name)
+{
+    if (value < min || value > max)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid %s %d, expected %d-%d.\n", name, value, min, max);
+        return false;
+    }
+    *field = value;
+    return true;
+}
+
+static void gm_config_set_renderer(gm_config_t *cfg, const char *name)
+{
+    // "auto" and "" both mean "let SDL choose"
+    if (name == NULL || SDL_strcmp(name, "auto") == 0)
+    {
+        cfg->renderer[0] = '\0';
+        return;
+    }
+    SDL_strlcpy(cfg->renderer, name, sizeof(cfg->renderer));
+}
+
+static void gm_config_push_table(lua_State *L, const gm_config_t *cfg)
+{
+    lua_newtable(L);
+    lua_pushinteger(L, cfg->cvs_width);
+    lua_setfield(L, -2, "width");
+    lua_pushinteger(L, cfg->cvs_height);
+    lua_setfield(L, -2, "height");
+    lua_pushinteger(L, cfg->scale);
+    lua_setfield(L, -2, "scale");
+    lua_pushstring(L, cfg->renderer[0] ? cfg->renderer : "auto");
+    lua_setfield(L, -2, "renderer");
+    lua_pushboolean(L, cfg->vsync);
+    lua_setfield(L, -2, "vsync");
+    lua_pushboolean(L, cfg->audio);
+    lua_setfield(L, -2, "audio");
+    lua_pushinteger(L, cfg->audio_frames);
+    lua_setfield(L, -2, "audioBuffer");
+}
+
+static int gm_config_read_table(lua_State *L, int idx, gm_config_t *cfg)
+{
+    int bad = 0;
+
+    lua_getfield(L, idx, "width");
+    if (lua_isinteger(L, -1))
+    {
+        bad |= !gm_config_set_int(&cfg->cvs_width, (int)lua_tointeger(L, -1), GM_CONFIG_MIN_CNV, GM_CONFIG_MAX_CNV, "width");
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "height");
+    if (lua_isinteger(L, -1))
+    {
+        bad |= !gm_config_set_int(&cfg->cvs_height, (int)lua_tointeger(L, -1), GM_CONFIG_MIN_CNV, GM_CONFIG_MAX_CNV, "height");
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "scale");
+    if (lua_isinteger(L, -1))
+    {
+        bad |= !gm_config_set_int(&cfg->scale, (int)lua_tointeger(L, -1), 1, GM_CONFIG_MAX_SCALE, "scale");
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "renderer");
+    if (lua_type(L, -1) == LUA_TSTRING)
+    {
+        gm_config_set_renderer(cfg, lua_tostring(L, -1));
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "vsync");
+    if (lua_isboolean(L, -1))
+    {
+        cfg->vsync = lua_toboolean(L, -1);
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "audio");
+    if (lua_isboolean(L, -1))
+    {
+        cfg->audio = lua_toboolean(L, -1);
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "audioBuffer");
+    if (lua_isinteger(L, -1))
+    {
+        bad |= !gm_config_set_int(&cfg->audio_frames, (int)lua_tointeger(L, -1), 0, GM_CONFIG_MAX_AUDIO_FRAMES, "audio buffer");
+    }
+    lua_pop(L, 1);
+
+    lua_getfield(L, idx, "watchdog");
+    if (lua_isinteger(L, -1))
+    {
+        bad |= !gm_config_set_int(&cfg->watchdog_ms, (int)lua_tointeger(L, -1), 0, GM_WATCHDOG_MAX_MS, "watchdog budget");
+    }
+    lua_pop(L, 1);
+
+    return bad;
+}
+
+int gm_config_load_file(gm_config_t *cfg, const char *path, const gm_pack_t *pack)
+{
+    // a loose file on disk wins over the packed copy
+    size_t packed_size = 0;
+    const char *packed = NULL;
+    if (!file_exists(path))
+    {
+        packed = (const char *)gm_pack_find(pack, path, &packed_size);
+        if (packed == NULL)
+        {
+            return 0;
+        }
+    }
+
+    lua_State *L = luaL_newstate();
+    if (!L)
+    {
+        SDL_Log("failed to create lua state for %s\n", path);
+        return 1;
+    }
+
+    luaL_requiref(L, "_G", luaopen_base, 1);
+    lua_pop(L, 1);
+    luaL_requiref(L, LUA_MATHLIBNAME, luaopen_math, 1);
+    lua_pop(L, 1);
+
+    int ret = 0;
+    int status = packed ? luaL_loadbufferx(L, packed, packed_size, path, "b") : luaL_loadfile(L, path);
+    if (status != LUA_OK || lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s error: %s\n", path, lua_tostring(L, -1));
+        lua_close(L);
+        return 1;
+    }
+
+    lua_getglobal(L, "conf");
+    if (lua_isfunction(L, -1))
+    {
+        gm_config_push_table(L, cfg);
+        lua_pushvalue(L, -1);
+        lua_insert(L, -3);
+
+        // conf(c) edits the table in place, the table stays below the call
+        if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s conf() error: %s\n", path, lua_tostring(L, -1));
+            ret = 1;
+        }
+        else
+        {
+            ret = gm_config_read_table(L, -1, cfg);
+            SDL_Log("Loaded configuration from %s\n", path);
+        }
+    }
+    else
+    {
+        SDL_Log("%s does not define conf(c), ignoring it.\n", path);
+    }
+
+    lua_close(L);
+    return ret;
+}
+
+static const char *gm_config_next_arg(int argc, char *argv[], int *i)
+{
+    if (*i + 1 >= argc)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Missing value for %s\n", argv[*i]);
+        return NULL;
+    }
+    (*i)++;
+    return argv[*i];
+}
+
+int gm_config_parse_args(gm_config_t *cfg, int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = NULL;
+
+        if (SDL_strcmp(arg, "--help") == 0 || SDL_strcmp(arg, "-h") == 0)
+        {
+            gm_config_print_usage(argv[0]);
+            return 2;
+        }
+        else if (i == 1 && SDL_strcmp(arg, "pack") == 0)
+        {
+            cfg->pack_build = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+            {
+                SDL_strlcpy(cfg->pack_path, argv[++i], sizeof(cfg->pack_path));
+            }
+        }
+        else if (SDL_strcmp(arg, "--pack") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            SDL_strlcpy(cfg->pack_path, value, sizeof(cfg->pack_path));
+        }
+        else if (SDL_strcmp(arg, "--startup-profile") == 0)
+        {
+            cfg->startup_profile = true;
+        }
+        else if (SDL_strcmp(arg, "--compile") == 0)
+        {
+            cfg->compile_only = true;
+        }
+        else if (SDL_strcmp(arg, "--vsync") == 0)
+        {
+            cfg->vsync = true;
+        }
+        else if (SDL_strcmp(arg, "--no-vsync") == 0)
+        {
+            cfg->vsync = false;
+        }
+        else if (SDL_strcmp(arg, "--record") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            SDL_strlcpy(cfg->record_path, value, sizeof(cfg->record_path));
+        }
+        else if (SDL_strcmp(arg, "--replay") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            SDL_strlcpy(cfg->replay_path, value, sizeof(cfg->replay_path));
+        }
+        else if (SDL_strcmp(arg, "--headless") == 0)
+        {
+            cfg->headless = true;
+        }
+        else if (SDL_strcmp(arg, "--batch") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            SDL_strlcpy(cfg->batch_path, value, sizeof(cfg->batch_path));
+        }
+        else if (SDL_strcmp(arg, "--jobs") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->batch_jobs, SDL_atoi(value), 0, GM_BATCH_MAX_THREADS, "jobs"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--frames") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->batch_frames, SDL_atoi(value), 1, GM_BATCH_MAX_FRAMES, "frames"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--profile") == 0)
+        {
+            cfg->profile = true;
+        }
+        else if (SDL_strcmp(arg, "--profile-hz") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->profile_hz, SDL_atoi(value), 0, GM_PROFILE_MAX_HZ, "profile rate"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--watchdog") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->watchdog_ms, SDL_atoi(value), 0, GM_WATCHDOG_MAX_MS, "watchdog budget"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--trace") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            SDL_strlcpy(cfg->trace_path, value, sizeof(cfg->trace_path));
+        }
+        else if (SDL_strcmp(arg, "--no-audio") == 0)
+        {
+            cfg->audio = false;
+        }
+        else if (SDL_strcmp(arg, "--audio-buffer") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->audio_frames, SDL_atoi(value), 0, GM_CONFIG_MAX_AUDIO_FRAMES, "audio buffer"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--width") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->cvs_width, SDL_atoi(value), GM_CONFIG_MIN_CNV, GM_CONFIG_MAX_CNV, "width"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--height") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->cvs_height, SDL_atoi(value), GM_CONFIG_MIN_CNV, GM_CONFIG_MAX_CNV, "height"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--scale") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL ||
+                !gm_config_set_int(&cfg->scale, SDL_atoi(value), 1, GM_CONFIG_MAX_SCALE, "scale"))
+            {
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(arg, "--renderer") == 0)
+        {
+            if ((value = gm_config_next_arg(argc, argv, &i)) == NULL)
+            {
+                return 1;
+            }
+            gm_config_set_renderer(cfg, value);
+        }
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown argument: %s\n", arg);
+            gm_config_print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cfg->record_path[0] && cfg->replay_path[0])
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "--record and --replay cannot be combined.\n");
+        return 1;
+    }
+    if (cfg->batch_path[0] && (cfg->record_path[0] || cfg->replay_path[0]))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "--batch cannot be combined with --record or --replay.\n");
+        return 1;
+    }
+    if (cfg->headless)
+    {
+        if (!cfg->replay_path[0])
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "--headless needs --replay.\n");
+            return 1;
+        }
+        // nothing to see or hear, so run unthrottled
+        cfg->vsync = false;
+        cfg->audio = false;
+    }
+    return 0;
+}
+
+void gm_config_print_usage(const char *program)
+{
+    printf("usage: %s [options]\n", program);
+    printf("       %s pack [out.gmpak]\n", program);
+    printf("  --width N         canvas width in pixels (default %d)\n", GM_CONFIG_DEFAULT_CNV_W);
+    printf("  --height N        canvas height in pixels (default %d)\n", GM_CONFIG_DEFAULT_CNV_H);
+    printf("  --scale N         integer window scale factor (default %d)\n", GM_CONFIG_DEFAULT_SCALE);
+    printf("  --renderer NAME   SDL render driver, e.g. software, opengl (default auto)\n");
+    printf("  --vsync           enable vsync (default)\n");
+    printf("  --no-vsync        disable vsync\n");
+    printf("  --no-audio        do not open an audio device\n");
+    printf("  --audio-buffer N  audio device buffer in sample frames, 0 for the SDL default\n");
+    printf("  --record FILE     record dt, input, random seed and reloads of this session\n");
+    printf("  --replay FILE     replay a recorded session frame by frame\n");
+    printf("  --headless        with --replay: no visible window, no vsync, no audio\n");
+    printf("  --batch FILE      render each `script [seed [out.png]]` line of FILE offline and exit\n");
+    printf("  --jobs N          batch worker threads, 0 for one per core (default)\n");
+    printf("  --frames N        frames drawn per batch job before saving (default 1)\n");
+    printf("  --profile         start the Lua profiler at launch (F9 toggles it)\n");
+    printf("  --profile-hz N    profiler samples per second, 0 for one per %d instructions\n", GM_PROFILE_COUNT);
+    printf("  --watchdog MS     stop Lua code running longer than MS at a time, 0 for never (default %d)\n", GM_WATCHDOG_DEFAULT_MS);
+    printf("  --trace FILE      write a Chrome trace of the frame phases at exit (F10 writes it now)\n");
+    printf("  --compile         precompile all .lua files into the bytecode cache and exit\n");
+    printf("  --startup-profile print the time spent in each startup phase\n");
+    printf("  --pack FILE       run from the given asset pack (default %s if present)\n", GM_PACK_FILE);
+
+    printf("available render drivers:");
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); i++)
+    {
+        printf(" %s", SDL_GetRenderDriver(i));
+    }
+    printf("\n");
+}
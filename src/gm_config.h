@@ -0,0 +1,72 @@
+#ifndef __GM_CONFIG_H__
+#define __GM_CONFIG_H__
+
+#include <stdbool.h>
+
+#include "gm_pack.h"
+
+#define GM_CONFIG_FILE "conf.lua"
+
+#define GM_CONFIG_DEFAULT_CNV_W 320
+#define GM_CONFIG_DEFAULT_CNV_H 240
+#define GM_CONFIG_DEFAULT_SCALE 2
+
+typedef struct
+{
+    // canvas resolution in game pixels
+    int cvs_width;
+    int cvs_height;
+
+    // integer scale factor from canvas to window pixels
+    int scale;
+
+    // SDL render driver name, empty to let SDL pick
+    char renderer[32];
+    bool vsync;
+
+    // precompile all modules into the bytecode cache and exit
+    bool compile_only;
+
+    // asset pack to run from, and the `gmcore pack [out]` build command
+    char pack_path[256];
+    bool pack_build;
+
+    // print the duration of each startup phase after the first frame
+    bool startup_profile;
+
+    // audio output, audio_frames is the device buffer size, 0 lets SDL pick
+    bool audio;
+    int audio_frames;
+
+    // record a session, or replay one (optionally headless, as fast as possible)
+    char record_path[256];
+    char replay_path[256];
+    bool headless;
+
+    // render every job of a batch list offline, batch_jobs threads (0 for one per core)
+    char batch_path[256];
+    int batch_jobs;
+    int batch_frames;
+
+    // start the Lua sampling profiler at launch, sampling profile_hz times a second
+    bool profile;
+    int profile_hz;
+
+    // Lua code running longer than this in one go is stopped, 0 turns the watchdog off
+    int watchdog_ms;
+
+    // Chrome trace JSON of the frame phases, written at exit and on F10
+    char trace_path[256];
+} gm_config_t;
+
+void gm_config_defaults(gm_config_t *cfg);
+
+// Runs conf(c) from the given Lua file, if present on disk or in the pack, in a throwaway Lua state.
+int gm_config_load_file(gm_config_t *cfg, const char *path, const gm_pack_t *pack);
+
+// Applies command line flags on top of the current configuration.
+int gm_config_parse_args(gm_config_t *cfg, int argc, char *argv[]);
+
+void gm_config_print_usage(const char *program);
+
+#endif // __GM_CONFIG_H__
@@ -15,7 +15,7 @@ static void gm_console_destroy_text_cache(gm_console_t *con)
     }
 }
 
-int gm_console_init(gm_console_t **con)
+int gm_console_init(gm_console_t **con, gm_font_t *font)
 {
     (*con) = (gm_console_t *)calloc(sizeof(gm_console_t), 1);
     if ((*con) == NULL)
@@ -31,21 +31,9 @@ int gm_console_init(gm_console_t **con)
     c->overlay_enabled = true;
     c->overlay_color = (SDL_Color){0, 0, 0, 160};
     c->text[0] = '\0';
-    const char *base_path = SDL_GetBasePath();
-    if (base_path)
-    {
-        char font_path[1024];
-
-        SDL_snprintf(font_path, sizeof(font_path), "%s/SourceCodePro-Regular.ttf", base_path);
 
-        c->font = TTF_OpenFont(font_path, 10.0f);
-        if (c->font == NULL)
-        {
-            SDL_Log("Failed to load font: %s", SDL_GetError());
-            return -1;
-        }
-        SDL_Log("Loading font from: %s\n", font_path);
-    }
+    // the font is shared and only opened once the console first renders text
+    c->font = font;
     return 0;
 }
 
@@ -140,8 +128,13 @@ void gm_console_draw(gm_console_t *con, SDL_Renderer *renderer)
     // create text surface and texture if not already created
     if (!con->textSurface)
     {
+        TTF_Font *font = gm_font_get(con->font);
+        if (font == NULL)
+        {
+            return;
+        }
         SDL_Color fg = {255, 255, 255, 255};
-        con->textSurface = TTF_RenderText_Blended_Wrapped(con->font, con->text, strlen(con->text), fg, 400);
+        con->textSurface = TTF_RenderText_Blended_Wrapped(font, con->text, strlen(con->text), fg, 400);
         if (con->textSurface)
         {
             con->textTexture = SDL_CreateTextureFromSurface(renderer, con->textSurface);
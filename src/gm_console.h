@@ -5,18 +5,20 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 
+#include "gm_font.h"
+
 typedef struct
 {
     SDL_Surface *textSurface;
     SDL_Texture *textTexture;
-    TTF_Font *font;
+    gm_font_t *font;
     bool show;
     bool overlay_enabled;
     SDL_Color overlay_color;
     char text[1024];
 } gm_console_t;
 
-int gm_console_init(gm_console_t **con);
+int gm_console_init(gm_console_t **con, gm_font_t *font);
 
 bool gm_console_toggle(gm_console_t *con);
 void gm_console_show(gm_console_t *con);
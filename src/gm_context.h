@@ -2,9 +2,11 @@
 #define __GM_CONTEXT_H__
 
 #include <SDL3/SDL.h>
-#include <SDL3_ttf/SDL_ttf.h>
 #include <lua.h>
 
+#include "gm_pack.h"
+#include "gm_font.h"
+
 typedef struct
 {
     // SDL window, renderer, and texture
@@ -12,8 +14,11 @@ typedef struct
     SDL_Renderer *renderer;
     SDL_Texture *texture;
 
-    // SDL font
-    TTF_Font *font;
+    // engine font, opened lazily
+    gm_font_t *font;
+
+    // optional memory-mapped asset pack
+    gm_pack_t *pack;
 
     // game loop
     int quit;
@@ -23,6 +28,7 @@ typedef struct
     // canvas dimensions
     int cvs_width;
     int cvs_height;
+    int scale;
     SDL_FRect cvs_on_win_rect;
 
     // window dimensions
@@ -0,0 +1,323 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_fill.h"
+#include "gm_lua.h"
+
+// 8x8 ordered dither thresholds, 0-63
+static const uint8_t gm_fill_bayer[8][8] = {
+    {0, 32, 8, 40, 2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44, 4, 36, 14, 46, 6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    {3, 35, 11, 43, 1, 33, 9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+static const char *gm_fill_noise_modes[] = {"mono", "rgb", NULL};
+
+int gm_fill_init(gm_fill_t **fill, SDL_Renderer *renderer, int w, int h)
+{
+    (*fill) = (gm_fill_t *)calloc(sizeof(gm_fill_t), 1);
+    if ((*fill) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_fill_t.\n");
+        return 1;
+    }
+
+    // the buffer and texture are created on the first fill
+    (*fill)->renderer = renderer;
+    (*fill)->w = w;
+    (*fill)->h = h;
+    (*fill)->seed = 1;
+    return 0;
+}
+
+void gm_fill_shutdown(gm_fill_t *fill)
+{
+    if (fill)
+    {
+        if (fill->scratch)
+        {
+            SDL_DestroyTexture(fill->scratch);
+        }
+        free(fill->pixels);
+        free(fill);
+    }
+}
+
+static bool gm_fill_ensure(gm_fill_t *fill)
+{
+    if (fill->pixels == NULL)
+    {
+        fill->pixels = (uint32_t *)malloc(sizeof(uint32_t) * (size_t)fill->w * (size_t)fill->h);
+        if (fill->pixels == NULL)
+        {
+            SDL_Log("Unable to allocate the fill buffer.\n");
+            return false;
+        }
+    }
+    if (fill->scratch == NULL)
+    {
+        fill->scratch = SDL_CreateTexture(fill->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, fill->w, fill->h);
+        if (fill->scratch == NULL)
+        {
+            SDL_Log("failed to create fill texture: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureScaleMode(fill->scratch, SDL_SCALEMODE_NEAREST);
+
+        // opaque pixels replace the canvas, transparent ones (dither gaps) leave it alone
+        SDL_SetTextureBlendMode(fill->scratch, SDL_BLENDMODE_BLEND);
+    }
+    return true;
+}
+
+// Integer hash with good avalanche (lowbias32). Each pixel hashes its own index,
+// so there is no dependency between iterations and the loops vectorize.
+static inline uint32_t gm_fill_hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint32_t gm_fill_pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return (r << 24) | (g << 16) | (b << 8) | a;
+}
+
+void gm_fill_noise(gm_fill_t *fill, const SDL_Rect *rect, uint32_t seed, gm_fill_noise_mode_t mode)
+{
+    uint32_t key = gm_fill_hash(seed * 0x9e3779b9u + 0x632be5abu);
+    for (int y = rect->y; y < rect->y + rect->h; y++)
+    {
+        uint32_t *row = fill->pixels + (size_t)y * (size_t)fill->w;
+        uint32_t base = (uint32_t)y * (uint32_t)fill->w + key;
+        if (mode == GM_FILL_NOISE_RGB)
+        {
+            for (int x = rect->x; x < rect->x + rect->w; x++)
+            {
+                row[x] = gm_fill_hash(base + (uint32_t)x) | 0xffu;
+            }
+        }
+        else
+        {
+            for (int x = rect->x; x < rect->x + rect->w; x++)
+            {
+                uint32_t v = gm_fill_hash(base + (uint32_t)x) >> 24;
+                row[x] = v * 0x01010100u | 0xffu;
+            }
+        }
+    }
+}
+
+static inline uint32_t gm_fill_lerp(uint32_t c0, uint32_t c1, uint32_t t)
+{
+    // t is 16.16 fixed point in [0, 1]
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int a = (int)((c0 >> shift) & 0xffu);
+        int b = (int)((c1 >> shift) & 0xffu);
+        out |= (uint32_t)(a + (((b - a) * (int)t) >> 16)) << shift;
+    }
+    return out;
+}
+
+void gm_fill_gradient(gm_fill_t *fill, const SDL_Rect *rect, uint32_t c0, uint32_t c1, bool vertical, bool dither)
+{
+    // t = i / (steps - 1) in 16.16 fixed point, as a multiply instead of a divide per pixel
+    int steps = vertical ? rect->h : rect->w;
+    uint64_t step = ((uint64_t)1 << 32) / (uint64_t)((steps > 1) ? steps - 1 : 1);
+
+    for (int y = rect->y; y < rect->y + rect->h; y++)
+    {
+        uint32_t *row = fill->pixels + (size_t)y * (size_t)fill->w;
+        if (dither)
+        {
+            // two colours only, mixed by an ordered pattern
+            const uint8_t *bayer = gm_fill_bayer[y & 7];
+            for (int x = rect->x; x < rect->x + rect->w; x++)
+            {
+                uint64_t i = vertical ? (uint64_t)(y - rect->y) : (uint64_t)(x - rect->x);
+                uint32_t t = (uint32_t)((i * step) >> 16);
+                row[x] = ((t * 64u) >> 16) > bayer[x & 7] ? c1 : c0;
+            }
+        }
+        else if (vertical)
+        {
+            uint32_t c = gm_fill_lerp(c0, c1, (uint32_t)(((uint64_t)(y - rect->y) * step) >> 16));
+            for (int x = rect->x; x < rect->x + rect->w; x++)
+            {
+                row[x] = c;
+            }
+        }
+        else if (y == rect->y)
+        {
+            for (int x = rect->x; x < rect->x + rect->w; x++)
+            {
+                row[x] = gm_fill_lerp(c0, c1, (uint32_t)(((uint64_t)(x - rect->x) * step) >> 16));
+            }
+        }
+        else
+        {
+            // every row of a horizontal gradient is the same
+            memcpy(row + rect->x, fill->pixels + (size_t)rect->y * (size_t)fill->w + rect->x, sizeof(uint32_t) * (size_t)rect->w);
+        }
+    }
+}
+
+void gm_fill_dither(gm_fill_t *fill, const SDL_Rect *rect, float level, uint32_t color)
+{
+    uint32_t threshold = (uint32_t)(SDL_clamp(level, 0.0f, 1.0f) * 64.0f);
+    for (int y = rect->y; y < rect->y + rect->h; y++)
+    {
+        uint32_t *row = fill->pixels + (size_t)y * (size_t)fill->w;
+        const uint8_t *bayer = gm_fill_bayer[y & 7];
+        for (int x = rect->x; x < rect->x + rect->w; x++)
+        {
+            row[x] = (bayer[x & 7] < threshold) ? color : 0u;
+        }
+    }
+}
+
+void gm_fill_present(gm_fill_t *fill, const SDL_Rect *rect)
+{
+    const uint32_t *src = fill->pixels + (size_t)rect->y * (size_t)fill->w + (size_t)rect->x;
+    SDL_UpdateTexture(fill->scratch, rect, src, fill->w * (int)sizeof(uint32_t));
+
+    SDL_FRect area = {
+        .x = (float)rect->x,
+        .y = (float)rect->y,
+        .w = (float)rect->w,
+        .h = (float)rect->h};
+    SDL_RenderTexture(fill->renderer, fill->scratch, &area, &area);
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_fill_t *gm_fill_upvalue(lua_State *L)
+{
+    return (gm_fill_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static uint32_t gm_fill_check_color(lua_State *L, int idx)
+{
+    uint32_t c[3];
+    for (int i = 0; i < 3; i++)
+    {
+        lua_Integer v = luaL_checkinteger(L, idx + i);
+        c[i] = (uint32_t)SDL_clamp(v, 0, 255);
+    }
+    return gm_fill_pack(c[0], c[1], c[2], 0xffu);
+}
+
+// Reads an integer argument clamped to the int32 range, so sums of two fit in 64 bits.
+static inline int64_t gm_fill_check_coord(lua_State *L, int idx)
+{
+    lua_Integer v = luaL_checkinteger(L, idx);
+    return (int64_t)SDL_clamp(v, (lua_Integer)INT32_MIN, (lua_Integer)INT32_MAX);
+}
+
+// Reads x, y, w, h from arguments 2-5 and clips them to the render target, false if nothing is left.
+static bool gm_fill_check_rect(lua_State *L, gm_fill_t *fill, SDL_Rect *rect)
+{
+    gm_lua_game_t *game = (gm_lua_game_t *)luaL_checkudata(L, 1, GM_GAME_MT);
+
+    // in 64 bits, x + w and y + h would overflow an int for huge sizes
+    int64_t x = gm_fill_check_coord(L, 2);
+    int64_t y = gm_fill_check_coord(L, 3);
+    int64_t x1 = x + gm_fill_check_coord(L, 4);
+    int64_t y1 = y + gm_fill_check_coord(L, 5);
+
+    x = SDL_max(x, 0);
+    y = SDL_max(y, 0);
+    x1 = SDL_min(x1, (int64_t)SDL_min(fill->w, game->target_w));
+    y1 = SDL_min(y1, (int64_t)SDL_min(fill->h, game->target_h));
+    if (x >= x1 || y >= y1)
+    {
+        return false;
+    }
+
+    rect->x = (int)x;
+    rect->y = (int)y;
+    rect->w = (int)(x1 - x);
+    rect->h = (int)(y1 - y);
+    return gm_fill_ensure(fill);
+}
+
+// gm:fillNoise(x, y, w, h [, seed [, "mono"|"rgb"]])
+static int gm_fill_lua_noise(lua_State *L)
+{
+    gm_fill_t *fill = gm_fill_upvalue(L);
+    SDL_Rect rect;
+    if (!gm_fill_check_rect(L, fill, &rect))
+    {
+        return 0;
+    }
+
+    uint32_t seed = lua_isnoneornil(L, 6) ? fill->seed++ : (uint32_t)luaL_checkinteger(L, 6);
+    int mode = luaL_checkoption(L, 7, "mono", gm_fill_noise_modes);
+    gm_fill_noise(fill, &rect, seed, (gm_fill_noise_mode_t)mode);
+    gm_fill_present(fill, &rect);
+    return 0;
+}
+
+// gm:fillGradient(x, y, w, h, r1, g1, b1, r2, g2, b2 [, vertical [, dither]])
+static int gm_fill_lua_gradient(lua_State *L)
+{
+    gm_fill_t *fill = gm_fill_upvalue(L);
+    SDL_Rect rect;
+    if (!gm_fill_check_rect(L, fill, &rect))
+    {
+        return 0;
+    }
+
+    uint32_t c0 = gm_fill_check_color(L, 6);
+    uint32_t c1 = gm_fill_check_color(L, 9);
+    gm_fill_gradient(fill, &rect, c0, c1, lua_toboolean(L, 12), lua_toboolean(L, 13));
+    gm_fill_present(fill, &rect);
+    return 0;
+}
+
+// gm:fillDither(x, y, w, h, level [, r, g, b]), pixels outside the pattern are left untouched
+static int gm_fill_lua_dither(lua_State *L)
+{
+    gm_lua_game_t *game = (gm_lua_game_t *)luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_fill_t *fill = gm_fill_upvalue(L);
+    SDL_Rect rect;
+    if (!gm_fill_check_rect(L, fill, &rect))
+    {
+        return 0;
+    }
+
+    float level = (float)luaL_checknumber(L, 6);
+    uint32_t color = (lua_gettop(L) >= 9) ? gm_fill_check_color(L, 7) : (game->color | 0xffu);
+    gm_fill_dither(fill, &rect, level, color);
+    gm_fill_present(fill, &rect);
+    return 0;
+}
+
+void gm_fill_register_lua(gm_fill_t *fill, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"fillNoise", gm_fill_lua_noise},
+        {"fillGradient", gm_fill_lua_gradient},
+        {"fillDither", gm_fill_lua_dither},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, fill);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
@@ -0,0 +1,43 @@
+#ifndef __GM_FILL_H__
+#define __GM_FILL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+// Region fills computed on the CPU into a canvas-sized buffer, then uploaded and
+// drawn with one texture copy. Pixels are packed RGBA8888 (0xRRGGBBAA).
+typedef struct
+{
+    SDL_Renderer *renderer;
+    SDL_Texture *scratch;
+    uint32_t *pixels;
+    int w;
+    int h;
+
+    // default noise seed, advanced on every call so noise animates, and replays repeat
+    uint32_t seed;
+} gm_fill_t;
+
+typedef enum
+{
+    GM_FILL_NOISE_MONO,
+    GM_FILL_NOISE_RGB
+} gm_fill_noise_mode_t;
+
+int gm_fill_init(gm_fill_t **fill, SDL_Renderer *renderer, int w, int h);
+void gm_fill_shutdown(gm_fill_t *fill);
+
+// Kernels write rect (already clipped to the buffer) into fill->pixels, pitch fill->w.
+void gm_fill_noise(gm_fill_t *fill, const SDL_Rect *rect, uint32_t seed, gm_fill_noise_mode_t mode);
+void gm_fill_gradient(gm_fill_t *fill, const SDL_Rect *rect, uint32_t c0, uint32_t c1, bool vertical, bool dither);
+void gm_fill_dither(gm_fill_t *fill, const SDL_Rect *rect, float level, uint32_t color);
+
+// Uploads rect from the buffer and draws it at the same place on the current render target.
+void gm_fill_present(gm_fill_t *fill, const SDL_Rect *rect);
+
+// Adds gm:fillNoise, gm:fillGradient and gm:fillDither to the game API.
+void gm_fill_register_lua(gm_fill_t *fill, lua_State *L);
+
+#endif // __GM_FILL_H__
@@ -0,0 +1,96 @@
+#include <stdlib.h>
+
+#include "gm_font.h"
+#include "gm_startup.h"
+
+int gm_font_init(gm_font_t **font, const gm_pack_t *pack, float size)
+{
+    (*font) = (gm_font_t *)calloc(sizeof(gm_font_t), 1);
+    if ((*font) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_font_t.\n");
+        return 1;
+    }
+
+    gm_font_t *f = (*font);
+    f->font = NULL;
+    f->pack = pack;
+    f->size = size;
+    f->ttf_ready = false;
+    f->failed = false;
+    return 0;
+}
+
+static TTF_Font *gm_font_open(gm_font_t *f)
+{
+    // prefer the font bundled in the asset pack, served straight from the mapping
+    SDL_IOStream *font_io = gm_pack_open_io(f->pack, GM_PACK_FONT_FILE);
+    if (font_io)
+    {
+        TTF_Font *font = TTF_OpenFontIO(font_io, true, f->size);
+        if (font)
+        {
+            SDL_Log("Loading font from pack: %s\n", GM_PACK_FONT_FILE);
+            return font;
+        }
+        SDL_Log("Failed to load font from pack: %s", SDL_GetError());
+    }
+
+    const char *base_path = SDL_GetBasePath();
+    if (base_path)
+    {
+        char font_path[1024];
+
+        SDL_snprintf(font_path, sizeof(font_path), "%s/%s", base_path, GM_PACK_FONT_FILE);
+
+        TTF_Font *font = TTF_OpenFont(font_path, f->size);
+        if (font == NULL)
+        {
+            SDL_Log("Failed to load font: %s", SDL_GetError());
+            return NULL;
+        }
+        SDL_Log("Loading font from: %s\n", font_path);
+        return font;
+    }
+    return NULL;
+}
+
+TTF_Font *gm_font_get(gm_font_t *font)
+{
+    if (font->font || font->failed)
+    {
+        return font->font;
+    }
+
+    int phase = gm_startup_begin("font");
+    if (!TTF_Init())
+    {
+        SDL_Log("Couldn't initialize SDL_ttf: %s\n", SDL_GetError());
+        font->failed = true;
+        gm_startup_end(phase);
+        return NULL;
+    }
+    font->ttf_ready = true;
+
+    font->font = gm_font_open(font);
+    // don't retry every frame when the font is missing
+    font->failed = (font->font == NULL);
+    gm_startup_end(phase);
+    return font->font;
+}
+
+void gm_font_shutdown(gm_font_t *font)
+{
+    if (font)
+    {
+        if (font->font)
+        {
+            TTF_CloseFont(font->font);
+        }
+        if (font->ttf_ready)
+        {
+            TTF_Quit();
+        }
+        free(font);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef __GM_FONT_H__
+#define __GM_FONT_H__
+
+#include <stdbool.h>
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "gm_pack.h"
+
+// The engine font, shared by the fps display and the console.
+// SDL_ttf and the font file are only touched on the first gm_font_get.
+typedef struct
+{
+    TTF_Font *font;
+    const gm_pack_t *pack;
+    float size;
+    bool ttf_ready;
+    bool failed;
+} gm_font_t;
+
+int gm_font_init(gm_font_t **font, const gm_pack_t *pack, float size);
+
+// Opens the font on first use, returns NULL if it could not be loaded.
+TTF_Font *gm_font_get(gm_font_t *font);
+
+void gm_font_shutdown(gm_font_t *font);
+
+#endif // __GM_FONT_H__
@@ -13,14 +13,15 @@ int gm_fps_init(gm_fps_t **fps)
 
     gm_fps_t *f = (*fps);
     f->frameCount = 0;
-    f->lastUpdateTime = 0;
+    // the first reading (and the font load it needs) happens one interval after startup
+    f->lastUpdateTime = SDL_GetTicks();
     f->fpsTexture = NULL;
     f->currentFPS = 0.0f;
 
     return 0;
 }
 
-void gm_fps_draw(gm_fps_t *fps, SDL_Renderer *renderer, TTF_Font *font, int x, int y)
+void gm_fps_draw(gm_fps_t *fps, SDL_Renderer *renderer, gm_font_t *font, int x, int y)
 {
     uint64_t currentTime = SDL_GetTicks();
     fps->frameCount++;
@@ -37,12 +38,14 @@ void gm_fps_draw(gm_fps_t *fps, SDL_Renderer *renderer, TTF_Font *font, int x, i
         if (fps->fpsTexture)
         {
             SDL_DestroyTexture(fps->fpsTexture);
+            fps->fpsTexture = NULL;
         }
 
         char text[32];
         snprintf(text, sizeof(text), "FPS: %.2f", fps->currentFPS);
         SDL_Color fg = {255, 255, 255, 255};
-        SDL_Surface *surf = TTF_RenderText_Blended(font, text, 0, fg);
+        TTF_Font *ttf = gm_font_get(font);
+        SDL_Surface *surf = ttf ? TTF_RenderText_Blended(ttf, text, 0, fg) : NULL;
         if (surf)
         {
             fps->fpsTexture = SDL_CreateTextureFromSurface(renderer, surf);
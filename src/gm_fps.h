@@ -5,6 +5,8 @@
 #include <SDL3_ttf/SDL_ttf.h>
 #include <stddef.h>
 
+#include "gm_font.h"
+
 typedef struct
 {
     // fps texture related state
@@ -16,7 +18,7 @@ typedef struct
 } gm_fps_t;
 
 int gm_fps_init(gm_fps_t **fps);
-void gm_fps_draw(gm_fps_t *fps, SDL_Renderer *renderer, TTF_Font *font, int x, int y);
+void gm_fps_draw(gm_fps_t *fps, SDL_Renderer *renderer, gm_font_t *font, int x, int y);
 void gm_fps_shutdown(gm_fps_t *fps);
 
 #endif // __GM_FPS_H__
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include "gm_hook.h"
+
+static void gm_hook_dispatch(lua_State *L, lua_Debug *ar)
+{
+    (void)ar;
+    gm_hook_t *hook = *(gm_hook_t **)lua_getextraspace(L);
+    for (int i = 0; i < hook->count; i++)
+    {
+        if (hook->clients[i].enabled)
+        {
+            hook->clients[i].fn(L, hook->clients[i].userdata);
+        }
+    }
+}
+
+int gm_hook_init(gm_hook_t **hook, lua_State *L)
+{
+    (*hook) = (gm_hook_t *)calloc(sizeof(gm_hook_t), 1);
+    if ((*hook) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_hook_t.\n");
+        return 1;
+    }
+
+    (*hook)->L = L;
+    *(gm_hook_t **)lua_getextraspace(L) = (*hook);
+    lua_sethook(L, gm_hook_dispatch, LUA_MASKCOUNT, GM_HOOK_COUNT);
+    return 0;
+}
+
+void gm_hook_shutdown(gm_hook_t *hook)
+{
+    if (hook)
+    {
+        free(hook);
+    }
+}
+
+int gm_hook_add(gm_hook_t *hook, gm_hook_fn fn, void *userdata)
+{
+    if (hook->count == GM_HOOK_MAX_CLIENTS)
+    {
+        SDL_Log("Too many Lua hook clients.\n");
+        return -1;
+    }
+    hook->clients[hook->count].fn = fn;
+    hook->clients[hook->count].userdata = userdata;
+    hook->clients[hook->count].enabled = false;
+    return hook->count++;
+}
+
+void gm_hook_enable(gm_hook_t *hook, int id, bool enable)
+{
+    if (id < 0 || id >= hook->count)
+    {
+        return;
+    }
+    hook->clients[id].enabled = enable;
+}
@@ -0,0 +1,46 @@
+#ifndef __GM_HOOK_H__
+#define __GM_HOOK_H__
+
+#include <stdbool.h>
+#include <lua.h>
+
+// the hook runs every GM_HOOK_COUNT VM instructions and calls every enabled client
+#define GM_HOOK_COUNT 1000
+#define GM_HOOK_MAX_CLIENTS 4
+
+// Called from the hook with the running thread, may raise a Lua error.
+typedef void (*gm_hook_fn)(lua_State *L, void *userdata);
+
+typedef struct
+{
+    gm_hook_fn fn;
+    void *userdata;
+    bool enabled;
+} gm_hook_client_t;
+
+// Lua keeps a single hook per state, so the profiler and the watchdog share
+// this one. It is found through the state's extra space, which coroutines inherit.
+// Lua hooks are per thread and a coroutine copies its creator's, so the hook is
+// installed once for good and clients are switched on and off in the table,
+// otherwise coroutines created while it was off would never be hooked.
+typedef struct
+{
+    lua_State *L;
+    gm_hook_client_t clients[GM_HOOK_MAX_CLIENTS];
+    int count;
+} gm_hook_t;
+
+// Call before any script runs, coroutines created earlier are not hooked.
+int gm_hook_init(gm_hook_t **hook, lua_State *L);
+
+// Call after the Lua state is closed. Every coroutine holds its own copy of the
+// hook and of the pointer to this struct, and may still run from a finalizer
+// during lua_close, so neither can be taken back before that.
+void gm_hook_shutdown(gm_hook_t *hook);
+
+// Adds a client, disabled, and returns its id or -1 when there is no room left.
+// Clients are called in the order they were added.
+int gm_hook_add(gm_hook_t *hook, gm_hook_fn fn, void *userdata);
+void gm_hook_enable(gm_hook_t *hook, int id, bool enable);
+
+#endif // __GM_HOOK_H__
@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_input.h"
+#include "gm_lua.h"
+
+static const char *gm_input_kind_names[GM_INPUT_KIND_COUNT] = {
+    "keydown",
+    "keyup",
+    "mousedown",
+    "mouseup",
+    "mousemove",
+    "wheel",
+};
+
+int gm_input_init(gm_input_t **input, SDL_FRect canvas_rect, int scale)
+{
+    (*input) = (gm_input_t *)calloc(sizeof(gm_input_t), 1);
+    if ((*input) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_input_t.\n");
+        return 1;
+    }
+
+    gm_input_t *in = (*input);
+    in->canvas_rect = canvas_rect;
+    in->canvas_scale = (scale > 0) ? (float)scale : 1.0f;
+    in->frame = 1;
+    in->L = NULL;
+    in->mouse_ref = LUA_NOREF;
+    return 0;
+}
+
+void gm_input_shutdown(gm_input_t *input)
+{
+    if (input)
+    {
+        free(input);
+    }
+}
+
+void gm_input_begin_frame(gm_input_t *input)
+{
+    input->frame++;
+    input->head = 0;
+    input->count = 0;
+    input->wheel_x = 0.0f;
+    input->wheel_y = 0.0f;
+}
+
+void gm_input_push(gm_input_t *input, const gm_input_event_t *ev)
+{
+    // keep the newest events when a frame overflows the ring
+    uint32_t slot = (input->head + input->count) % GM_INPUT_RING_SIZE;
+    if (input->count == GM_INPUT_RING_SIZE)
+    {
+        input->head = (input->head + 1) % GM_INPUT_RING_SIZE;
+        input->dropped++;
+    }
+    else
+    {
+        input->count++;
+    }
+    input->ring[slot] = *ev;
+
+    switch (ev->kind)
+    {
+    case GM_INPUT_KEY_DOWN:
+        if (ev->code < SDL_SCANCODE_COUNT)
+        {
+            input->keys[ev->code] = true;
+            input->key_down_frame[ev->code] = input->frame;
+        }
+        break;
+    case GM_INPUT_KEY_UP:
+        if (ev->code < SDL_SCANCODE_COUNT)
+        {
+            input->keys[ev->code] = false;
+            input->key_up_frame[ev->code] = input->frame;
+        }
+        break;
+    case GM_INPUT_MOUSE_DOWN:
+        input->mouse_buttons |= SDL_BUTTON_MASK(ev->code);
+        input->mouse_x = ev->x;
+        input->mouse_y = ev->y;
+        break;
+    case GM_INPUT_MOUSE_UP:
+        input->mouse_buttons &= ~SDL_BUTTON_MASK(ev->code);
+        input->mouse_x = ev->x;
+        input->mouse_y = ev->y;
+        break;
+    case GM_INPUT_MOUSE_MOVE:
+        input->mouse_x = ev->x;
+        input->mouse_y = ev->y;
+        break;
+    case GM_INPUT_MOUSE_WHEEL:
+        input->wheel_x += ev->x;
+        input->wheel_y += ev->y;
+        break;
+    default:
+        break;
+    }
+}
+
+static void gm_input_to_canvas(const gm_input_t *input, float wx, float wy, float *cx, float *cy)
+{
+    *cx = SDL_floorf((wx - input->canvas_rect.x) / input->canvas_scale);
+    *cy = SDL_floorf((wy - input->canvas_rect.y) / input->canvas_scale);
+}
+
+bool gm_input_push_sdl(gm_input_t *input, const SDL_Event *evt)
+{
+    gm_input_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.timestamp_ns = evt->common.timestamp;
+
+    switch (evt->type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        // auto-repeat doesn't change the key state
+        if (evt->key.repeat)
+        {
+            return false;
+        }
+        ev.kind = (evt->type == SDL_EVENT_KEY_DOWN) ? GM_INPUT_KEY_DOWN : GM_INPUT_KEY_UP;
+        ev.code = (uint16_t)evt->key.scancode;
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        ev.kind = (evt->type == SDL_EVENT_MOUSE_BUTTON_DOWN) ? GM_INPUT_MOUSE_DOWN : GM_INPUT_MOUSE_UP;
+        ev.code = evt->button.button;
+        gm_input_to_canvas(input, evt->button.x, evt->button.y, &ev.x, &ev.y);
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        ev.kind = GM_INPUT_MOUSE_MOVE;
+        gm_input_to_canvas(input, evt->motion.x, evt->motion.y, &ev.x, &ev.y);
+        break;
+    case SDL_EVENT_MOUSE_WHEEL:
+        ev.kind = GM_INPUT_MOUSE_WHEEL;
+        ev.x = evt->wheel.x;
+        ev.y = evt->wheel.y;
+        break;
+    default:
+        return false;
+    }
+
+    gm_input_push(input, &ev);
+    return true;
+}
+
+static void gm_input_set_field_int(lua_State *L, const char *k, lua_Integer v)
+{
+    lua_pushinteger(L, v);
+    lua_setfield(L, -2, k);
+}
+
+static void gm_input_set_field_bool(lua_State *L, const char *k, bool v)
+{
+    lua_pushboolean(L, v);
+    lua_setfield(L, -2, k);
+}
+
+void gm_input_consume(gm_input_t *input, uint64_t now_ns)
+{
+    uint64_t frame_max = 0;
+    for (uint32_t i = 0; i < input->count; i++)
+    {
+        const gm_input_event_t *ev = &input->ring[(input->head + i) % GM_INPUT_RING_SIZE];
+        if (ev->timestamp_ns == 0 || ev->timestamp_ns > now_ns)
+        {
+            continue;
+        }
+        uint64_t latency = now_ns - ev->timestamp_ns;
+        input->latency_sum_ns += latency;
+        input->latency_samples++;
+        if (latency > frame_max)
+        {
+            frame_max = latency;
+        }
+    }
+    input->latency_frame_max_ns = frame_max;
+    if (frame_max > input->latency_max_ns)
+    {
+        input->latency_max_ns = frame_max;
+    }
+
+    // update gm.mouse in place, its fields already exist so nothing is allocated
+    if (input->L && input->mouse_ref != LUA_NOREF)
+    {
+        lua_State *L = input->L;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, input->mouse_ref);
+        gm_input_set_field_int(L, "x", (lua_Integer)input->mouse_x);
+        gm_input_set_field_int(L, "y", (lua_Integer)input->mouse_y);
+        gm_input_set_field_bool(L, "left", input->mouse_buttons & SDL_BUTTON_MASK(SDL_BUTTON_LEFT));
+        gm_input_set_field_bool(L, "middle", input->mouse_buttons & SDL_BUTTON_MASK(SDL_BUTTON_MIDDLE));
+        gm_input_set_field_bool(L, "right", input->mouse_buttons & SDL_BUTTON_MASK(SDL_BUTTON_RIGHT));
+        lua_pushnumber(L, input->wheel_x);
+        lua_setfield(L, -2, "wheelX");
+        lua_pushnumber(L, input->wheel_y);
+        lua_setfield(L, -2, "wheelY");
+        lua_pop(L, 1);
+    }
+}
+
+static gm_input_t *gm_input_upvalue(lua_State *L)
+{
+    return (gm_input_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// Resolves a key name ("a", "space", "left") or scancode, names are cached in upvalue 2.
+static SDL_Scancode gm_input_check_key(lua_State *L, int idx)
+{
+    if (lua_type(L, idx) == LUA_TNUMBER)
+    {
+        lua_Integer sc = luaL_checkinteger(L, idx);
+        luaL_argcheck(L, sc > 0 && sc < SDL_SCANCODE_COUNT, idx, "invalid scancode");
+        return (SDL_Scancode)sc;
+    }
+
+    lua_pushvalue(L, idx);
+    if (lua_rawget(L, lua_upvalueindex(2)) == LUA_TNUMBER)
+    {
+        SDL_Scancode sc = (SDL_Scancode)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        return sc;
+    }
+    lua_pop(L, 1);
+
+    const char *name = luaL_checkstring(L, idx);
+    SDL_Scancode sc = SDL_GetScancodeFromName(name);
+    if (sc == SDL_SCANCODE_UNKNOWN)
+    {
+        luaL_argerror(L, idx, "unknown key name");
+    }
+    lua_pushvalue(L, idx);
+    lua_pushinteger(L, sc);
+    lua_rawset(L, lua_upvalueindex(2));
+    return sc;
+}
+
+static int gm_input_lua_key_down(lua_State *L)
+{
+    gm_input_t *in = gm_input_upvalue(L);
+    lua_pushboolean(L, in->keys[gm_input_check_key(L, 2)]);
+    return 1;
+}
+
+static int gm_input_lua_key_pressed(lua_State *L)
+{
+    gm_input_t *in = gm_input_upvalue(L);
+    lua_pushboolean(L, in->key_down_frame[gm_input_check_key(L, 2)] == in->frame);
+    return 1;
+}
+
+static int gm_input_lua_key_released(lua_State *L)
+{
+    gm_input_t *in = gm_input_upvalue(L);
+    lua_pushboolean(L, in->key_up_frame[gm_input_check_key(L, 2)] == in->frame);
+    return 1;
+}
+
+// for i, kind, code, x, y in gm:events() do ... end
+static int gm_input_lua_events_next(lua_State *L)
+{
+    gm_input_t *in = gm_input_upvalue(L);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    if (i < 0 || (uint32_t)i >= in->count)
+    {
+        return 0;
+    }
+
+    const gm_input_event_t *ev = &in->ring[(in->head + (uint32_t)i) % GM_INPUT_RING_SIZE];
+    lua_pushinteger(L, i + 1);
+    lua_pushstring(L, gm_input_kind_names[ev->kind]);
+    switch (ev->kind)
+    {
+    case GM_INPUT_KEY_DOWN:
+    case GM_INPUT_KEY_UP:
+        lua_pushstring(L, SDL_GetScancodeName((SDL_Scancode)ev->code));
+        break;
+    case GM_INPUT_MOUSE_DOWN:
+    case GM_INPUT_MOUSE_UP:
+        lua_pushinteger(L, ev->code);
+        break;
+    default:
+        lua_pushnil(L);
+        break;
+    }
+    if (ev->kind == GM_INPUT_MOUSE_WHEEL)
+    {
+        lua_pushnumber(L, ev->x);
+        lua_pushnumber(L, ev->y);
+    }
+    else
+    {
+        lua_pushinteger(L, (lua_Integer)ev->x);
+        lua_pushinteger(L, (lua_Integer)ev->y);
+    }
+    return 5;
+}
+
+static int gm_input_lua_events(lua_State *L)
+{
+    // the iterator closure is created once at registration, so a loop allocates nothing
+    lua_pushvalue(L, lua_upvalueindex(3));
+    lua_pushnil(L);
+    lua_pushinteger(L, 0);
+    return 3;
+}
+
+static int gm_input_lua_latency(lua_State *L)
+{
+    gm_input_t *in = gm_input_upvalue(L);
+    double avg = in->latency_samples ? (double)in->latency_sum_ns / (double)in->latency_samples : 0.0;
+    lua_pushnumber(L, (double)in->latency_frame_max_ns / 1e6);
+    lua_pushnumber(L, avg / 1e6);
+    lua_pushnumber(L, (double)in->latency_max_ns / 1e6);
+    return 3;
+}
+
+void gm_input_register_lua(gm_input_t *input, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"keyDown", gm_input_lua_key_down},
+        {"keyPressed", gm_input_lua_key_pressed},
+        {"keyReleased", gm_input_lua_key_released},
+        {"inputLatency", gm_input_lua_latency},
+        {NULL, NULL}};
+
+    input->L = L;
+    gm_lua_push_api(L);
+    int api = lua_gettop(L);
+
+    // upvalues: the input context and the key name cache
+    lua_pushlightuserdata(L, input);
+    lua_newtable(L);
+
+    // events() hands out a single shared iterator, created here once
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, gm_input_lua_events_next, 1);
+    lua_pushvalue(L, -3);
+    lua_pushvalue(L, -3);
+    lua_pushvalue(L, -3);
+    lua_pushcclosure(L, gm_input_lua_events, 3);
+    lua_setfield(L, api, "events");
+    lua_pop(L, 1);
+
+    luaL_setfuncs(L, funcs, 2);
+
+    // gm.mouse is a single table refreshed before every draw
+    lua_newtable(L);
+    gm_input_set_field_int(L, "x", 0);
+    gm_input_set_field_int(L, "y", 0);
+    gm_input_set_field_bool(L, "left", false);
+    gm_input_set_field_bool(L, "middle", false);
+    gm_input_set_field_bool(L, "right", false);
+    lua_pushnumber(L, 0.0);
+    lua_setfield(L, -2, "wheelX");
+    lua_pushnumber(L, 0.0);
+    lua_setfield(L, -2, "wheelY");
+    lua_pushvalue(L, -1);
+    input->mouse_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_setfield(L, -2, "mouse");
+
+    lua_pop(L, 1);
+}
@@ -0,0 +1,84 @@
+#ifndef __GM_INPUT_H__
+#define __GM_INPUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#define GM_INPUT_RING_SIZE 256
+
+typedef enum
+{
+    GM_INPUT_KEY_DOWN,
+    GM_INPUT_KEY_UP,
+    GM_INPUT_MOUSE_DOWN,
+    GM_INPUT_MOUSE_UP,
+    GM_INPUT_MOUSE_MOVE,
+    GM_INPUT_MOUSE_WHEEL,
+    GM_INPUT_KIND_COUNT
+} gm_input_kind_t;
+
+// One input event in canvas space, compact enough to be recorded as is.
+typedef struct
+{
+    uint8_t kind;
+    uint16_t code; // scancode for keys, button for mouse buttons
+    float x;       // canvas position, or wheel delta
+    float y;
+    uint64_t timestamp_ns;
+} gm_input_event_t;
+
+typedef struct
+{
+    // this frame's events, oldest first, the oldest are overwritten on overflow
+    gm_input_event_t ring[GM_INPUT_RING_SIZE];
+    uint32_t head;
+    uint32_t count;
+    uint32_t dropped;
+
+    // current keyboard state and the frame each key last went down/up
+    uint64_t frame;
+    bool keys[SDL_SCANCODE_COUNT];
+    uint64_t key_down_frame[SDL_SCANCODE_COUNT];
+    uint64_t key_up_frame[SDL_SCANCODE_COUNT];
+
+    // current mouse state in canvas pixels
+    float mouse_x;
+    float mouse_y;
+    uint32_t mouse_buttons;
+    float wheel_x;
+    float wheel_y;
+
+    // window to canvas mapping
+    SDL_FRect canvas_rect;
+    float canvas_scale;
+
+    // event timestamp to consuming frame latency
+    uint64_t latency_frame_max_ns;
+    uint64_t latency_max_ns;
+    uint64_t latency_sum_ns;
+    uint64_t latency_samples;
+
+    // registry ref of the reusable gm.mouse table
+    lua_State *L;
+    int mouse_ref;
+} gm_input_t;
+
+int gm_input_init(gm_input_t **input, SDL_FRect canvas_rect, int scale);
+void gm_input_shutdown(gm_input_t *input);
+
+// Starts a new frame, the ring is emptied and per-frame state reset.
+void gm_input_begin_frame(gm_input_t *input);
+
+// Translates an SDL event, returns false if it is not a game input event.
+bool gm_input_push_sdl(gm_input_t *input, const SDL_Event *evt);
+void gm_input_push(gm_input_t *input, const gm_input_event_t *ev);
+
+// Called right before draw: records latency and refreshes gm.mouse in place.
+void gm_input_consume(gm_input_t *input, uint64_t now_ns);
+
+// Adds keyDown/keyPressed/keyReleased/events/inputLatency and gm.mouse to the game API.
+void gm_input_register_lua(gm_input_t *input, lua_State *L);
+
+#endif // __GM_INPUT_H__
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include "gm_lua.h"
+#include "gm_bytecode.h"
 
 static inline uint8_t gm_u8_clamp(int v)
 {
@@ -14,13 +15,53 @@ static inline uint8_t gm_u8_clamp(int v)
     return (uint8_t)v;
 }
 
-static inline void gm_lua_apply_color(gm_lua_game_t *game, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+static inline uint32_t gm_lua_pack_color(int r, int g, int b, int a)
 {
-    game->r = r;
-    game->g = g;
-    game->b = b;
-    game->a = a;
-    SDL_SetRenderDrawColor(game->renderer, game->r, game->g, game->b, game->a);
+    return ((uint32_t)gm_u8_clamp(r) << 24) | ((uint32_t)gm_u8_clamp(g) << 16) |
+           ((uint32_t)gm_u8_clamp(b) << 8) | (uint32_t)gm_u8_clamp(a);
+}
+
+// Reads an optional colour at idx, either r, g, b [, a] or one packed 0xRRGGBBAA integer.
+// Returns false if no colour was passed.
+static inline bool gm_lua_opt_color(lua_State *L, int idx, uint32_t *rgba)
+{
+    int top = lua_gettop(L);
+    if (top >= idx + 2)
+    {
+        int r = (int)luaL_checkinteger(L, idx);
+        int g = (int)luaL_checkinteger(L, idx + 1);
+        int b = (int)luaL_checkinteger(L, idx + 2);
+        int a = (top >= idx + 3) ? (int)luaL_checkinteger(L, idx + 3) : 255;
+        *rgba = gm_lua_pack_color(r, g, b, a);
+        return true;
+    }
+    if (top == idx)
+    {
+        *rgba = (uint32_t)luaL_checkinteger(L, idx);
+        return true;
+    }
+    if (top == idx + 1)
+    {
+        luaL_error(L, "a colour is r, g, b [, a] or one packed 0xRRGGBBAA integer, got 2 values");
+    }
+    return false;
+}
+
+void gm_lua_set_draw_color(gm_lua_game_t *game, uint32_t rgba)
+{
+    // skip the renderer call when the colour is already set
+    if (game->sdl_color_valid && game->sdl_color == rgba)
+    {
+        return;
+    }
+    game->sdl_color = rgba;
+    game->sdl_color_valid = true;
+    SDL_SetRenderDrawColor(game->renderer, (uint8_t)(rgba >> 24), (uint8_t)(rgba >> 16), (uint8_t)(rgba >> 8), (uint8_t)rgba);
+}
+
+void gm_lua_invalidate_state(gm_lua_game_t *game)
+{
+    game->sdl_color_valid = false;
 }
 
 static inline void gm_lua_draw_brush(gm_lua_game_t *game, int x, int y)
@@ -40,9 +81,88 @@ static inline void gm_lua_draw_brush(gm_lua_game_t *game, int x, int y)
     SDL_RenderFillRect(game->renderer, &rect);
 }
 
-gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Texture *canvas_texture, int width, int height)
+// Loads a script as a chunk, from disk through the bytecode cache, or zero-copy from the pack.
+static int gm_lua_load_script(lua_State *L, const gm_pack_t *pack, const char *path)
+{
+    if (file_exists(path))
+    {
+        return gm_bytecode_load(L, path);
+    }
+
+    size_t size = 0;
+    const char *data = (const char *)gm_pack_find(pack, path, &size);
+    if (data == NULL)
+    {
+        lua_pushfstring(L, "cannot open %s", path);
+        return LUA_ERRFILE;
+    }
+
+    char chunk_name[512];
+    SDL_snprintf(chunk_name, sizeof(chunk_name), "@%s", path);
+    return luaL_loadbufferx(L, data, size, chunk_name, "b");
+}
+
+// package.searchers entry resolving "a.b" to "a/b.lua" on disk or in the pack
+static int gm_lua_searcher(lua_State *L)
+{
+    const gm_pack_t *pack = (const gm_pack_t *)lua_touserdata(L, lua_upvalueindex(1));
+    const char *name = luaL_checkstring(L, 1);
+    char path[512];
+    size_t len = SDL_strlen(name);
+    if (len > sizeof(path) - 5)
+    {
+        return luaL_error(L, "module name '%s' is too long", name);
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        path[i] = (name[i] == '.') ? '/' : name[i];
+    }
+    SDL_strlcpy(path + len, ".lua", sizeof(path) - len);
+
+    if (!file_exists(path) && gm_pack_find(pack, path, NULL) == NULL)
+    {
+        lua_pushfstring(L, "no file '%s'", path);
+        return 1;
+    }
+
+    if (gm_lua_load_script(L, pack, path) != LUA_OK)
+    {
+        return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s", name, path, lua_tostring(L, -1));
+    }
+    lua_pushstring(L, path);
+    return 2;
+}
+
+void gm_lua_open_package(lua_State *L, const gm_pack_t *pack)
+{
+    luaL_requiref(L, LUA_LOADLIBNAME, luaopen_package, 1);
+    lua_pop(L, 1);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+
+    // keep only the preload searcher and ours: the stock ones would bypass the
+    // cache and the pack, and the C ones can load any native library
+    int n = (int)lua_rawlen(L, -1);
+    for (int i = n; i >= 2; i--)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+    lua_pushlightuserdata(L, (void *)pack);
+    lua_pushcclosure(L, gm_lua_searcher, 1);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 1);
+
+    // no way back to native code from scripts
+    lua_pushnil(L);
+    lua_setfield(L, -2, "loadlib");
+    lua_pushnil(L);
+    lua_setfield(L, -2, "cpath");
+    lua_pop(L, 1);
+}
+
+gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, const gm_pack_t *pack)
 {
-    char *lua_file = "game.lua";
     bool file_found = false;
     gm_lua_error_t err;
     err.reloaded = false;
@@ -50,8 +170,9 @@ gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Textu
     err.message[0] = '\0';
 
     // Get the current directory, to load game.lua if found in the directory
-    const char *current_dir = SDL_GetCurrentDirectory();
+    char *current_dir = SDL_GetCurrentDirectory();
     SDL_Log("Current directory: %s\n", current_dir);
+    SDL_free(current_dir);
 
     // If the file "game.lua" exists we are good to go
     if (file_exists("game.lua"))
@@ -62,6 +183,13 @@ gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Textu
         snprintf(err.message, sizeof(err.message), "Found game.lua in current directory, loading it.");
         file_found = true;
     }
+    else if (gm_pack_find(pack, "game.lua", NULL))
+    {
+        SDL_Log("Found game.lua in the asset pack, loading it.\n");
+        err.code = 10;
+        snprintf(err.message, sizeof(err.message), "Found game.lua in the asset pack, loading it.");
+        file_found = true;
+    }
 
     // If there is no game.lua file we print an error and get out
     if (!file_found)
@@ -71,18 +199,32 @@ gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Textu
         snprintf(err.message, sizeof(err.message), "No game.lua file found in the current directory. Create one.");
     }
 
+    gm_lua_error_t state_err = gm_lua_init_script(lua_ctx, pack, "game.lua");
+    return state_err.code != 0 ? state_err : err;
+}
+
+gm_lua_error_t gm_lua_init_script(gm_lua_t **lua_ctx, const gm_pack_t *pack, const char *script)
+{
+    gm_lua_error_t err;
+    err.reloaded = false;
+    err.code = 0;
+    err.message[0] = '\0';
+
     (*lua_ctx) = (gm_lua_t *)calloc(sizeof(gm_lua_t), 1);
     if ((*lua_ctx) == NULL)
     {
         SDL_Log("Unable to allocate memory for gm_lua_t.\n");
-        err.code = 100;
+        err.code = 101;
         snprintf(err.message, sizeof(err.message), "Unable to allocate memory for Lua context.");
+        return err;
     }
 
     gm_lua_t *lc = (*lua_ctx);
 
     lc->gm = NULL;
-    lc->lua_file = strdup(lua_file);
+    lc->pack = pack;
+    lc->chunk_ref = LUA_NOREF;
+    lc->lua_file = script ? SDL_strdup(script) : NULL;
 
     lc->L = luaL_newstate();
     if (!lc->L)
@@ -103,16 +245,54 @@ gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Textu
     luaL_requiref(lc->L, LUA_TABLIBNAME, luaopen_table, 1);
     lua_pop(lc->L, 1);
 
+    /* coroutine, for gm.spawnTask and coroutine.yield */
+    luaL_requiref(lc->L, LUA_COLIBNAME, luaopen_coroutine, 1);
+    lua_pop(lc->L, 1);
+
+    /* package, for require() of game modules through the bytecode cache */
+    gm_lua_open_package(lc->L, pack);
+
     // TODO: commented out - required only when debugging
     // luaL_requiref(lc->L, LUA_OSLIBNAME, luaopen_os, 1);
     // lua_pop(lc->L, 1);
 
-    // register game API and load the initial script
-    gm_lua_register_game_api(lc, renderer, canvas_texture, width, height);
+    return err;
+}
+
+gm_lua_error_t gm_lua_precompile(gm_lua_t *lua_ctx)
+{
+    gm_lua_error_t err;
+    err.code = 0;
+    err.reloaded = false;
+    err.message[0] = '\0';
 
+    // only parse and compile here, running the chunk needs the game API
+    if (gm_lua_load_script(lua_ctx->L, lua_ctx->pack, lua_ctx->lua_file) != LUA_OK)
+    {
+        // gm_lua_load_file compiles again and reports the error to the console
+        err.code = 1;
+        snprintf(err.message, sizeof(err.message), "lua load error: %s", lua_tostring(lua_ctx->L, -1));
+        lua_pop(lua_ctx->L, 1);
+        return err;
+    }
+    lua_ctx->chunk_ref = luaL_ref(lua_ctx->L, LUA_REGISTRYINDEX);
     return err;
 }
 
+void gm_lua_seed_random(gm_lua_t *lua_ctx, uint64_t seed)
+{
+    lua_State *L = lua_ctx->L;
+    lua_getglobal(L, LUA_MATHLIBNAME);
+    lua_getfield(L, -1, "randomseed");
+    lua_pushinteger(L, (lua_Integer)seed);
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+    {
+        SDL_Log("math.randomseed failed: %s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+}
+
 void gm_lua_shutdown(gm_lua_t *lua_ctx)
 {
     if (lua_ctx)
@@ -123,7 +303,7 @@ void gm_lua_shutdown(gm_lua_t *lua_ctx)
         }
         if (lua_ctx->lua_file)
         {
-            free(lua_ctx->lua_file);
+            SDL_free(lua_ctx->lua_file);
         }
         free(lua_ctx);
     }
@@ -134,7 +314,14 @@ gm_lua_error_t gm_lua_load_file(gm_lua_t *lua_ctx)
     gm_lua_error_t err;
     err.reloaded = false;
 
-    if (luaL_loadfile(lua_ctx->L, lua_ctx->lua_file) != LUA_OK)
+    if (lua_ctx->chunk_ref != LUA_NOREF)
+    {
+        // use the chunk compiled during startup
+        lua_rawgeti(lua_ctx->L, LUA_REGISTRYINDEX, lua_ctx->chunk_ref);
+        luaL_unref(lua_ctx->L, LUA_REGISTRYINDEX, lua_ctx->chunk_ref);
+        lua_ctx->chunk_ref = LUA_NOREF;
+    }
+    else if (gm_lua_load_script(lua_ctx->L, lua_ctx->pack, lua_ctx->lua_file) != LUA_OK)
     {
         err.code = 1;
         const char *lua_err_msg = lua_tostring(lua_ctx->L, -1);
@@ -144,6 +331,7 @@ gm_lua_error_t gm_lua_load_file(gm_lua_t *lua_ctx)
         return err;
     }
 
+    lua_ctx->generation++;
     if (lua_pcall(lua_ctx->L, 0, 0, 0) != LUA_OK)
     {
         err.code = 2;
@@ -203,6 +391,15 @@ gm_lua_error_t gm_lua_call_draw(gm_lua_t *lua_ctx, float dt)
 
     if (!lua_ctx->gm->stop_running)
     {
+        // every frame starts drawing into the game canvas
+        gm_lua_game_t *game = lua_ctx->gm;
+        game->target = game->canvas_texture;
+        game->target_w = game->w;
+        game->target_h = game->h;
+
+        // the console and fps overlay draw between frames, so the cached renderer state is stale
+        gm_lua_invalidate_state(game);
+
         lua_getglobal(lua_ctx->L, "draw");
         lua_pushnumber(lua_ctx->L, dt);
 
@@ -224,28 +421,20 @@ gm_lua_error_t gm_lua_call_draw(gm_lua_t *lua_ctx, float dt)
 
 static gm_lua_game_t *gm_lua_check_game(lua_State *L)
 {
-    return (gm_lua_game_t *)luaL_checkudata(L, 1, GM_GAME_MT);
+    // the game object is upvalue 1, comparing pointers is cheaper than a metatable lookup
+    gm_lua_game_t *game = (gm_lua_game_t *)lua_touserdata(L, lua_upvalueindex(1));
+    if (lua_touserdata(L, 1) != game)
+    {
+        return (gm_lua_game_t *)luaL_checkudata(L, 1, GM_GAME_MT);
+    }
+    return game;
 }
 
 static int gm_lua_game_clear(lua_State *L)
 {
     gm_lua_game_t *game = gm_lua_check_game(L);
-    int argc = lua_gettop(L);
-
-    if (argc >= 4)
-    {
-        int r = luaL_checkinteger(L, 2);
-        int g = luaL_checkinteger(L, 3);
-        int b = luaL_checkinteger(L, 4);
-        int a = 255;
-        if (argc >= 5)
-        {
-            a = luaL_checkinteger(L, 5);
-        }
-        gm_lua_apply_color(game, gm_u8_clamp(r), gm_u8_clamp(g), gm_u8_clamp(b), gm_u8_clamp(a));
-    }
-
-    SDL_SetRenderDrawColor(game->renderer, game->r, game->g, game->b, game->a);
+    gm_lua_opt_color(L, 2, &game->color);
+    gm_lua_set_draw_color(game, game->color);
     SDL_RenderClear(game->renderer);
 
     return 0;
@@ -254,16 +443,11 @@ static int gm_lua_game_clear(lua_State *L)
 static int gm_lua_game_set_color(lua_State *L)
 {
     gm_lua_game_t *game = gm_lua_check_game(L);
-    int r = luaL_checkinteger(L, 2);
-    int g = luaL_checkinteger(L, 3);
-    int b = luaL_checkinteger(L, 4);
-    int a = 255;
-    if (lua_gettop(L) >= 5)
+    if (!gm_lua_opt_color(L, 2, &game->color))
     {
-        a = luaL_checkinteger(L, 5);
+        return luaL_argerror(L, 2, "expected r, g, b [, a] or a packed colour");
     }
-
-    gm_lua_apply_color(game, gm_u8_clamp(r), gm_u8_clamp(g), gm_u8_clamp(b), gm_u8_clamp(a));
+    gm_lua_set_draw_color(game, game->color);
     return 0;
 }
 
@@ -284,29 +468,15 @@ static int gm_lua_game_set_pixel(lua_State *L)
     gm_lua_game_t *game = gm_lua_check_game(L);
     int x = luaL_checkinteger(L, 2);
     int y = luaL_checkinteger(L, 3);
-    int argc = lua_gettop(L);
 
-    if (x < 0 || x >= game->w || y < 0 || y >= game->h)
+    if (x < 0 || x >= game->target_w || y < 0 || y >= game->target_h)
     {
         return 0;
     }
 
-    if (argc >= 6)
-    {
-        int r = luaL_checkinteger(L, 4);
-        int g = luaL_checkinteger(L, 5);
-        int b = luaL_checkinteger(L, 6);
-        int a = 255;
-        if (argc >= 7)
-        {
-            a = luaL_checkinteger(L, 7);
-        }
-        SDL_SetRenderDrawColor(game->renderer, gm_u8_clamp(r), gm_u8_clamp(g), gm_u8_clamp(b), gm_u8_clamp(a));
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(game->renderer, game->r, game->g, game->b, game->a);
-    }
+    uint32_t color = game->color;
+    gm_lua_opt_color(L, 4, &color);
+    gm_lua_set_draw_color(game, color);
 
     gm_lua_draw_brush(game, x, y);
     return 0;
@@ -319,24 +489,10 @@ static int gm_lua_game_line(lua_State *L)
     int y1 = luaL_checkinteger(L, 3);
     int x2 = luaL_checkinteger(L, 4);
     int y2 = luaL_checkinteger(L, 5);
-    int argc = lua_gettop(L);
 
-    if (argc >= 8)
-    {
-        int r = luaL_checkinteger(L, 6);
-        int g = luaL_checkinteger(L, 7);
-        int b = luaL_checkinteger(L, 8);
-        int a = 255;
-        if (argc >= 9)
-        {
-            a = luaL_checkinteger(L, 9);
-        }
-        SDL_SetRenderDrawColor(game->renderer, gm_u8_clamp(r), gm_u8_clamp(g), gm_u8_clamp(b), gm_u8_clamp(a));
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(game->renderer, game->r, game->g, game->b, game->a);
-    }
+    uint32_t color = game->color;
+    gm_lua_opt_color(L, 6, &color);
+    gm_lua_set_draw_color(game, color);
 
     // Fast path: native line drawing for 1px width.
     if (game->line_width <= 1)
@@ -372,7 +528,6 @@ static int gm_lua_game_fill_rect(lua_State *L)
     int y = luaL_checkinteger(L, 3);
     int w = luaL_checkinteger(L, 4);
     int h = luaL_checkinteger(L, 5);
-    int argc = lua_gettop(L);
 
     if (w <= 0 || h <= 0)
     {
@@ -392,13 +547,13 @@ static int gm_lua_game_fill_rect(lua_State *L)
     {
         y0 = 0;
     }
-    if (x1 > game->w)
+    if (x1 > game->target_w)
     {
-        x1 = game->w;
+        x1 = game->target_w;
     }
-    if (y1 > game->h)
+    if (y1 > game->target_h)
     {
-        y1 = game->h;
+        y1 = game->target_h;
     }
 
     if (x0 >= x1 || y0 >= y1)
@@ -406,22 +561,9 @@ static int gm_lua_game_fill_rect(lua_State *L)
         return 0;
     }
 
-    if (argc >= 8)
-    {
-        int r = luaL_checkinteger(L, 6);
-        int g = luaL_checkinteger(L, 7);
-        int b = luaL_checkinteger(L, 8);
-        int a = 255;
-        if (argc >= 9)
-        {
-            a = luaL_checkinteger(L, 9);
-        }
-        SDL_SetRenderDrawColor(game->renderer, gm_u8_clamp(r), gm_u8_clamp(g), gm_u8_clamp(b), gm_u8_clamp(a));
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(game->renderer, game->r, game->g, game->b, game->a);
-    }
+    uint32_t color = game->color;
+    gm_lua_opt_color(L, 6, &color);
+    gm_lua_set_draw_color(game, color);
 
     SDL_FRect rect = {
         .x = (float)x0,
@@ -476,50 +618,60 @@ static int gm_lua_game_save_pixels_to_image(lua_State *L)
     return 0;
 }
 
+// gm.rgba(r, g, b [, a]) packs a colour into one 0xRRGGBBAA integer
+static int gm_lua_rgba(lua_State *L)
+{
+    int r = (int)luaL_checkinteger(L, 1);
+    int g = (int)luaL_checkinteger(L, 2);
+    int b = (int)luaL_checkinteger(L, 3);
+    int a = (int)luaL_optinteger(L, 4, 255);
+    lua_pushinteger(L, (lua_Integer)gm_lua_pack_color(r, g, b, a));
+    return 1;
+}
+
 int gm_lua_register_game_api(gm_lua_t *lua_ctx, SDL_Renderer *renderer, SDL_Texture *canvas_texture, int width, int height)
 {
+    static const luaL_Reg methods[] = {
+        {"clear", gm_lua_game_clear},
+        {"noLoop", gm_lua_game_noloop},
+        {"setColor", gm_lua_game_set_color},
+        {"setLineWidth", gm_lua_game_set_line_width},
+        {"fillRect", gm_lua_game_fill_rect},
+        {"setPixel", gm_lua_game_set_pixel},
+        {"line", gm_lua_game_line},
+        {"saveFrame", gm_lua_game_save_pixels_to_image},
+        {NULL, NULL}};
+
     lua_State *L = lua_ctx->L;
 
+    gm_lua_game_t *gm = (gm_lua_game_t *)lua_newuserdata(L, sizeof(gm_lua_game_t));
+    gm->renderer = renderer;
+    gm->canvas_texture = canvas_texture;
+    gm->w = width;
+    gm->h = height;
+    gm->color = 0xffffffffu;
+    gm->sdl_color = 0;
+    gm->sdl_color_valid = false;
+    gm->line_width = 1;
+    gm->stop_running = false;
+    gm->target = canvas_texture;
+    gm->target_w = width;
+    gm->target_h = height;
+
     luaL_newmetatable(L, GM_GAME_MT);
 
+    // the methods carry the game object as an upvalue, see gm_lua_check_game
     lua_newtable(L);
-    lua_pushcfunction(L, gm_lua_game_clear);
-    lua_setfield(L, -2, "clear");
-    lua_pushcfunction(L, gm_lua_game_noloop);
-    lua_setfield(L, -2, "noLoop");
-    lua_pushcfunction(L, gm_lua_game_set_color);
-    lua_setfield(L, -2, "setColor");
-    lua_pushcfunction(L, gm_lua_game_set_line_width);
-    lua_setfield(L, -2, "setLineWidth");
-    lua_pushcfunction(L, gm_lua_game_fill_rect);
-    lua_setfield(L, -2, "fillRect");
-    lua_pushcfunction(L, gm_lua_game_set_pixel);
-    lua_setfield(L, -2, "setPixel");
-    lua_pushcfunction(L, gm_lua_game_line);
-    lua_setfield(L, -2, "line");
-    lua_pushcfunction(L, gm_lua_game_save_pixels_to_image);
-    lua_setfield(L, -2, "saveFrame");
+    lua_pushlightuserdata(L, gm);
+    luaL_setfuncs(L, methods, 1);
+    lua_pushcfunction(L, gm_lua_rgba);
+    lua_setfield(L, -2, "rgba");
     lua_pushinteger(L, width);
     lua_setfield(L, -2, "width");
     lua_pushinteger(L, height);
     lua_setfield(L, -2, "height");
     lua_setfield(L, -2, "__index");
 
-    lua_pop(L, 1);
-
-    gm_lua_game_t *gm = (gm_lua_game_t *)lua_newuserdata(L, sizeof(gm_lua_game_t));
-    gm->renderer = renderer;
-    gm->canvas_texture = canvas_texture;
-    gm->w = width;
-    gm->h = height;
-    gm->r = 255;
-    gm->g = 255;
-    gm->b = 255;
-    gm->a = 255;
-    gm->line_width = 1;
-    gm->stop_running = false;
-
-    luaL_getmetatable(L, GM_GAME_MT);
     lua_setmetatable(L, -2);
     lua_setglobal(L, "gm");
 
@@ -527,3 +679,10 @@ int gm_lua_register_game_api(gm_lua_t *lua_ctx, SDL_Renderer *renderer, SDL_Text
 
     return 0;
 }
+
+void gm_lua_push_api(lua_State *L)
+{
+    luaL_getmetatable(L, GM_GAME_MT);
+    lua_getfield(L, -1, "__index");
+    lua_remove(L, -2);
+}
@@ -8,6 +8,7 @@
 #include <SDL3/SDL.h>
 
 #include "gm_util.h"
+#include "gm_pack.h"
 
 #define GM_GAME_MT "gfxlc.gm"
 
@@ -17,12 +18,21 @@ typedef struct
     SDL_Texture *canvas_texture;
     int w;
     int h;
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-    uint8_t a;
+
+    // current colour, packed 0xRRGGBBAA
+    uint32_t color;
+
+    // the draw colour last sent to SDL, so unchanged colours are not sent again
+    uint32_t sdl_color;
+    bool sdl_color_valid;
+
     int line_width;
     bool stop_running;
+
+    // current render target and its size, the canvas texture unless gm:setTarget changed it
+    SDL_Texture *target;
+    int target_w;
+    int target_h;
 } gm_lua_game_t;
 
 typedef struct
@@ -32,6 +42,15 @@ typedef struct
     char *lua_file;
     time_t lua_last_mtime;
     gm_lua_game_t *gm;
+
+    // optional asset pack, consulted when a script is not on disk
+    const gm_pack_t *pack;
+
+    // registry ref of game.lua compiled ahead of time by gm_lua_precompile
+    int chunk_ref;
+
+    // counts script loads, so state created by a replaced script can be dropped
+    int generation;
 } gm_lua_t;
 
 typedef struct
@@ -41,7 +60,20 @@ typedef struct
     char message[256];
 } gm_lua_error_t;
 
-gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, SDL_Renderer *renderer, SDL_Texture *canvas_texture, int width, int height);
+// Creates the Lua state without touching SDL, so it can run off the main thread.
+gm_lua_error_t gm_lua_init(gm_lua_t **lua_ctx, const gm_pack_t *pack);
+
+// Same as gm_lua_init for a known script, without looking for game.lua or logging,
+// for batch jobs and tools that create many states. script may be NULL.
+gm_lua_error_t gm_lua_init_script(gm_lua_t **lua_ctx, const gm_pack_t *pack, const char *script);
+
+// Opens the package library with require() resolving modules on disk, through the
+// bytecode cache, or in the pack, and no way to load native libraries.
+void gm_lua_open_package(lua_State *L, const gm_pack_t *pack);
+gm_lua_error_t gm_lua_precompile(gm_lua_t *lua_ctx);
+
+// Seeds math.random, so recorded sessions replay the same random sequence.
+void gm_lua_seed_random(gm_lua_t *lua_ctx, uint64_t seed);
 void gm_lua_shutdown(gm_lua_t *lua_ctx);
 gm_lua_error_t gm_lua_load_file(gm_lua_t *lua_ctx);
 gm_lua_error_t gm_lua_call_draw(gm_lua_t *lua_ctx, float t);
@@ -58,4 +90,14 @@ static int gm_lua_game_fill_rect(lua_State *L);
 static int gm_lua_game_save_pixels_to_image(lua_State *L);
 int gm_lua_register_game_api(gm_lua_t *lua_ctx, SDL_Renderer *renderer, SDL_Texture *canvas_texture, int width, int height);
 
+// Sets the renderer draw colour through the state cache. Code that calls
+// SDL_SetRenderDrawColor directly must restore the colour it found, or call
+// gm_lua_invalidate_state afterwards. Code running between frames, after the
+// game's draw and tasks, needs neither: gm_lua_call_draw starts by invalidating it.
+void gm_lua_set_draw_color(gm_lua_game_t *game, uint32_t rgba);
+void gm_lua_invalidate_state(gm_lua_game_t *game);
+
+// Pushes the table behind the gm object, so other subsystems can add their functions to it.
+void gm_lua_push_api(lua_State *L);
+
 #endif // __GM_LUABIND_H__
@@ -0,0 +1,443 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <lua.h>
+#include <lauxlib.h>
+
+#include "gm_pack.h"
+#include "gm_bytecode.h"
+
+static bool gm_pack_map(gm_pack_t *pack, const char *path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+    void *base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    pack->base = (const uint8_t *)base;
+    pack->size = (size_t)size.QuadPart;
+    pack->map_handle = mapping;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    pack->base = (const uint8_t *)base;
+    pack->size = (size_t)st.st_size;
+    pack->map_handle = NULL;
+    return true;
+#endif
+}
+
+static void gm_pack_unmap(gm_pack_t *pack)
+{
+    if (pack->base == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(pack->base);
+    CloseHandle((HANDLE)pack->map_handle);
+#else
+    munmap((void *)pack->base, pack->size);
+#endif
+    pack->base = NULL;
+}
+
+int gm_pack_open(gm_pack_t **pack, const char *path)
+{
+    (*pack) = (gm_pack_t *)calloc(sizeof(gm_pack_t), 1);
+    if ((*pack) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_pack_t.\n");
+        return 1;
+    }
+
+    gm_pack_t *p = (*pack);
+    if (!gm_pack_map(p, path))
+    {
+        SDL_Log("Could not map pack %s\n", path);
+        free(p);
+        (*pack) = NULL;
+        return 2;
+    }
+
+    // validate the header and that the index and every blob lie inside the file
+    const gm_pack_header_t *hdr = (const gm_pack_header_t *)p->base;
+    bool valid = p->size >= sizeof(gm_pack_header_t) &&
+                 memcmp(hdr->magic, GM_PACK_MAGIC, 4) == 0 &&
+                 hdr->version == GM_PACK_VERSION &&
+                 hdr->index_offset <= p->size &&
+                 hdr->count <= (p->size - hdr->index_offset) / sizeof(gm_pack_entry_t);
+    if (valid)
+    {
+        p->entries = (const gm_pack_entry_t *)(p->base + hdr->index_offset);
+        p->count = hdr->count;
+        for (uint32_t i = 0; i < p->count && valid; i++)
+        {
+            const gm_pack_entry_t *e = &p->entries[i];
+            valid = e->name[GM_PACK_NAME_MAX - 1] == '\0' && e->offset <= p->size &&
+                    e->size <= p->size - e->offset;
+        }
+    }
+
+    if (!valid)
+    {
+        SDL_Log("Invalid pack file %s\n", path);
+        gm_pack_close(p);
+        (*pack) = NULL;
+        return 3;
+    }
+
+    SDL_Log("Mapped pack %s, %u entries, %u bytes\n", path, p->count, (unsigned int)p->size);
+    return 0;
+}
+
+void gm_pack_close(gm_pack_t *pack)
+{
+    if (pack)
+    {
+        gm_pack_unmap(pack);
+        free(pack);
+    }
+}
+
+const void *gm_pack_find(const gm_pack_t *pack, const char *name, size_t *size)
+{
+    if (pack == NULL)
+    {
+        return NULL;
+    }
+
+    // the index is sorted by name at build time
+    uint32_t lo = 0;
+    uint32_t hi = pack->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = SDL_strcmp(name, pack->entries[mid].name);
+        if (cmp == 0)
+        {
+            if (size)
+            {
+                *size = (size_t)pack->entries[mid].size;
+            }
+            return pack->base + pack->entries[mid].offset;
+        }
+        if (cmp < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+SDL_IOStream *gm_pack_open_io(const gm_pack_t *pack, const char *name)
+{
+    size_t size = 0;
+    const void *data = gm_pack_find(pack, name, &size);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    return SDL_IOFromConstMem(data, size);
+}
+
+typedef struct
+{
+    char name[GM_PACK_NAME_MAX];
+    void *data;
+    size_t size;
+} gm_pack_item_t;
+
+typedef struct
+{
+    lua_State *L;
+    const char *out_path;
+    gm_pack_item_t *items;
+    uint32_t count;
+    uint32_t capacity;
+    int failed;
+} gm_pack_builder_t;
+
+static bool gm_pack_builder_add(gm_pack_builder_t *b, const char *name, void *data, size_t size)
+{
+    if (SDL_strlen(name) >= GM_PACK_NAME_MAX)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "pack: name too long, skipping %s\n", name);
+        SDL_free(data);
+        b->failed++;
+        return false;
+    }
+    if (b->count == b->capacity)
+    {
+        uint32_t cap = b->capacity ? b->capacity * 2 : 32;
+        gm_pack_item_t *items = (gm_pack_item_t *)realloc(b->items, cap * sizeof(gm_pack_item_t));
+        if (items == NULL)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "pack: out of memory, skipping %s\n", name);
+            SDL_free(data);
+            b->failed++;
+            return false;
+        }
+        b->items = items;
+        b->capacity = cap;
+    }
+    gm_pack_item_t *item = &b->items[b->count++];
+    memset(item->name, 0, sizeof(item->name));
+    SDL_strlcpy(item->name, name, sizeof(item->name));
+    item->data = data;
+    item->size = size;
+    return true;
+}
+
+static void *gm_pack_compile_lua(gm_pack_builder_t *b, const char *path, size_t *size)
+{
+    char chunk_name[512];
+    SDL_snprintf(chunk_name, sizeof(chunk_name), "@%s", path);
+
+    size_t src_size = 0;
+    char *src = (char *)SDL_LoadFile(path, &src_size);
+    if (src == NULL)
+    {
+        return NULL;
+    }
+
+    void *out = NULL;
+    if (luaL_loadbufferx(b->L, src, src_size, chunk_name, "t") != LUA_OK)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "pack: %s\n", lua_tostring(b->L, -1));
+    }
+    else
+    {
+        gm_bytecode_buf_t buf;
+        if (gm_bytecode_dump(b->L, &buf, true) == 0)
+        {
+            // hand the dump over in SDL_malloc'd memory like SDL_LoadFile results
+            out = SDL_malloc(buf.size);
+            if (out)
+            {
+                memcpy(out, buf.data, buf.size);
+                *size = buf.size;
+            }
+            free(buf.data);
+        }
+    }
+    lua_settop(b->L, 0);
+    SDL_free(src);
+    return out;
+}
+
+static SDL_EnumerationResult gm_pack_collect(void *userdata, const char *dirname, const char *fname)
+{
+    gm_pack_builder_t *b = (gm_pack_builder_t *)userdata;
+
+    // skip hidden entries (.gmcache, .git) and other packs
+    size_t len = SDL_strlen(fname);
+    if (fname[0] == '.' || (len > 6 && SDL_strcmp(fname + len - 6, ".gmpak") == 0))
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    char path[512];
+    SDL_snprintf(path, sizeof(path), "%s%s", dirname, fname);
+    const char *rel = (SDL_strncmp(path, "./", 2) == 0) ? path + 2 : path;
+
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        SDL_EnumerateDirectory(path, gm_pack_collect, b);
+        return SDL_ENUM_CONTINUE;
+    }
+    if (info.type != SDL_PATHTYPE_FILE || SDL_strcmp(rel, b->out_path) == 0)
+    {
+        return SDL_ENUM_CONTINUE;
+    }
+
+    size_t size = 0;
+    void *data = NULL;
+    if (len > 4 && SDL_strcmp(fname + len - 4, ".lua") == 0)
+    {
+        data = gm_pack_compile_lua(b, path, &size);
+    }
+    else
+    {
+        data = SDL_LoadFile(path, &size);
+    }
+
+    if (data == NULL)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "pack: could not add %s\n", rel);
+        b->failed++;
+        return SDL_ENUM_CONTINUE;
+    }
+
+    if (gm_pack_builder_add(b, rel, data, size))
+    {
+        SDL_Log("pack: added %s (%u bytes)\n", rel, (unsigned int)size);
+    }
+    return SDL_ENUM_CONTINUE;
+}
+
+static int gm_pack_item_cmp(const void *a, const void *b)
+{
+    return SDL_strcmp(((const gm_pack_item_t *)a)->name, ((const gm_pack_item_t *)b)->name);
+}
+
+static uint64_t gm_pack_align_up(uint64_t v)
+{
+    return (v + GM_PACK_ALIGN - 1) & ~(uint64_t)(GM_PACK_ALIGN - 1);
+}
+
+static bool gm_pack_write(gm_pack_builder_t *b)
+{
+    SDL_IOStream *io = SDL_IOFromFile(b->out_path, "wb");
+    if (io == NULL)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "pack: could not create %s: %s\n", b->out_path, SDL_GetError());
+        return false;
+    }
+
+    gm_pack_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, GM_PACK_MAGIC, 4);
+    hdr.version = GM_PACK_VERSION;
+    hdr.count = b->count;
+    hdr.align = GM_PACK_ALIGN;
+    hdr.index_offset = sizeof(gm_pack_header_t);
+    hdr.data_offset = gm_pack_align_up(hdr.index_offset + (uint64_t)b->count * sizeof(gm_pack_entry_t));
+
+    bool ok = SDL_WriteIO(io, &hdr, sizeof(hdr)) == sizeof(hdr);
+
+    uint64_t offset = hdr.data_offset;
+    for (uint32_t i = 0; i < b->count && ok; i++)
+    {
+        gm_pack_entry_t e;
+        memset(&e, 0, sizeof(e));
+        memcpy(e.name, b->items[i].name, GM_PACK_NAME_MAX);
+        e.offset = offset;
+        e.size = b->items[i].size;
+        ok = SDL_WriteIO(io, &e, sizeof(e)) == sizeof(e);
+        offset = gm_pack_align_up(offset + e.size);
+    }
+
+    static const uint8_t zeros[GM_PACK_ALIGN] = {0};
+    uint64_t pos = hdr.index_offset + (uint64_t)b->count * sizeof(gm_pack_entry_t);
+    for (uint32_t i = 0; i < b->count && ok; i++)
+    {
+        uint64_t pad = gm_pack_align_up(pos) - pos;
+        ok = SDL_WriteIO(io, zeros, (size_t)pad) == pad &&
+             SDL_WriteIO(io, b->items[i].data, b->items[i].size) == b->items[i].size;
+        pos += pad + b->items[i].size;
+    }
+
+    if (!SDL_CloseIO(io))
+    {
+        ok = false;
+    }
+    return ok;
+}
+
+int gm_pack_build(const char *out_path, const char *dir)
+{
+    gm_pack_builder_t b;
+    memset(&b, 0, sizeof(b));
+    b.out_path = out_path;
+    b.L = luaL_newstate();
+    if (!b.L)
+    {
+        SDL_Log("failed to create lua state\n");
+        return 1;
+    }
+
+    SDL_EnumerateDirectory(dir, gm_pack_collect, &b);
+
+    // ship the engine font inside the pack unless the game brings its own
+    bool has_font = false;
+    for (uint32_t i = 0; i < b.count; i++)
+    {
+        has_font = has_font || SDL_strcmp(b.items[i].name, GM_PACK_FONT_FILE) == 0;
+    }
+    const char *base_path = SDL_GetBasePath();
+    if (!has_font && base_path)
+    {
+        char font_path[1024];
+        size_t size = 0;
+        SDL_snprintf(font_path, sizeof(font_path), "%s/%s", base_path, GM_PACK_FONT_FILE);
+        void *data = SDL_LoadFile(font_path, &size);
+        if (data)
+        {
+            gm_pack_builder_add(&b, GM_PACK_FONT_FILE, data, size);
+        }
+    }
+
+    SDL_qsort(b.items, b.count, sizeof(gm_pack_item_t), gm_pack_item_cmp);
+
+    bool ok = b.failed == 0 && gm_pack_write(&b);
+    if (ok)
+    {
+        SDL_Log("pack: wrote %s with %u entries\n", out_path, b.count);
+    }
+
+    for (uint32_t i = 0; i < b.count; i++)
+    {
+        SDL_free(b.items[i].data);
+    }
+    free(b.items);
+    lua_close(b.L);
+    return ok ? 0 : 1;
+}
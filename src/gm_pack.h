@@ -0,0 +1,59 @@
+#ifndef __GM_PACK_H__
+#define __GM_PACK_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+
+#define GM_PACK_FILE "game.gmpak"
+#define GM_PACK_MAGIC "GMPK"
+#define GM_PACK_VERSION 1
+#define GM_PACK_ALIGN 64
+#define GM_PACK_NAME_MAX 112
+
+// engine font, looked up in the pack before the binary's directory
+#define GM_PACK_FONT_FILE "SourceCodePro-Regular.ttf"
+
+// On-disk layout, in the byte order of the machine that built the pack:
+//   header | index (count entries, sorted by name) | blobs, each GM_PACK_ALIGN aligned
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t align;
+    uint64_t index_offset;
+    uint64_t data_offset;
+} gm_pack_header_t;
+
+typedef struct
+{
+    char name[GM_PACK_NAME_MAX];
+    uint64_t offset;
+    uint64_t size;
+} gm_pack_entry_t;
+
+typedef struct
+{
+    // read-only mapping of the whole pack file
+    const uint8_t *base;
+    size_t size;
+    const gm_pack_entry_t *entries;
+    uint32_t count;
+    void *map_handle;
+} gm_pack_t;
+
+int gm_pack_open(gm_pack_t **pack, const char *path);
+void gm_pack_close(gm_pack_t *pack);
+
+// Returns a pointer into the mapping, valid until gm_pack_close, or NULL if absent.
+const void *gm_pack_find(const gm_pack_t *pack, const char *name, size_t *size);
+
+// Zero-copy read stream over a pack entry, NULL if the pack or entry is missing.
+SDL_IOStream *gm_pack_open_io(const gm_pack_t *pack, const char *name);
+
+// Bundles every file below dir into a pack, Lua sources are stored as stripped bytecode.
+int gm_pack_build(const char *out_path, const char *dir);
+
+#endif // __GM_PACK_H__
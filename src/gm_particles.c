@@ -0,0 +1,489 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_particles.h"
+#include "gm_lua.h"
+
+#define GM_PARTICLES_ARRAYS 6
+
+int gm_particles_init(gm_particles_ctx_t **ctx, SDL_Renderer *renderer, int w, int h)
+{
+    (*ctx) = (gm_particles_ctx_t *)calloc(sizeof(gm_particles_ctx_t), 1);
+    if ((*ctx) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_particles_ctx_t.\n");
+        return 1;
+    }
+
+    (*ctx)->renderer = renderer;
+    (*ctx)->w = w;
+    (*ctx)->h = h;
+    return 0;
+}
+
+void gm_particles_shutdown(gm_particles_ctx_t *ctx)
+{
+    if (ctx)
+    {
+        free(ctx);
+    }
+}
+
+// xorshift64*, a generator per system keeps particles off the shared random state
+static inline float gm_particles_rand(gm_particles_t *ps)
+{
+    uint64_t x = ps->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    ps->rng = x;
+    return (float)((x * 2685821657736338717ull) >> 40) / 16777216.0f;
+}
+
+static inline uint32_t gm_particles_channel(uint32_t c, int shift)
+{
+    return (c >> shift) & 0xff;
+}
+
+// Fills the colour ramp from color0 to color1. Additive systems store the colours
+// premultiplied by their alpha, since they are summed instead of blended.
+static void gm_particles_build_ramp(gm_particles_t *ps)
+{
+    for (int i = 0; i < GM_PARTICLES_RAMP; i++)
+    {
+        uint32_t f = (uint32_t)(i * 256 / (GM_PARTICLES_RAMP - 1));
+        f = SDL_min(f, 256u);
+        uint32_t ch[4];
+        for (int k = 0; k < 4; k++)
+        {
+            int shift = 24 - k * 8;
+            uint32_t a = gm_particles_channel(ps->color0, shift);
+            uint32_t b = gm_particles_channel(ps->color1, shift);
+            ch[k] = (a * (256 - f) + b * f) >> 8;
+        }
+        if (ps->additive)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                ch[k] = ch[k] * ch[3] / 255;
+            }
+            ch[3] = 255;
+        }
+        ps->ramp[i] = (ch[0] << 24) | (ch[1] << 16) | (ch[2] << 8) | ch[3];
+    }
+}
+
+// Starts up to n particles at x, y with the emitter's direction, speed and life.
+static int gm_particles_emit(gm_particles_t *ps, int n, float x, float y)
+{
+    n = SDL_min(n, ps->capacity - ps->count);
+    for (int k = 0; k < n; k++)
+    {
+        int i = ps->count++;
+        float a = ps->angle + (gm_particles_rand(ps) - 0.5f) * ps->spread;
+        float speed = ps->speed_min + gm_particles_rand(ps) * (ps->speed_max - ps->speed_min);
+        float life = ps->life_min + gm_particles_rand(ps) * (ps->life_max - ps->life_min);
+        ps->x[i] = x;
+        ps->y[i] = y;
+        ps->vx[i] = SDL_cosf(a) * speed;
+        ps->vy[i] = SDL_sinf(a) * speed;
+        ps->t[i] = 0.0f;
+        ps->rate[i] = 1.0f / SDL_max(life, 0.001f);
+    }
+    return n;
+}
+
+// Advances every particle by dt seconds: drag and gravity on the velocity,
+// then the velocity on the position and the rate on the age. Four at a time
+// where SDL reports SSE or NEON, the rest one by one.
+static void gm_particles_integrate(gm_particles_t *ps, float dt)
+{
+    const float damp = SDL_expf(-ps->drag * dt);
+    const float gdx = ps->gx * dt;
+    const float gdy = ps->gy * dt;
+    float *x = ps->x, *y = ps->y, *vx = ps->vx, *vy = ps->vy, *t = ps->t;
+    const float *rate = ps->rate;
+    int n = ps->count;
+    int i = 0;
+
+#if defined(SDL_SSE_INTRINSICS)
+    const __m128 v_damp = _mm_set1_ps(damp);
+    const __m128 v_gdx = _mm_set1_ps(gdx);
+    const __m128 v_gdy = _mm_set1_ps(gdy);
+    const __m128 v_dt = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 nvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vx + i), v_damp), v_gdx);
+        __m128 nvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), v_damp), v_gdy);
+        _mm_storeu_ps(vx + i, nvx);
+        _mm_storeu_ps(vy + i, nvy);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(nvx, v_dt)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(nvy, v_dt)));
+        _mm_storeu_ps(t + i, _mm_add_ps(_mm_loadu_ps(t + i), _mm_mul_ps(_mm_loadu_ps(rate + i), v_dt)));
+    }
+#elif defined(SDL_NEON_INTRINSICS)
+    const float32x4_t v_damp = vdupq_n_f32(damp);
+    const float32x4_t v_gdx = vdupq_n_f32(gdx);
+    const float32x4_t v_gdy = vdupq_n_f32(gdy);
+    const float32x4_t v_dt = vdupq_n_f32(dt);
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t nvx = vmlaq_f32(v_gdx, vld1q_f32(vx + i), v_damp);
+        float32x4_t nvy = vmlaq_f32(v_gdy, vld1q_f32(vy + i), v_damp);
+        vst1q_f32(vx + i, nvx);
+        vst1q_f32(vy + i, nvy);
+        vst1q_f32(x + i, vmlaq_f32(vld1q_f32(x + i), nvx, v_dt));
+        vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), nvy, v_dt));
+        vst1q_f32(t + i, vmlaq_f32(vld1q_f32(t + i), vld1q_f32(rate + i), v_dt));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        vx[i] = vx[i] * damp + gdx;
+        vy[i] = vy[i] * damp + gdy;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        t[i] += rate[i] * dt;
+    }
+}
+
+// Drops the particles that reached the end of their life, the last one takes each gap.
+static void gm_particles_compact(gm_particles_t *ps)
+{
+    int n = ps->count;
+    for (int i = 0; i < n;)
+    {
+        if (ps->t[i] < 1.0f)
+        {
+            i++;
+            continue;
+        }
+        n--;
+        ps->x[i] = ps->x[n];
+        ps->y[i] = ps->y[n];
+        ps->vx[i] = ps->vx[n];
+        ps->vy[i] = ps->vy[n];
+        ps->t[i] = ps->t[n];
+        ps->rate[i] = ps->rate[n];
+    }
+    ps->count = n;
+}
+
+static inline uint32_t gm_particles_add(uint32_t a, uint32_t b)
+{
+    uint32_t r = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t s = gm_particles_channel(a, shift) + gm_particles_channel(b, shift);
+        r |= SDL_min(s, 255u) << shift;
+    }
+    return r;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_particles_ctx_t *gm_particles_upvalue(lua_State *L)
+{
+    return (gm_particles_ctx_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static gm_particles_t *gm_particles_check(lua_State *L, int idx)
+{
+    return (gm_particles_t *)luaL_checkudata(L, idx, GM_PARTICLES_MT);
+}
+
+// gm.newParticles(capacity [, seed]), without a seed one is drawn from math.random
+// so recorded sessions replay the same particles
+static int gm_particles_lua_new(lua_State *L)
+{
+    lua_Integer capacity = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, capacity > 0 && capacity <= GM_PARTICLES_MAX, 1, "capacity out of range");
+    uint64_t seed;
+    if (lua_isnoneornil(L, 2))
+    {
+        lua_getglobal(L, LUA_MATHLIBNAME);
+        lua_getfield(L, -1, "random");
+        lua_pushinteger(L, 0);
+        lua_call(L, 1, 1);
+        seed = (uint64_t)lua_tointeger(L, -1);
+        lua_pop(L, 2);
+    }
+    else
+    {
+        seed = (uint64_t)luaL_checkinteger(L, 2);
+    }
+
+    gm_particles_t *ps = (gm_particles_t *)lua_newuserdatauv(L, sizeof(gm_particles_t), 0);
+    memset(ps, 0, sizeof(gm_particles_t));
+    luaL_setmetatable(L, GM_PARTICLES_MT);
+
+    ps->block = (float *)malloc(sizeof(float) * GM_PARTICLES_ARRAYS * (size_t)capacity);
+    if (ps->block == NULL)
+    {
+        return luaL_error(L, "out of memory for %d particles", (int)capacity);
+    }
+    ps->capacity = (int)capacity;
+    ps->x = ps->block;
+    ps->y = ps->x + capacity;
+    ps->vx = ps->y + capacity;
+    ps->vy = ps->vx + capacity;
+    ps->t = ps->vy + capacity;
+    ps->rate = ps->t + capacity;
+
+    ps->spread = 2.0f * SDL_PI_F;
+    ps->speed_min = 20.0f;
+    ps->speed_max = 40.0f;
+    ps->life_min = 1.0f;
+    ps->life_max = 2.0f;
+    ps->color0 = 0xffffffffu;
+    ps->color1 = 0xffffff00u;
+    ps->rng = (seed ^ 0x9E3779B97F4A7C15ull) ? (seed ^ 0x9E3779B97F4A7C15ull) : 1;
+    gm_particles_build_ramp(ps);
+    return 1;
+}
+
+static int gm_particles_lua_gc(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    free(ps->block);
+    ps->block = NULL;
+    ps->capacity = 0;
+    ps->count = 0;
+    if (ps->texture)
+    {
+        SDL_DestroyTexture(ps->texture);
+        ps->texture = NULL;
+    }
+    return 0;
+}
+
+// ps:setEmitter(x, y [, rate]), rate is in particles per second, emitted by ps:update
+static int gm_particles_lua_set_emitter(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->ex = (float)luaL_checknumber(L, 2);
+    ps->ey = (float)luaL_checknumber(L, 3);
+    if (!lua_isnoneornil(L, 4))
+    {
+        lua_Number rate = luaL_checknumber(L, 4);
+        luaL_argcheck(L, rate >= 0, 4, "negative rate");
+        ps->emit_rate = (float)rate;
+    }
+    return 0;
+}
+
+// ps:setDirection(angle, spread), in radians, particles leave within angle +- spread / 2
+static int gm_particles_lua_set_direction(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->angle = (float)luaL_checknumber(L, 2);
+    ps->spread = (float)luaL_optnumber(L, 3, 0.0);
+    return 0;
+}
+
+// ps:setSpeed(min [, max]) in pixels per second
+static int gm_particles_lua_set_speed(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->speed_min = (float)luaL_checknumber(L, 2);
+    ps->speed_max = (float)luaL_optnumber(L, 3, ps->speed_min);
+    return 0;
+}
+
+// ps:setLife(min [, max]) in seconds
+static int gm_particles_lua_set_life(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    lua_Number min = luaL_checknumber(L, 2);
+    lua_Number max = luaL_optnumber(L, 3, min);
+    luaL_argcheck(L, min > 0 && max >= min, 2, "invalid life");
+    ps->life_min = (float)min;
+    ps->life_max = (float)max;
+    return 0;
+}
+
+// ps:setGravity(gx, gy) in pixels per second squared
+static int gm_particles_lua_set_gravity(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->gx = (float)luaL_checknumber(L, 2);
+    ps->gy = (float)luaL_checknumber(L, 3);
+    return 0;
+}
+
+// ps:setDrag(d), the velocity shrinks by a factor e^-d each second
+static int gm_particles_lua_set_drag(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    lua_Number drag = luaL_checknumber(L, 2);
+    luaL_argcheck(L, drag >= 0, 2, "negative drag");
+    ps->drag = (float)drag;
+    return 0;
+}
+
+// ps:setColors(start [, finish]), colours as packed by gm.rgba; finish defaults to start faded out
+static int gm_particles_lua_set_colors(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->color0 = (uint32_t)luaL_checkinteger(L, 2);
+    ps->color1 = lua_isnoneornil(L, 3) ? (ps->color0 & 0xffffff00u) : (uint32_t)luaL_checkinteger(L, 3);
+    gm_particles_build_ramp(ps);
+    return 0;
+}
+
+// ps:setBlend("alpha" | "add")
+static int gm_particles_lua_set_blend(lua_State *L)
+{
+    static const char *modes[] = {"alpha", "add", NULL};
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->additive = luaL_checkoption(L, 2, NULL, modes) == 1;
+    gm_particles_build_ramp(ps);
+    return 0;
+}
+
+// ps:emit(n [, x, y]) starts n particles at once, at the emitter unless x, y are given.
+// Returns how many were started, fewer once the system is full.
+static int gm_particles_lua_emit(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    lua_Integer n = luaL_checkinteger(L, 2);
+    float x = (float)luaL_optnumber(L, 3, ps->ex);
+    float y = (float)luaL_optnumber(L, 4, ps->ey);
+    lua_pushinteger(L, gm_particles_emit(ps, (int)SDL_clamp(n, 0, GM_PARTICLES_MAX), x, y));
+    return 1;
+}
+
+// ps:update(dt), dt in milliseconds like draw's
+static int gm_particles_lua_update(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    float dt = (float)luaL_checknumber(L, 2) / 1000.0f;
+    if (dt <= 0.0f)
+    {
+        return 0;
+    }
+
+    gm_particles_integrate(ps, dt);
+    gm_particles_compact(ps);
+
+    // a long dt or a huge rate cannot ask for more than the system holds, and keeps the cast in range
+    ps->emit_acc += ps->emit_rate * dt;
+    if (!(ps->emit_acc >= 0.0f))
+    {
+        ps->emit_acc = 0.0f;
+    }
+    ps->emit_acc = SDL_min(ps->emit_acc, (float)ps->capacity);
+    int n = (int)ps->emit_acc;
+    ps->emit_acc -= (float)n;
+    gm_particles_emit(ps, n, ps->ex, ps->ey);
+    return 0;
+}
+
+static int gm_particles_lua_count(lua_State *L)
+{
+    lua_pushinteger(L, gm_particles_check(L, 1)->count);
+    return 1;
+}
+
+static int gm_particles_lua_clear(lua_State *L)
+{
+    gm_particles_t *ps = gm_particles_check(L, 1);
+    ps->count = 0;
+    ps->emit_acc = 0.0f;
+    return 0;
+}
+
+// gm:drawParticles(ps), one pixel per particle, splatted into a canvas sized
+// texture that is drawn in a single call
+static int gm_particles_lua_draw(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_particles_ctx_t *ctx = gm_particles_upvalue(L);
+    gm_particles_t *ps = gm_particles_check(L, 2);
+    if (ps->count == 0)
+    {
+        return 0;
+    }
+
+    if (ps->texture == NULL)
+    {
+        ps->texture = SDL_CreateTexture(ctx->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, ctx->w, ctx->h);
+        if (ps->texture == NULL)
+        {
+            return luaL_error(L, "could not create particle texture: %s", SDL_GetError());
+        }
+        SDL_SetTextureScaleMode(ps->texture, SDL_SCALEMODE_NEAREST);
+    }
+    SDL_SetTextureBlendMode(ps->texture, ps->additive ? SDL_BLENDMODE_ADD : SDL_BLENDMODE_BLEND);
+
+    void *pixels = NULL;
+    int pitch = 0;
+    if (!SDL_LockTexture(ps->texture, NULL, &pixels, &pitch))
+    {
+        return luaL_error(L, "could not lock particle texture: %s", SDL_GetError());
+    }
+    for (int y = 0; y < ctx->h; y++)
+    {
+        memset((uint8_t *)pixels + (size_t)y * (size_t)pitch, 0, sizeof(uint32_t) * (size_t)ctx->w);
+    }
+
+    const float w = (float)ctx->w, h = (float)ctx->h;
+    const float top = (float)(GM_PARTICLES_RAMP - 1);
+    for (int i = 0; i < ps->count; i++)
+    {
+        float px = ps->x[i], py = ps->y[i];
+        if (!(px >= 0.0f && px < w && py >= 0.0f && py < h))
+        {
+            continue;
+        }
+        uint32_t *dst = (uint32_t *)((uint8_t *)pixels + (size_t)(int)py * (size_t)pitch) + (int)px;
+        uint32_t c = ps->ramp[(int)SDL_min(ps->t[i] * top, top)];
+        *dst = ps->additive ? gm_particles_add(*dst, c) : c;
+    }
+    SDL_UnlockTexture(ps->texture);
+
+    // the texture is canvas sized, drawn at the origin of whatever the target is
+    SDL_FRect dst = {0.0f, 0.0f, (float)ctx->w, (float)ctx->h};
+    SDL_RenderTexture(ctx->renderer, ps->texture, NULL, &dst);
+    return 0;
+}
+
+void gm_particles_register_lua(gm_particles_ctx_t *ctx, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"setEmitter", gm_particles_lua_set_emitter},
+        {"setDirection", gm_particles_lua_set_direction},
+        {"setSpeed", gm_particles_lua_set_speed},
+        {"setLife", gm_particles_lua_set_life},
+        {"setGravity", gm_particles_lua_set_gravity},
+        {"setDrag", gm_particles_lua_set_drag},
+        {"setColors", gm_particles_lua_set_colors},
+        {"setBlend", gm_particles_lua_set_blend},
+        {"emit", gm_particles_lua_emit},
+        {"update", gm_particles_lua_update},
+        {"count", gm_particles_lua_count},
+        {"clear", gm_particles_lua_clear},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"newParticles", gm_particles_lua_new},
+        {"drawParticles", gm_particles_lua_draw},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_PARTICLES_MT);
+    lua_pushcfunction(L, gm_particles_lua_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, ctx);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
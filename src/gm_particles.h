@@ -0,0 +1,76 @@
+#ifndef __GM_PARTICLES_H__
+#define __GM_PARTICLES_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#define GM_PARTICLES_MT "gm.particles"
+#define GM_PARTICLES_MAX (1024 * 1024)
+
+// colours over a particle's life, looked up instead of blended per particle
+#define GM_PARTICLES_RAMP 64
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+
+    // size of the layer particles are drawn into, the canvas size
+    int w;
+    int h;
+} gm_particles_ctx_t;
+
+// Lua userdata behind gm.newParticles. Particles are kept as a structure of arrays,
+// live ones packed at the front, so the update loops run over plain float arrays.
+typedef struct
+{
+    int capacity;
+    int count;
+
+    // one block holds all the arrays, each capacity floats long
+    float *block;
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+
+    // age from 0 to 1, and how much of it passes per second
+    float *t;
+    float *rate;
+
+    // emitter
+    float ex;
+    float ey;
+    float emit_rate;
+    float emit_acc;
+    float angle;
+    float spread;
+    float speed_min;
+    float speed_max;
+    float life_min;
+    float life_max;
+
+    // integration
+    float gx;
+    float gy;
+    float drag;
+
+    // start and end colours as packed by gm.rgba, and the ramp between them
+    uint32_t color0;
+    uint32_t color1;
+    uint32_t ramp[GM_PARTICLES_RAMP];
+    bool additive;
+    uint64_t rng;
+
+    // canvas sized layer the particles are splatted into, created on first draw
+    SDL_Texture *texture;
+} gm_particles_t;
+
+int gm_particles_init(gm_particles_ctx_t **ctx, SDL_Renderer *renderer, int w, int h);
+void gm_particles_shutdown(gm_particles_ctx_t *ctx);
+
+// Adds gm.newParticles and gm:drawParticles to the game API.
+void gm_particles_register_lua(gm_particles_ctx_t *ctx, lua_State *L);
+
+#endif // __GM_PARTICLES_H__
@@ -0,0 +1,549 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_post.h"
+#include "gm_lua.h"
+#include "gm_trace.h"
+
+#define GM_POST_DEFAULT_SCANLINES 0.35f
+#define GM_POST_DEFAULT_VIGNETTE 0.5f
+#define GM_POST_DEFAULT_CURVATURE 0.15f
+#define GM_POST_DEFAULT_BLOOM 0.6f
+#define GM_POST_DEFAULT_THRESHOLD 0.7f
+
+// box blur radius of the bloom, in bloom pixels
+#define GM_POST_BLUR 2
+
+int gm_post_init(gm_post_t **post, SDL_Renderer *renderer, int w, int h)
+{
+    (*post) = (gm_post_t *)calloc(sizeof(gm_post_t), 1);
+    if ((*post) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_post_t.\n");
+        return 1;
+    }
+
+    (*post)->renderer = renderer;
+    (*post)->w = w;
+    (*post)->h = h;
+    (*post)->bloom_threshold = GM_POST_DEFAULT_THRESHOLD;
+
+    // two triangles per grid cell, shared by the screen and the vignette
+    int *idx = (*post)->indices;
+    for (int y = 0; y < GM_POST_MESH; y++)
+    {
+        for (int x = 0; x < GM_POST_MESH; x++)
+        {
+            int i = y * (GM_POST_MESH + 1) + x;
+            *idx++ = i;
+            *idx++ = i + 1;
+            *idx++ = i + GM_POST_MESH + 1;
+            *idx++ = i + 1;
+            *idx++ = i + GM_POST_MESH + 2;
+            *idx++ = i + GM_POST_MESH + 1;
+        }
+    }
+    return 0;
+}
+
+static void gm_post_free_bloom(gm_post_t *post)
+{
+    if (post->bloom_texture)
+    {
+        SDL_DestroyTexture(post->bloom_texture);
+        post->bloom_texture = NULL;
+    }
+    free(post->bloom_pixels);
+    free(post->bloom_tmp);
+    post->bloom_pixels = NULL;
+    post->bloom_tmp = NULL;
+}
+
+void gm_post_shutdown(gm_post_t *post)
+{
+    if (post)
+    {
+        gm_post_free_bloom(post);
+        if (post->processed)
+        {
+            SDL_DestroyTexture(post->processed);
+        }
+        free(post->lut);
+        free(post->lines);
+        free(post);
+    }
+}
+
+static float gm_post_clamp(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Maps every 15 bit colour to the nearest palette entry, alpha is taken from the pixel.
+static int gm_post_build_lut(gm_post_t *post)
+{
+    if (post->lut == NULL)
+    {
+        post->lut = (uint32_t *)malloc(sizeof(uint32_t) * 32768);
+        if (post->lut == NULL)
+        {
+            return 1;
+        }
+    }
+
+    for (int c = 0; c < 32768; c++)
+    {
+        int r = (c >> 10) & 31, g = (c >> 5) & 31, b = c & 31;
+        r = (r << 3) | (r >> 2);
+        g = (g << 3) | (g >> 2);
+        b = (b << 3) | (b >> 2);
+
+        uint32_t best = 0;
+        int best_d = 0x7fffffff;
+        for (int i = 0; i < post->palette_count; i++)
+        {
+            uint32_t p = post->palette[i];
+            int dr = (int)(p >> 24) - r;
+            int dg = (int)((p >> 16) & 0xff) - g;
+            int db = (int)((p >> 8) & 0xff) - b;
+            // weighted towards green, like the eye
+            int d = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+            if (d < best_d)
+            {
+                best_d = d;
+                best = p & 0xffffff00u;
+            }
+        }
+        post->lut[c] = best;
+    }
+    return 0;
+}
+
+static void gm_post_apply_palette(gm_post_t *post, uint32_t *pixels, int pitch)
+{
+    const uint32_t *lut = post->lut;
+    for (int y = 0; y < post->h; y++)
+    {
+        uint32_t *row = (uint32_t *)((uint8_t *)pixels + (size_t)y * pitch);
+        for (int x = 0; x < post->w; x++)
+        {
+            uint32_t p = row[x];
+            uint32_t key = ((p >> 17) & 0x7c00) | ((p >> 14) & 0x03e0) | ((p >> 11) & 0x001f);
+            row[x] = lut[key] | (p & 0xff);
+        }
+    }
+}
+
+static int gm_post_alloc_bloom(gm_post_t *post)
+{
+    if (post->bloom_pixels)
+    {
+        return 0;
+    }
+
+    post->bloom_w = (post->w + GM_POST_BLOOM_SCALE - 1) / GM_POST_BLOOM_SCALE;
+    post->bloom_h = (post->h + GM_POST_BLOOM_SCALE - 1) / GM_POST_BLOOM_SCALE;
+    size_t n = (size_t)post->bloom_w * post->bloom_h;
+    post->bloom_pixels = (uint32_t *)malloc(sizeof(uint32_t) * n);
+    post->bloom_tmp = (uint32_t *)malloc(sizeof(uint32_t) * n);
+    post->bloom_texture = SDL_CreateTexture(post->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
+                                            post->bloom_w, post->bloom_h);
+    if (post->bloom_pixels == NULL || post->bloom_tmp == NULL || post->bloom_texture == NULL)
+    {
+        SDL_Log("Unable to create the bloom buffers: %s\n", SDL_GetError());
+        gm_post_free_bloom(post);
+        return 1;
+    }
+    SDL_SetTextureScaleMode(post->bloom_texture, SDL_SCALEMODE_LINEAR);
+    SDL_SetTextureBlendMode(post->bloom_texture, SDL_BLENDMODE_ADD);
+    return 0;
+}
+
+// Box blur of len pixels step apart, from src into dst.
+static void gm_post_blur_line(const uint32_t *src, uint32_t *dst, int len, int step)
+{
+    for (int i = 0; i < len; i++)
+    {
+        int r = 0, g = 0, b = 0, n = 0;
+        int lo = i - GM_POST_BLUR < 0 ? 0 : i - GM_POST_BLUR;
+        int hi = i + GM_POST_BLUR >= len ? len - 1 : i + GM_POST_BLUR;
+        for (int k = lo; k <= hi; k++)
+        {
+            uint32_t p = src[(size_t)k * step];
+            r += p >> 24;
+            g += (p >> 16) & 0xff;
+            b += (p >> 8) & 0xff;
+            n++;
+        }
+        dst[(size_t)i * step] = ((uint32_t)(r / n) << 24) | ((uint32_t)(g / n) << 16) | ((uint32_t)(b / n) << 8) | 0xff;
+    }
+}
+
+// Keeps what is brighter than the threshold at a quarter of the size, then blurs it.
+static void gm_post_build_bloom(gm_post_t *post, const uint32_t *pixels, int pitch)
+{
+    int bw = post->bloom_w, bh = post->bloom_h;
+    int threshold = (int)(post->bloom_threshold * 255.0f);
+    int range = 255 - threshold > 0 ? 255 - threshold : 1;
+
+    for (int by = 0; by < bh; by++)
+    {
+        for (int bx = 0; bx < bw; bx++)
+        {
+            int r = 0, g = 0, b = 0;
+            int y1 = (by + 1) * GM_POST_BLOOM_SCALE > post->h ? post->h : (by + 1) * GM_POST_BLOOM_SCALE;
+            int x1 = (bx + 1) * GM_POST_BLOOM_SCALE > post->w ? post->w : (bx + 1) * GM_POST_BLOOM_SCALE;
+            for (int y = by * GM_POST_BLOOM_SCALE; y < y1; y++)
+            {
+                const uint32_t *row = (const uint32_t *)((const uint8_t *)pixels + (size_t)y * pitch);
+                for (int x = bx * GM_POST_BLOOM_SCALE; x < x1; x++)
+                {
+                    uint32_t p = row[x];
+                    int pr = p >> 24, pg = (p >> 16) & 0xff, pb = (p >> 8) & 0xff;
+                    int lum = pr > pg ? (pr > pb ? pr : pb) : (pg > pb ? pg : pb);
+                    if (lum > threshold)
+                    {
+                        // fade in above the threshold so the glow has no hard edge
+                        int k = ((lum - threshold) * 256) / range;
+                        r += (pr * k) >> 8;
+                        g += (pg * k) >> 8;
+                        b += (pb * k) >> 8;
+                    }
+                }
+            }
+            const int area = GM_POST_BLOOM_SCALE * GM_POST_BLOOM_SCALE;
+            post->bloom_tmp[by * bw + bx] = ((uint32_t)(r / area) << 24) | ((uint32_t)(g / area) << 16) |
+                                            ((uint32_t)(b / area) << 8) | 0xff;
+        }
+    }
+
+    for (int y = 0; y < bh; y++)
+    {
+        gm_post_blur_line(post->bloom_tmp + (size_t)y * bw, post->bloom_pixels + (size_t)y * bw, bw, 1);
+    }
+    for (int x = 0; x < bw; x++)
+    {
+        gm_post_blur_line(post->bloom_pixels + x, post->bloom_tmp + x, bh, bw);
+    }
+    SDL_UpdateTexture(post->bloom_texture, NULL, post->bloom_tmp, bw * (int)sizeof(uint32_t));
+}
+
+// Reads the canvas back and runs the palette and bloom passes on it.
+// Returns the texture to composite, the canvas itself if the palette is off.
+static SDL_Texture *gm_post_cpu_pass(gm_post_t *post, SDL_Texture *canvas, bool *bloom_ready)
+{
+    SDL_Texture *previous = SDL_GetRenderTarget(post->renderer);
+    SDL_SetRenderTarget(post->renderer, canvas);
+    SDL_Surface *surface = SDL_RenderReadPixels(post->renderer, NULL);
+    SDL_SetRenderTarget(post->renderer, previous);
+    if (surface == NULL)
+    {
+        return canvas;
+    }
+    if (surface->format != SDL_PIXELFORMAT_RGBA8888)
+    {
+        SDL_Surface *converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA8888);
+        SDL_DestroySurface(surface);
+        if (converted == NULL)
+        {
+            return canvas;
+        }
+        surface = converted;
+    }
+    if (surface->w != post->w || surface->h != post->h)
+    {
+        SDL_DestroySurface(surface);
+        return canvas;
+    }
+
+    SDL_Texture *out = canvas;
+    if (post->palette_count > 0 && post->lut)
+    {
+        if (post->processed == NULL)
+        {
+            post->processed = SDL_CreateTexture(post->renderer, SDL_PIXELFORMAT_RGBA8888,
+                                                SDL_TEXTUREACCESS_STREAMING, post->w, post->h);
+            if (post->processed)
+            {
+                SDL_ScaleMode mode = SDL_SCALEMODE_LINEAR;
+                SDL_GetTextureScaleMode(canvas, &mode);
+                SDL_SetTextureScaleMode(post->processed, mode);
+                SDL_SetTextureBlendMode(post->processed, SDL_BLENDMODE_BLEND);
+            }
+        }
+        if (post->processed)
+        {
+            gm_post_apply_palette(post, (uint32_t *)surface->pixels, surface->pitch);
+            SDL_UpdateTexture(post->processed, NULL, surface->pixels, surface->pitch);
+            out = post->processed;
+        }
+    }
+
+    if (post->bloom > 0.0f && gm_post_alloc_bloom(post) == 0)
+    {
+        gm_post_build_bloom(post, (const uint32_t *)surface->pixels, surface->pitch);
+        *bloom_ready = true;
+    }
+
+    SDL_DestroySurface(surface);
+    return out;
+}
+
+// Lays the grid over dst, pulled towards the centre by the curvature, and shades
+// the copy used for the vignette darker towards the corners.
+static void gm_post_build_mesh(gm_post_t *post, const SDL_FRect *dst)
+{
+    float c = post->curvature;
+    for (int j = 0; j <= GM_POST_MESH; j++)
+    {
+        for (int i = 0; i <= GM_POST_MESH; i++)
+        {
+            float u = (float)i / GM_POST_MESH;
+            float v = (float)j / GM_POST_MESH;
+            float nx = 2.0f * u - 1.0f;
+            float ny = 2.0f * v - 1.0f;
+            float r2 = nx * nx + ny * ny;
+            float f = 1.0f - c * r2 * 0.5f;
+            float shade = r2 * 0.5f > 1.0f ? 1.0f : r2 * 0.5f;
+
+            SDL_Vertex *m = &post->mesh[j * (GM_POST_MESH + 1) + i];
+            m->position.x = dst->x + dst->w * (0.5f + 0.5f * nx * f);
+            m->position.y = dst->y + dst->h * (0.5f + 0.5f * ny * f);
+            m->color = (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f};
+            m->tex_coord.x = u;
+            m->tex_coord.y = v;
+
+            SDL_Vertex *s = &post->shade[j * (GM_POST_MESH + 1) + i];
+            s->position = m->position;
+            s->color = (SDL_FColor){0.0f, 0.0f, 0.0f, post->vignette * shade * shade};
+            s->tex_coord.x = 0.0f;
+            s->tex_coord.y = 0.0f;
+        }
+    }
+    post->mesh_dst = *dst;
+    post->mesh_curvature = post->curvature;
+    post->mesh_vignette = post->vignette;
+    post->mesh_valid = true;
+}
+
+static void gm_post_draw(gm_post_t *post, SDL_Texture *texture, const SDL_FRect *dst)
+{
+    if (post->curvature > 0.0f)
+    {
+        SDL_RenderGeometry(post->renderer, texture, post->mesh, GM_POST_MESH_VERTICES, post->indices,
+                           GM_POST_MESH_INDICES);
+    }
+    else
+    {
+        SDL_RenderTexture(post->renderer, texture, NULL, dst);
+    }
+}
+
+// Darkens the lower half of every canvas row, or of every other window row when
+// the canvas is not scaled up enough for that to show.
+static void gm_post_draw_scanlines(gm_post_t *post, const SDL_FRect *dst)
+{
+    float pitch = dst->h / (float)post->h;
+    if (pitch < 2.0f)
+    {
+        pitch = 2.0f;
+    }
+    int count = (int)SDL_ceilf(dst->h / pitch);
+    if (count > post->lines_cap)
+    {
+        SDL_FRect *lines = (SDL_FRect *)realloc(post->lines, sizeof(SDL_FRect) * count);
+        if (lines == NULL)
+        {
+            return;
+        }
+        post->lines = lines;
+        post->lines_cap = count;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        post->lines[i] = (SDL_FRect){dst->x, dst->y + i * pitch + pitch * 0.5f, dst->w, pitch * 0.5f};
+    }
+    SDL_SetRenderDrawColor(post->renderer, 0, 0, 0, (Uint8)(post->scanlines * 255.0f));
+    SDL_RenderFillRects(post->renderer, post->lines, count);
+}
+
+void gm_post_composite(gm_post_t *post, SDL_Texture *canvas, const SDL_FRect *dst)
+{
+    uint64_t start = SDL_GetTicksNS();
+    SDL_Texture *texture = canvas;
+    bool bloom_ready = false;
+
+    if (post->palette_count > 0 || post->bloom > 0.0f)
+    {
+        uint64_t span = gm_trace_begin();
+        texture = gm_post_cpu_pass(post, canvas, &bloom_ready);
+        gm_trace_end("post_cpu", span);
+    }
+
+    if ((post->curvature > 0.0f || post->vignette > 0.0f) &&
+        (!post->mesh_valid || post->mesh_curvature != post->curvature || post->mesh_vignette != post->vignette ||
+         SDL_memcmp(&post->mesh_dst, dst, sizeof(SDL_FRect)) != 0))
+    {
+        gm_post_build_mesh(post, dst);
+    }
+
+    uint64_t span = gm_trace_begin();
+    gm_post_draw(post, texture, dst);
+    if (bloom_ready)
+    {
+        SDL_SetTextureAlphaModFloat(post->bloom_texture, post->bloom);
+        gm_post_draw(post, post->bloom_texture, dst);
+    }
+    gm_trace_end("post_composite", span);
+
+    if (post->scanlines > 0.0f || post->vignette > 0.0f)
+    {
+        span = gm_trace_begin();
+        Uint8 r, g, b, a;
+        SDL_BlendMode blend;
+        SDL_GetRenderDrawColor(post->renderer, &r, &g, &b, &a);
+        SDL_GetRenderDrawBlendMode(post->renderer, &blend);
+        SDL_SetRenderDrawBlendMode(post->renderer, SDL_BLENDMODE_BLEND);
+
+        if (post->scanlines > 0.0f)
+        {
+            gm_post_draw_scanlines(post, dst);
+        }
+        if (post->vignette > 0.0f)
+        {
+            SDL_RenderGeometry(post->renderer, NULL, post->shade, GM_POST_MESH_VERTICES, post->indices,
+                               GM_POST_MESH_INDICES);
+        }
+
+        SDL_SetRenderDrawBlendMode(post->renderer, blend);
+        SDL_SetRenderDrawColor(post->renderer, r, g, b, a);
+        gm_trace_end("post_overlay", span);
+    }
+
+    post->last_ns = SDL_GetTicksNS() - start;
+}
+
+static gm_post_t *gm_post_upvalue(lua_State *L)
+{
+    return (gm_post_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// Reads an on/off amount: a number, true for the default, false or nil for off.
+static float gm_post_check_amount(lua_State *L, int idx, float def, float max)
+{
+    if (lua_isnoneornil(L, idx))
+    {
+        return 0.0f;
+    }
+    if (lua_isboolean(L, idx))
+    {
+        return lua_toboolean(L, idx) ? def : 0.0f;
+    }
+    return gm_post_clamp((float)luaL_checknumber(L, idx), 0.0f, max);
+}
+
+static int gm_post_set_palette(lua_State *L, gm_post_t *post, int idx)
+{
+    if (lua_isnoneornil(L, idx) || (lua_isboolean(L, idx) && !lua_toboolean(L, idx)))
+    {
+        post->palette_count = 0;
+        return 0;
+    }
+
+    luaL_checktype(L, idx, LUA_TTABLE);
+    lua_Integer n = luaL_len(L, idx);
+    luaL_argcheck(L, n > 0 && n <= GM_POST_MAX_PALETTE, idx, "palette needs 1 to 256 colours");
+    for (lua_Integer i = 1; i <= n; i++)
+    {
+        lua_geti(L, idx, i);
+        int isnum = 0;
+        lua_Integer c = lua_tointegerx(L, -1, &isnum);
+        lua_pop(L, 1);
+        if (!isnum)
+        {
+            return luaL_argerror(L, idx, "palette entries must be colours from gm.rgba");
+        }
+        post->palette[i - 1] = (uint32_t)c;
+    }
+    post->palette_count = (int)n;
+    if (gm_post_build_lut(post))
+    {
+        post->palette_count = 0;
+        return luaL_error(L, "out of memory building the palette");
+    }
+    return 0;
+}
+
+// gm.setPostEffect(name, value) turns one effect on or off, gm.setPostEffect() turns them all off.
+//   "scanlines", "vignette": 0..1, "crt": screen curvature 0..0.5
+//   "bloom": strength 0..1 or {strength = s, threshold = t}
+//   "palette": table of gm.rgba colours the picture is mapped to
+static int gm_post_lua_set_effect(lua_State *L)
+{
+    static const char *names[] = {"scanlines", "vignette", "crt", "bloom", "palette", NULL};
+    gm_post_t *post = gm_post_upvalue(L);
+
+    if (lua_isnone(L, 1))
+    {
+        post->scanlines = 0.0f;
+        post->vignette = 0.0f;
+        post->curvature = 0.0f;
+        post->bloom = 0.0f;
+        post->palette_count = 0;
+        return 0;
+    }
+
+    switch (luaL_checkoption(L, 1, NULL, names))
+    {
+    case 0:
+        post->scanlines = gm_post_check_amount(L, 2, GM_POST_DEFAULT_SCANLINES, 1.0f);
+        break;
+    case 1:
+        post->vignette = gm_post_check_amount(L, 2, GM_POST_DEFAULT_VIGNETTE, 1.0f);
+        break;
+    case 2:
+        post->curvature = gm_post_check_amount(L, 2, GM_POST_DEFAULT_CURVATURE, 0.5f);
+        break;
+    case 3:
+        if (lua_istable(L, 2))
+        {
+            lua_getfield(L, 2, "strength");
+            post->bloom = gm_post_clamp((float)luaL_optnumber(L, -1, GM_POST_DEFAULT_BLOOM), 0.0f, 1.0f);
+            lua_getfield(L, 2, "threshold");
+            post->bloom_threshold =
+                gm_post_clamp((float)luaL_optnumber(L, -1, GM_POST_DEFAULT_THRESHOLD), 0.0f, 0.99f);
+            lua_pop(L, 2);
+        }
+        else
+        {
+            post->bloom = gm_post_check_amount(L, 2, GM_POST_DEFAULT_BLOOM, 1.0f);
+        }
+        break;
+    case 4:
+        return gm_post_set_palette(L, post, 2);
+    }
+    return 0;
+}
+
+// gm.postStats() returns the time the last composite took, in milliseconds
+static int gm_post_lua_stats(lua_State *L)
+{
+    gm_post_t *post = gm_post_upvalue(L);
+    lua_pushnumber(L, (lua_Number)post->last_ns / 1e6);
+    return 1;
+}
+
+void gm_post_register_lua(gm_post_t *post, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"setPostEffect", gm_post_lua_set_effect},
+        {"postStats", gm_post_lua_stats},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, post);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
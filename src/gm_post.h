@@ -0,0 +1,73 @@
+#ifndef __GM_POST_H__
+#define __GM_POST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#define GM_POST_MAX_PALETTE 256
+
+// the curved screen and the vignette are drawn as a GM_POST_MESH x GM_POST_MESH grid
+#define GM_POST_MESH 24
+#define GM_POST_MESH_VERTICES ((GM_POST_MESH + 1) * (GM_POST_MESH + 1))
+#define GM_POST_MESH_INDICES (GM_POST_MESH * GM_POST_MESH * 6)
+
+// bloom is computed at a quarter of the canvas resolution
+#define GM_POST_BLOOM_SCALE 4
+
+// Post-processing applied while the canvas is composited into the window.
+// Effects always run in the same order: palette, bloom (on the CPU, from a read
+// back of the canvas), then the curved screen, then scanlines and vignette on top.
+typedef struct
+{
+    SDL_Renderer *renderer;
+    int w;
+    int h;
+
+    // effect settings, 0 when off
+    float scanlines;
+    float vignette;
+    float curvature;
+    float bloom;
+    float bloom_threshold;
+    int palette_count;
+    uint32_t palette[GM_POST_MAX_PALETTE];
+
+    // nearest palette colour for every 15 bit colour, built when the palette is set
+    uint32_t *lut;
+    SDL_Texture *processed;
+
+    uint32_t *bloom_pixels;
+    uint32_t *bloom_tmp;
+    SDL_Texture *bloom_texture;
+    int bloom_w;
+    int bloom_h;
+
+    // screen grid, rebuilt when the destination or the settings change
+    SDL_Vertex mesh[GM_POST_MESH_VERTICES];
+    SDL_Vertex shade[GM_POST_MESH_VERTICES];
+    int indices[GM_POST_MESH_INDICES];
+    SDL_FRect mesh_dst;
+    float mesh_curvature;
+    float mesh_vignette;
+    bool mesh_valid;
+
+    // scanline rectangles, grown with the window
+    SDL_FRect *lines;
+    int lines_cap;
+
+    // time taken by the last composite, post-processing included
+    uint64_t last_ns;
+} gm_post_t;
+
+int gm_post_init(gm_post_t **post, SDL_Renderer *renderer, int w, int h);
+void gm_post_shutdown(gm_post_t *post);
+
+// Draws the canvas into dst on the current target with the effects that are on.
+void gm_post_composite(gm_post_t *post, SDL_Texture *canvas, const SDL_FRect *dst);
+
+// Adds gm.setPostEffect and gm.postStats to the game API.
+void gm_post_register_lua(gm_post_t *post, lua_State *L);
+
+#endif // __GM_POST_H__
@@ -0,0 +1,340 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_profile.h"
+#include "gm_lua.h"
+
+// name 0 stands in for every function once the name table is full
+#define GM_PROFILE_OVERFLOW_NAME "[too many functions]"
+
+static void gm_profile_hook(lua_State *L, void *userdata);
+
+int gm_profile_init(gm_profile_t **profile, gm_hook_t *hook, int hz)
+{
+    (*profile) = (gm_profile_t *)calloc(sizeof(gm_profile_t), 1);
+    if ((*profile) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_profile_t.\n");
+        return 1;
+    }
+
+    gm_profile_t *p = (*profile);
+    p->hook = hook;
+    p->period_ns = (hz > 0) ? SDL_NS_PER_SECOND / (uint64_t)hz : 0;
+    p->hook_id = gm_hook_add(hook, gm_profile_hook, p);
+    if (p->hook_id < 0)
+    {
+        free(p);
+        (*profile) = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+void gm_profile_shutdown(gm_profile_t *profile)
+{
+    if (profile)
+    {
+        gm_profile_enable(profile, false);
+        for (int i = 0; i < profile->name_count; i++)
+        {
+            free(profile->names[i]);
+        }
+        free(profile->names);
+        free(profile->name_hashes);
+        free(profile->stacks);
+        free(profile);
+    }
+}
+
+static uint32_t gm_profile_hash(const void *data, size_t size, uint32_t h)
+{
+    // FNV-1a
+    const uint8_t *b = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        h = (h ^ b[i]) * 16777619u;
+    }
+    return h;
+}
+
+static char *gm_profile_strdup(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *copy = (char *)malloc(len);
+    if (copy)
+    {
+        memcpy(copy, s, len);
+    }
+    return copy;
+}
+
+static bool gm_profile_alloc(gm_profile_t *p)
+{
+    if (p->stacks)
+    {
+        return true;
+    }
+
+    p->names = (char **)calloc(GM_PROFILE_MAX_NAMES, sizeof(char *));
+    p->name_hashes = (uint32_t *)calloc(GM_PROFILE_MAX_NAMES, sizeof(uint32_t));
+    p->stacks = (gm_profile_stack_t *)calloc(GM_PROFILE_MAX_STACKS, sizeof(gm_profile_stack_t));
+    if (p->names == NULL || p->name_hashes == NULL || p->stacks == NULL)
+    {
+        SDL_Log("Unable to allocate memory for the profiler tables.\n");
+        free(p->names);
+        free(p->name_hashes);
+        free(p->stacks);
+        p->names = NULL;
+        p->name_hashes = NULL;
+        p->stacks = NULL;
+        return false;
+    }
+
+    p->names[0] = gm_profile_strdup(GM_PROFILE_OVERFLOW_NAME);
+    p->name_count = 1;
+    return true;
+}
+
+// Returns the index of the frame's name, adding it on first sight.
+// Names are few and sampling is rare, so a linear scan of the hashes is enough.
+static uint16_t gm_profile_intern(gm_profile_t *p, const lua_Debug *ar)
+{
+    char name[160];
+    if (ar->what[0] == 'C')
+    {
+        SDL_snprintf(name, sizeof(name), "[C] %s", ar->name ? ar->name : "?");
+    }
+    else if (ar->what[0] == 'm')
+    {
+        SDL_snprintf(name, sizeof(name), "main chunk (%s)", ar->short_src);
+    }
+    else
+    {
+        SDL_snprintf(name, sizeof(name), "%s (%s:%d)", ar->name ? ar->name : "?", ar->short_src, ar->linedefined);
+    }
+
+    // ';' separates frames in the collapsed format
+    for (char *c = name; *c; c++)
+    {
+        if (*c == ';')
+        {
+            *c = ':';
+        }
+    }
+
+    uint32_t hash = gm_profile_hash(name, strlen(name), 2166136261u);
+    for (int i = 1; i < p->name_count; i++)
+    {
+        if (p->name_hashes[i] == hash && strcmp(p->names[i], name) == 0)
+        {
+            return (uint16_t)i;
+        }
+    }
+    if (p->name_count == GM_PROFILE_MAX_NAMES)
+    {
+        return 0;
+    }
+
+    char *copy = gm_profile_strdup(name);
+    if (copy == NULL)
+    {
+        return 0;
+    }
+    p->names[p->name_count] = copy;
+    p->name_hashes[p->name_count] = hash;
+    return (uint16_t)p->name_count++;
+}
+
+static void gm_profile_sample(gm_profile_t *p, lua_State *L, uint32_t weight)
+{
+    // walk from the running function (level 0) to the root
+    uint16_t leaf_first[GM_PROFILE_MAX_DEPTH];
+    int depth = 0;
+    lua_Debug ar;
+    for (int level = 0; depth < GM_PROFILE_MAX_DEPTH && lua_getstack(L, level, &ar); level++)
+    {
+        lua_getinfo(L, "Sn", &ar);
+        leaf_first[depth++] = gm_profile_intern(p, &ar);
+    }
+
+    gm_profile_stack_t key;
+    key.depth = (uint16_t)depth;
+    for (int i = 0; i < depth; i++)
+    {
+        key.frames[i] = leaf_first[depth - 1 - i];
+    }
+    key.hash = gm_profile_hash(key.frames, sizeof(uint16_t) * (size_t)depth, 2166136261u);
+
+    uint32_t mask = GM_PROFILE_MAX_STACKS - 1;
+    for (uint32_t i = key.hash & mask;; i = (i + 1) & mask)
+    {
+        gm_profile_stack_t *s = &p->stacks[i];
+        if (s->count == 0)
+        {
+            // keep the table at most 3/4 full so probes stay short
+            if (p->stack_count >= GM_PROFILE_MAX_STACKS / 4 * 3)
+            {
+                p->dropped += weight;
+                return;
+            }
+            memcpy(s, &key, sizeof(gm_profile_stack_t));
+            s->count = weight;
+            p->stack_count++;
+            break;
+        }
+        if (s->hash == key.hash && s->depth == key.depth &&
+            memcmp(s->frames, key.frames, sizeof(uint16_t) * (size_t)depth) == 0)
+        {
+            s->count += weight;
+            break;
+        }
+    }
+    p->samples += weight;
+}
+
+static void gm_profile_hook(lua_State *L, void *userdata)
+{
+    gm_profile_t *p = (gm_profile_t *)userdata;
+    uint32_t weight = 1;
+    if (p->period_ns > 0)
+    {
+        uint64_t now = SDL_GetTicksNS();
+        if (now < p->next_ns)
+        {
+            return;
+        }
+
+        // a long native call between two hooks counts for every period it covered
+        weight += (uint32_t)((now - p->next_ns) / p->period_ns);
+        p->next_ns = now + p->period_ns;
+    }
+    gm_profile_sample(p, L, weight);
+}
+
+void gm_profile_enable(gm_profile_t *profile, bool enable)
+{
+    if (enable && !gm_profile_alloc(profile))
+    {
+        return;
+    }
+    if (enable == profile->enabled)
+    {
+        return;
+    }
+
+    profile->enabled = enable;
+    profile->next_ns = SDL_GetTicksNS() + profile->period_ns;
+    gm_hook_enable(profile->hook, profile->hook_id, enable);
+    SDL_Log("Lua profiler %s\n", enable ? "started" : "stopped");
+}
+
+void gm_profile_begin_frame(gm_profile_t *profile)
+{
+    if (profile->enabled)
+    {
+        profile->next_ns = SDL_GetTicksNS() + profile->period_ns;
+    }
+}
+
+void gm_profile_reset(gm_profile_t *profile)
+{
+    if (profile->stacks)
+    {
+        memset(profile->stacks, 0, sizeof(gm_profile_stack_t) * GM_PROFILE_MAX_STACKS);
+    }
+    profile->stack_count = 0;
+    profile->samples = 0;
+    profile->dropped = 0;
+}
+
+int gm_profile_write(gm_profile_t *profile, const char *path)
+{
+    if (profile->samples == 0)
+    {
+        SDL_Log("No profile samples to write.\n");
+        return 1;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("Could not write profile %s: %s\n", path, SDL_GetError());
+        return 1;
+    }
+
+    for (int i = 0; i < GM_PROFILE_MAX_STACKS; i++)
+    {
+        const gm_profile_stack_t *s = &profile->stacks[i];
+        if (s->count == 0)
+        {
+            continue;
+        }
+        for (int f = 0; f < s->depth; f++)
+        {
+            SDL_IOprintf(io, f ? ";%s" : "%s", profile->names[s->frames[f]]);
+        }
+        SDL_IOprintf(io, " %u\n", s->count);
+    }
+    SDL_CloseIO(io);
+
+    SDL_Log("Profile written to %s: %llu samples, %d stacks, %llu dropped\n", path,
+            (unsigned long long)profile->samples, profile->stack_count, (unsigned long long)profile->dropped);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_profile_t *gm_profile_upvalue(lua_State *L)
+{
+    return (gm_profile_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// gm.profile(on), returns whether the profiler was running
+static int gm_profile_lua_enable(lua_State *L)
+{
+    gm_profile_t *p = gm_profile_upvalue(L);
+    bool was = p->enabled;
+    if (!lua_isnone(L, 1))
+    {
+        gm_profile_enable(p, lua_toboolean(L, 1));
+    }
+    lua_pushboolean(L, was);
+    return 1;
+}
+
+// gm.profileSave([path [, reset]]), returns the number of samples written
+static int gm_profile_lua_save(lua_State *L)
+{
+    gm_profile_t *p = gm_profile_upvalue(L);
+    const char *path = luaL_optstring(L, 1, GM_PROFILE_FILE);
+    lua_Integer samples = (lua_Integer)p->samples;
+    if (gm_profile_write(p, path) != 0)
+    {
+        samples = 0;
+    }
+    if (lua_toboolean(L, 2))
+    {
+        gm_profile_reset(p);
+    }
+    lua_pushinteger(L, samples);
+    return 1;
+}
+
+void gm_profile_register_lua(gm_profile_t *profile, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"profile", gm_profile_lua_enable},
+        {"profileSave", gm_profile_lua_save},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, profile);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
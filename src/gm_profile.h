@@ -0,0 +1,72 @@
+#ifndef __GM_PROFILE_H__
+#define __GM_PROFILE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <lua.h>
+
+#include "gm_hook.h"
+
+#define GM_PROFILE_FILE "profile.folded"
+
+// the shared hook runs every GM_HOOK_COUNT VM instructions and a sample is taken when it is due
+#define GM_PROFILE_COUNT GM_HOOK_COUNT
+#define GM_PROFILE_MAX_HZ 10000
+#define GM_PROFILE_DEFAULT_HZ 1000
+
+#define GM_PROFILE_MAX_DEPTH 64
+#define GM_PROFILE_MAX_NAMES 4096
+#define GM_PROFILE_MAX_STACKS 8192
+
+// One distinct call stack and how many samples landed in it
+typedef struct
+{
+    uint32_t hash;
+    uint32_t count;
+    uint16_t depth;
+    uint16_t frames[GM_PROFILE_MAX_DEPTH];
+} gm_profile_stack_t;
+
+// Sampling profiler for the game's Lua state. Stacks are aggregated across frames
+// and reloads until they are written out as collapsed stacks for flamegraph tools.
+typedef struct
+{
+    gm_hook_t *hook;
+    int hook_id;
+    bool enabled;
+
+    // time between samples, 0 samples on every hook (instruction count sampling)
+    uint64_t period_ns;
+    uint64_t next_ns;
+
+    // interned "function (source:line)" names, indexed by the stack frames
+    char **names;
+    uint32_t *name_hashes;
+    int name_count;
+
+    // open addressing table, allocated on the first start
+    gm_profile_stack_t *stacks;
+    int stack_count;
+
+    uint64_t samples;
+    uint64_t dropped;
+} gm_profile_t;
+
+// hz is the sampling rate, 0 to sample every GM_PROFILE_COUNT instructions instead.
+int gm_profile_init(gm_profile_t **profile, gm_hook_t *hook, int hz);
+void gm_profile_shutdown(gm_profile_t *profile);
+
+// Starts or stops sampling, stacks collected so far are kept.
+void gm_profile_enable(gm_profile_t *profile, bool enable);
+
+// Called before draw, so time spent outside Lua is not charged to the next sample.
+void gm_profile_begin_frame(gm_profile_t *profile);
+
+// Writes one "root;caller;callee count" line per stack, returns 0 on success.
+int gm_profile_write(gm_profile_t *profile, const char *path);
+void gm_profile_reset(gm_profile_t *profile);
+
+// Adds gm.profile(on) and gm.profileSave(path) to the game API.
+void gm_profile_register_lua(gm_profile_t *profile, lua_State *L);
+
+#endif // __GM_PROFILE_H__
@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "gm_replay.h"
+
+#define GM_REPLAY_TAG_FRAME 'F'
+#define GM_REPLAY_TAG_RELOAD 'R'
+
+static bool gm_replay_write_f32(SDL_IOStream *io, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return SDL_WriteU32LE(io, bits);
+}
+
+static bool gm_replay_read_f32(SDL_IOStream *io, float *value)
+{
+    uint32_t bits;
+    if (!SDL_ReadU32LE(io, &bits))
+    {
+        return false;
+    }
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+static gm_replay_t *gm_replay_alloc(void)
+{
+    gm_replay_t *rp = (gm_replay_t *)calloc(sizeof(gm_replay_t), 1);
+    if (rp == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_replay_t.\n");
+    }
+    return rp;
+}
+
+int gm_replay_record(gm_replay_t **replay, const char *path, uint64_t seed, int cvs_width, int cvs_height)
+{
+    (*replay) = gm_replay_alloc();
+    if ((*replay) == NULL)
+    {
+        return 1;
+    }
+
+    gm_replay_t *rp = (*replay);
+    rp->recording = true;
+    rp->seed = seed;
+    rp->cvs_width = cvs_width;
+    rp->cvs_height = cvs_height;
+
+    rp->io = SDL_IOFromFile(path, "wb");
+    if (rp->io == NULL)
+    {
+        SDL_Log("Could not create recording %s: %s\n", path, SDL_GetError());
+        free(rp);
+        (*replay) = NULL;
+        return 1;
+    }
+
+    bool ok = SDL_WriteIO(rp->io, GM_REPLAY_MAGIC, 4) == 4 &&
+              SDL_WriteU32LE(rp->io, GM_REPLAY_VERSION) &&
+              SDL_WriteU64LE(rp->io, seed) &&
+              SDL_WriteU32LE(rp->io, (uint32_t)cvs_width) &&
+              SDL_WriteU32LE(rp->io, (uint32_t)cvs_height);
+    if (!ok)
+    {
+        SDL_Log("Could not write recording %s: %s\n", path, SDL_GetError());
+        SDL_CloseIO(rp->io);
+        free(rp);
+        (*replay) = NULL;
+        return 1;
+    }
+
+    SDL_Log("Recording to %s, seed %" SDL_PRIu64 "\n", path, seed);
+    return 0;
+}
+
+int gm_replay_open(gm_replay_t **replay, const char *path)
+{
+    (*replay) = gm_replay_alloc();
+    if ((*replay) == NULL)
+    {
+        return 1;
+    }
+
+    gm_replay_t *rp = (*replay);
+    rp->io = SDL_IOFromFile(path, "rb");
+    if (rp->io == NULL)
+    {
+        SDL_Log("Could not open recording %s: %s\n", path, SDL_GetError());
+        free(rp);
+        (*replay) = NULL;
+        return 1;
+    }
+
+    char magic[4];
+    uint32_t version = 0, w = 0, h = 0;
+    bool ok = SDL_ReadIO(rp->io, magic, 4) == 4 &&
+              memcmp(magic, GM_REPLAY_MAGIC, 4) == 0 &&
+              SDL_ReadU32LE(rp->io, &version) &&
+              version == GM_REPLAY_VERSION &&
+              SDL_ReadU64LE(rp->io, &rp->seed) &&
+              SDL_ReadU32LE(rp->io, &w) &&
+              SDL_ReadU32LE(rp->io, &h);
+    if (!ok)
+    {
+        SDL_Log("%s is not a gmcore recording (version %d).\n", path, GM_REPLAY_VERSION);
+        SDL_CloseIO(rp->io);
+        free(rp);
+        (*replay) = NULL;
+        return 1;
+    }
+    rp->cvs_width = (int)w;
+    rp->cvs_height = (int)h;
+
+    SDL_Log("Replaying %s, seed %" SDL_PRIu64 ", canvas %ux%u\n", path, rp->seed, w, h);
+    return 0;
+}
+
+void gm_replay_close(gm_replay_t *replay)
+{
+    if (replay)
+    {
+        if (replay->io)
+        {
+            SDL_CloseIO(replay->io);
+        }
+        free(replay);
+    }
+}
+
+static void gm_replay_write_check(gm_replay_t *replay, bool ok)
+{
+    if (!ok)
+    {
+        SDL_Log("Could not write recording, recording stopped at frame %" SDL_PRIu64 ": %s\n", replay->frame,
+                SDL_GetError());
+        replay->write_failed = true;
+    }
+}
+
+void gm_replay_mark_reload(gm_replay_t *replay)
+{
+    if (replay->write_failed)
+    {
+        return;
+    }
+    gm_replay_write_check(replay, SDL_WriteU8(replay->io, GM_REPLAY_TAG_RELOAD));
+}
+
+void gm_replay_write_frame(gm_replay_t *replay, float dt, const gm_input_t *input)
+{
+    if (replay->write_failed)
+    {
+        return;
+    }
+    SDL_IOStream *io = replay->io;
+    bool ok = SDL_WriteU8(io, GM_REPLAY_TAG_FRAME) &&
+              gm_replay_write_f32(io, dt) &&
+              SDL_WriteU16LE(io, (uint16_t)input->count);
+    for (uint32_t i = 0; ok && i < input->count; i++)
+    {
+        const gm_input_event_t *ev = &input->ring[(input->head + i) % GM_INPUT_RING_SIZE];
+        ok = SDL_WriteU8(io, ev->kind) &&
+             SDL_WriteU16LE(io, ev->code) &&
+             gm_replay_write_f32(io, ev->x) &&
+             gm_replay_write_f32(io, ev->y);
+    }
+    gm_replay_write_check(replay, ok);
+}
+
+bool gm_replay_read_frame(gm_replay_t *replay, float *dt, bool *reload, gm_input_t *input)
+{
+    SDL_IOStream *io = replay->io;
+    uint8_t tag = 0;
+    *reload = false;
+
+    while (SDL_ReadU8(io, &tag))
+    {
+        if (tag == GM_REPLAY_TAG_RELOAD)
+        {
+            *reload = true;
+            continue;
+        }
+        if (tag != GM_REPLAY_TAG_FRAME)
+        {
+            SDL_Log("Corrupt recording at frame %" SDL_PRIu64 ".\n", replay->frame);
+            return false;
+        }
+
+        uint16_t count = 0;
+        if (!gm_replay_read_f32(io, dt) || !SDL_ReadU16LE(io, &count))
+        {
+            return false;
+        }
+        for (uint16_t i = 0; i < count; i++)
+        {
+            // timestamps are not recorded, a zero timestamp keeps replays out of the latency stats
+            gm_input_event_t ev;
+            memset(&ev, 0, sizeof(ev));
+            if (!SDL_ReadU8(io, &ev.kind) ||
+                !SDL_ReadU16LE(io, &ev.code) ||
+                !gm_replay_read_f32(io, &ev.x) ||
+                !gm_replay_read_f32(io, &ev.y))
+            {
+                return false;
+            }
+            if (ev.kind < GM_INPUT_KIND_COUNT)
+            {
+                gm_input_push(input, &ev);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void gm_replay_frame_time(gm_replay_t *replay, uint64_t ns)
+{
+    uint64_t frame = replay->frame++;
+    replay->total_ns += ns;
+
+    // keep the slowest frames sorted, slowest first
+    if (ns <= replay->slow_ns[GM_REPLAY_SLOWEST - 1])
+    {
+        return;
+    }
+    int i = GM_REPLAY_SLOWEST - 1;
+    while (i > 0 && replay->slow_ns[i - 1] < ns)
+    {
+        replay->slow_ns[i] = replay->slow_ns[i - 1];
+        replay->slow_frame[i] = replay->slow_frame[i - 1];
+        i--;
+    }
+    replay->slow_ns[i] = ns;
+    replay->slow_frame[i] = frame;
+}
+
+void gm_replay_report(const gm_replay_t *replay)
+{
+    if (replay->frame == 0)
+    {
+        return;
+    }
+
+    SDL_Log("%s: %" SDL_PRIu64 " frames, %.3f ms average\n",
+            replay->recording ? "Recorded" : "Replayed",
+            replay->frame, (double)replay->total_ns / (double)replay->frame / 1e6);
+    SDL_Log("Slowest frames:\n");
+    for (int i = 0; i < GM_REPLAY_SLOWEST && replay->slow_ns[i] != 0; i++)
+    {
+        SDL_Log("  frame %6" SDL_PRIu64 "  %8.3f ms\n", replay->slow_frame[i], (double)replay->slow_ns[i] / 1e6);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef __GM_REPLAY_H__
+#define __GM_REPLAY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+
+#include "gm_input.h"
+
+#define GM_REPLAY_MAGIC "GMRP"
+#define GM_REPLAY_VERSION 1
+
+// number of slowest frames kept for the report
+#define GM_REPLAY_SLOWEST 8
+
+// On-disk layout (little-endian):
+//   header: magic, u32 version, u64 seed, u32 canvas w, u32 canvas h
+//   records: 'R'                                      script reloaded before the next frame
+//            'F' f32 dt, u16 n, n * (u8 kind, u16 code, f32 x, f32 y)   one frame
+typedef struct
+{
+    SDL_IOStream *io;
+    bool recording;
+
+    // set on the first failed write, nothing is written after it
+    bool write_failed;
+    uint64_t seed;
+    int cvs_width;
+    int cvs_height;
+
+    uint64_t frame;
+
+    // slowest frames seen, by wall-clock frame time
+    uint64_t slow_frame[GM_REPLAY_SLOWEST];
+    uint64_t slow_ns[GM_REPLAY_SLOWEST];
+    uint64_t total_ns;
+} gm_replay_t;
+
+int gm_replay_record(gm_replay_t **replay, const char *path, uint64_t seed, int cvs_width, int cvs_height);
+int gm_replay_open(gm_replay_t **replay, const char *path);
+void gm_replay_close(gm_replay_t *replay);
+
+// Recording: a reload mark applies to the frame written next. A write error is
+// logged once and ends the recording, what was written before it stays readable.
+void gm_replay_mark_reload(gm_replay_t *replay);
+void gm_replay_write_frame(gm_replay_t *replay, float dt, const gm_input_t *input);
+
+// Playback: feeds the frame's events into input, returns false at the end of the recording.
+bool gm_replay_read_frame(gm_replay_t *replay, float *dt, bool *reload, gm_input_t *input);
+
+// Both modes: tracks the wall-clock time of the current frame and prints the slowest ones.
+void gm_replay_frame_time(gm_replay_t *replay, uint64_t ns);
+void gm_replay_report(const gm_replay_t *replay);
+
+#endif // __GM_REPLAY_H__
@@ -0,0 +1,671 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_spatial.h"
+#include "gm_array.h"
+#include "gm_lua.h"
+
+#define GM_SPATIAL_MIN_CELL_BITS 6
+#define GM_SPATIAL_MAX_CELL_BITS 24
+
+// cell coordinates are clamped so far away boxes cannot overflow an int
+#define GM_SPATIAL_MAX_COORD 1000000000.0f
+
+//----------------------------------------------------------------------------
+// Cells
+//----------------------------------------------------------------------------
+
+static inline uint64_t gm_spatial_key(int cx, int cy)
+{
+    return ((uint64_t)(uint32_t)cx << 32) | (uint64_t)(uint32_t)cy;
+}
+
+static inline int gm_spatial_key_x(uint64_t key)
+{
+    return (int)(int32_t)(uint32_t)(key >> 32);
+}
+
+static inline int gm_spatial_key_y(uint64_t key)
+{
+    return (int)(int32_t)(uint32_t)key;
+}
+
+static inline uint32_t gm_spatial_slot(uint64_t key, int bits)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+static inline int gm_spatial_cell_coord(const gm_spatial_t *sh, float v)
+{
+    float c = SDL_floorf(v * sh->inv_cell_size);
+    return (c == c) ? (int)SDL_clamp(c, -GM_SPATIAL_MAX_COORD, GM_SPATIAL_MAX_COORD) : 0;
+}
+
+static gm_spatial_cell_t *gm_spatial_find(const gm_spatial_t *sh, int cx, int cy)
+{
+    uint64_t key = gm_spatial_key(cx, cy);
+    uint32_t mask = (1u << sh->cell_bits) - 1;
+    for (uint32_t i = gm_spatial_slot(key, sh->cell_bits);; i = (i + 1) & mask)
+    {
+        gm_spatial_cell_t *cell = &sh->cells[i];
+        if (!cell->used)
+        {
+            return NULL;
+        }
+        if (cell->key == key)
+        {
+            return cell;
+        }
+    }
+}
+
+static void gm_spatial_cells_free(gm_spatial_cell_t *cells, int bits)
+{
+    if (cells)
+    {
+        for (int i = 0; i < (1 << bits); i++)
+        {
+            free(cells[i].items);
+        }
+        free(cells);
+    }
+}
+
+// Rebuilds the table, dropping empty cells, twice as large if it is still 3/4 full.
+static bool gm_spatial_rehash(gm_spatial_t *sh)
+{
+    int live = 0;
+    for (int i = 0; i < (1 << sh->cell_bits); i++)
+    {
+        live += sh->cells[i].used && sh->cells[i].count > 0;
+    }
+
+    int bits = sh->cell_bits;
+    while ((live + 1) * 4 > (1 << bits) * 3 / 2 && bits < GM_SPATIAL_MAX_CELL_BITS)
+    {
+        bits++;
+    }
+
+    gm_spatial_cell_t *cells = (gm_spatial_cell_t *)calloc(sizeof(gm_spatial_cell_t), (size_t)1 << bits);
+    if (cells == NULL)
+    {
+        return false;
+    }
+
+    uint32_t mask = (1u << bits) - 1;
+    for (int i = 0; i < (1 << sh->cell_bits); i++)
+    {
+        gm_spatial_cell_t *old = &sh->cells[i];
+        if (!old->used || old->count == 0)
+        {
+            free(old->items);
+            continue;
+        }
+        uint32_t j = gm_spatial_slot(old->key, bits);
+        while (cells[j].used)
+        {
+            j = (j + 1) & mask;
+        }
+        cells[j] = *old;
+    }
+    free(sh->cells);
+    sh->cells = cells;
+    sh->cell_bits = bits;
+    sh->cells_used = live;
+    return true;
+}
+
+static gm_spatial_cell_t *gm_spatial_find_or_add(gm_spatial_t *sh, int cx, int cy)
+{
+    if ((sh->cells_used + 1) * 4 > (1 << sh->cell_bits) * 3 && !gm_spatial_rehash(sh))
+    {
+        return NULL;
+    }
+
+    uint64_t key = gm_spatial_key(cx, cy);
+    uint32_t mask = (1u << sh->cell_bits) - 1;
+    uint32_t i = gm_spatial_slot(key, sh->cell_bits);
+    while (sh->cells[i].used)
+    {
+        if (sh->cells[i].key == key)
+        {
+            return &sh->cells[i];
+        }
+        i = (i + 1) & mask;
+    }
+    sh->cells[i].used = true;
+    sh->cells[i].key = key;
+    sh->cells_used++;
+    return &sh->cells[i];
+}
+
+//----------------------------------------------------------------------------
+// Items
+//----------------------------------------------------------------------------
+
+static void gm_spatial_unlink(gm_spatial_t *sh, int handle)
+{
+    const gm_spatial_item_t *item = &sh->items[handle - 1];
+    for (int cy = item->cy0; cy <= item->cy1; cy++)
+    {
+        for (int cx = item->cx0; cx <= item->cx1; cx++)
+        {
+            gm_spatial_cell_t *cell = gm_spatial_find(sh, cx, cy);
+            for (int i = 0; cell && i < cell->count; i++)
+            {
+                if (cell->items[i] == handle)
+                {
+                    cell->items[i] = cell->items[--cell->count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static bool gm_spatial_link(gm_spatial_t *sh, int handle)
+{
+    const gm_spatial_item_t *item = &sh->items[handle - 1];
+    for (int cy = item->cy0; cy <= item->cy1; cy++)
+    {
+        for (int cx = item->cx0; cx <= item->cx1; cx++)
+        {
+            gm_spatial_cell_t *cell = gm_spatial_find_or_add(sh, cx, cy);
+            if (cell == NULL)
+            {
+                return false;
+            }
+            if (cell->count == cell->capacity)
+            {
+                int capacity = cell->capacity ? cell->capacity * 2 : 4;
+                int *items = (int *)realloc(cell->items, sizeof(int) * (size_t)capacity);
+                if (items == NULL)
+                {
+                    return false;
+                }
+                cell->items = items;
+                cell->capacity = capacity;
+            }
+            cell->items[cell->count++] = handle;
+        }
+    }
+    return true;
+}
+
+// Sets the box and its cell range, raises an error if it covers too many cells.
+// size_arg is the stack index of w, h follows it.
+static void gm_spatial_set_box(lua_State *L, gm_spatial_t *sh, gm_spatial_item_t *item, float x, float y, float w,
+                               float h, int size_arg)
+{
+    luaL_argcheck(L, w >= 0.0f, size_arg, "negative width");
+    luaL_argcheck(L, h >= 0.0f, size_arg + 1, "negative height");
+    int cx0 = gm_spatial_cell_coord(sh, x);
+    int cy0 = gm_spatial_cell_coord(sh, y);
+    int cx1 = gm_spatial_cell_coord(sh, x + w);
+    int cy1 = gm_spatial_cell_coord(sh, y + h);
+    if (((int64_t)cx1 - cx0 + 1) * ((int64_t)cy1 - cy0 + 1) > GM_SPATIAL_MAX_ITEM_CELLS)
+    {
+        luaL_error(L, "box covers more than %d cells, use a larger cell size", GM_SPATIAL_MAX_ITEM_CELLS);
+    }
+    item->x0 = x;
+    item->y0 = y;
+    item->x1 = x + w;
+    item->y1 = y + h;
+    item->cx0 = cx0;
+    item->cy0 = cy0;
+    item->cx1 = cx1;
+    item->cy1 = cy1;
+}
+
+// Starts a query, items are reported once per stamp.
+static uint32_t gm_spatial_next_stamp(gm_spatial_t *sh)
+{
+    if (++sh->stamp == 0)
+    {
+        for (int i = 0; i < sh->item_capacity; i++)
+        {
+            sh->items[i].stamp = 0;
+        }
+        sh->stamp = 1;
+    }
+    return sh->stamp;
+}
+
+//----------------------------------------------------------------------------
+// Result arrays
+//----------------------------------------------------------------------------
+
+// Results go into a Lua table or an i32 gm.array given by the caller, reused from call to call.
+typedef struct
+{
+    lua_State *L;
+    int idx;
+    gm_array_t *arr;
+    int n;
+} gm_spatial_out_t;
+
+static void gm_spatial_out_begin(lua_State *L, int idx, gm_spatial_out_t *out)
+{
+    out->L = L;
+    out->n = 0;
+    out->arr = NULL;
+    lua_settop(L, idx);
+    if (lua_isnil(L, idx))
+    {
+        lua_newtable(L);
+        lua_replace(L, idx);
+    }
+    else if (lua_type(L, idx) != LUA_TTABLE)
+    {
+        out->arr = gm_array_check(L, idx);
+        luaL_argcheck(L, out->arr->type == GM_ARRAY_I32, idx, "result array must be i32");
+    }
+    out->idx = lua_absindex(L, idx);
+}
+
+static inline void gm_spatial_out_push(gm_spatial_out_t *out, int value)
+{
+    if (out->arr)
+    {
+        if ((size_t)out->n < out->arr->count)
+        {
+            ((int32_t *)out->arr->data)[out->n] = value;
+        }
+        out->n++;
+        return;
+    }
+    lua_pushinteger(out->L, value);
+    lua_rawseti(out->L, out->idx, ++out->n);
+}
+
+// Clears what is left of the previous results and returns the results table or array and the count.
+// An array only holds what fits, the count tells how large it needs to be.
+static int gm_spatial_out_end(gm_spatial_out_t *out, int count)
+{
+    lua_State *L = out->L;
+    if (out->arr == NULL)
+    {
+        for (int i = out->n + 1;; i++)
+        {
+            if (lua_rawgeti(L, out->idx, i) == LUA_TNIL)
+            {
+                lua_pop(L, 1);
+                break;
+            }
+            lua_pop(L, 1);
+            lua_pushnil(L);
+            lua_rawseti(L, out->idx, i);
+        }
+    }
+    lua_pushvalue(L, out->idx);
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_spatial_t *gm_spatial_check(lua_State *L, int idx)
+{
+    return (gm_spatial_t *)luaL_checkudata(L, idx, GM_SPATIAL_MT);
+}
+
+static int gm_spatial_check_handle(lua_State *L, const gm_spatial_t *sh, int idx)
+{
+    lua_Integer h = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, h >= 1 && h <= sh->item_capacity && sh->items[h - 1].live, idx, "no such item");
+    return (int)h;
+}
+
+// gm.newSpatialHash(cellSize), cells a bit larger than the typical box work best
+static int gm_spatial_lua_new(lua_State *L)
+{
+    lua_Number cell_size = luaL_checknumber(L, 1);
+    luaL_argcheck(L, cell_size > 0, 1, "cell size must be positive");
+
+    gm_spatial_t *sh = (gm_spatial_t *)lua_newuserdatauv(L, sizeof(gm_spatial_t), 0);
+    memset(sh, 0, sizeof(gm_spatial_t));
+    luaL_setmetatable(L, GM_SPATIAL_MT);
+
+    sh->cell_size = (float)cell_size;
+    sh->inv_cell_size = 1.0f / sh->cell_size;
+    sh->cell_bits = GM_SPATIAL_MIN_CELL_BITS;
+    sh->first_free = -1;
+    sh->cells = (gm_spatial_cell_t *)calloc(sizeof(gm_spatial_cell_t), (size_t)1 << sh->cell_bits);
+    if (sh->cells == NULL)
+    {
+        return luaL_error(L, "could not allocate a spatial hash");
+    }
+    return 1;
+}
+
+static int gm_spatial_lua_gc(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    gm_spatial_cells_free(sh->cells, sh->cell_bits);
+    free(sh->items);
+    sh->cells = NULL;
+    sh->items = NULL;
+    return 0;
+}
+
+// sh:insert(x, y, w, h) returns the item's handle, a positive integer
+static int gm_spatial_lua_insert(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_optnumber(L, 4, 0);
+    float h = (float)luaL_optnumber(L, 5, 0);
+
+    gm_spatial_item_t box;
+    gm_spatial_set_box(L, sh, &box, x, y, w, h, 4);
+
+    if (sh->first_free < 0)
+    {
+        int capacity = sh->item_capacity ? sh->item_capacity * 2 : 64;
+        gm_spatial_item_t *items =
+            (gm_spatial_item_t *)realloc(sh->items, sizeof(gm_spatial_item_t) * (size_t)capacity);
+        if (items == NULL)
+        {
+            return luaL_error(L, "out of memory");
+        }
+        for (int i = capacity - 1; i >= sh->item_capacity; i--)
+        {
+            items[i].live = false;
+            items[i].stamp = 0;
+            items[i].next_free = sh->first_free;
+            sh->first_free = i;
+        }
+        sh->items = items;
+        sh->item_capacity = capacity;
+    }
+
+    int handle = sh->first_free + 1;
+    gm_spatial_item_t *item = &sh->items[handle - 1];
+    sh->first_free = item->next_free;
+    box.stamp = item->stamp;
+    box.live = true;
+    box.next_free = -1;
+    *item = box;
+    sh->item_count++;
+
+    if (!gm_spatial_link(sh, handle))
+    {
+        return luaL_error(L, "out of memory");
+    }
+    lua_pushinteger(L, handle);
+    return 1;
+}
+
+// sh:remove(handle)
+static int gm_spatial_lua_remove(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    int handle = gm_spatial_check_handle(L, sh, 2);
+    gm_spatial_unlink(sh, handle);
+
+    gm_spatial_item_t *item = &sh->items[handle - 1];
+    item->live = false;
+    item->next_free = sh->first_free;
+    sh->first_free = handle - 1;
+    sh->item_count--;
+    return 0;
+}
+
+// sh:move(handle, x, y [, w, h]), only touches the cells if the box changed cells
+static int gm_spatial_lua_move(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    int handle = gm_spatial_check_handle(L, sh, 2);
+    gm_spatial_item_t *item = &sh->items[handle - 1];
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+    float w = (float)luaL_optnumber(L, 5, item->x1 - item->x0);
+    float h = (float)luaL_optnumber(L, 6, item->y1 - item->y0);
+
+    gm_spatial_item_t box = *item;
+    gm_spatial_set_box(L, sh, &box, x, y, w, h, 5);
+    if (box.cx0 == item->cx0 && box.cy0 == item->cy0 && box.cx1 == item->cx1 && box.cy1 == item->cy1)
+    {
+        *item = box;
+        return 0;
+    }
+
+    gm_spatial_unlink(sh, handle);
+    *item = box;
+    if (!gm_spatial_link(sh, handle))
+    {
+        return luaL_error(L, "out of memory");
+    }
+    return 0;
+}
+
+// sh:get(handle) returns x, y, w, h
+static int gm_spatial_lua_get(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    const gm_spatial_item_t *item = &sh->items[gm_spatial_check_handle(L, sh, 2) - 1];
+    lua_pushnumber(L, item->x0);
+    lua_pushnumber(L, item->y0);
+    lua_pushnumber(L, item->x1 - item->x0);
+    lua_pushnumber(L, item->y1 - item->y0);
+    return 4;
+}
+
+static int gm_spatial_lua_count(lua_State *L)
+{
+    lua_pushinteger(L, gm_spatial_check(L, 1)->item_count);
+    return 1;
+}
+
+// sh:clear() removes every item, handles start over from 1
+static int gm_spatial_lua_clear(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    for (int i = 0; i < (1 << sh->cell_bits); i++)
+    {
+        sh->cells[i].count = 0;
+    }
+    gm_spatial_rehash(sh);
+    sh->first_free = -1;
+    for (int i = sh->item_capacity - 1; i >= 0; i--)
+    {
+        sh->items[i].live = false;
+        sh->items[i].next_free = sh->first_free;
+        sh->first_free = i;
+    }
+    sh->item_count = 0;
+    return 0;
+}
+
+// Calls VISIT(item handle) once for each item in a cell overlapping the cell range.
+// A range larger than the table walks the table instead of the empty cells.
+#define GM_SPATIAL_VISIT_RANGE(sh, cx0, cy0, cx1, cy1, VISIT)                                       \
+    do                                                                                              \
+    {                                                                                               \
+        uint32_t stamp_ = gm_spatial_next_stamp(sh);                                                \
+        int64_t area_ = ((int64_t)(cx1) - (cx0) + 1) * ((int64_t)(cy1) - (cy0) + 1);                \
+        int ncells_ = (area_ > (sh)->cells_used) ? (1 << (sh)->cell_bits) : (int)area_;             \
+        for (int c_ = 0; c_ < ncells_; c_++)                                                        \
+        {                                                                                           \
+            gm_spatial_cell_t *cell_;                                                               \
+            if (area_ > (sh)->cells_used)                                                           \
+            {                                                                                       \
+                cell_ = &(sh)->cells[c_];                                                           \
+                if (!cell_->used || cell_->count == 0)                                              \
+                {                                                                                   \
+                    continue;                                                                       \
+                }                                                                                   \
+                int kx_ = gm_spatial_key_x(cell_->key), ky_ = gm_spatial_key_y(cell_->key);         \
+                if (kx_ < (cx0) || kx_ > (cx1) || ky_ < (cy0) || ky_ > (cy1))                       \
+                {                                                                                   \
+                    continue;                                                                       \
+                }                                                                                   \
+            }                                                                                       \
+            else                                                                                    \
+            {                                                                                       \
+                int w_ = (cx1) - (cx0) + 1;                                                         \
+                cell_ = gm_spatial_find(sh, (cx0) + c_ % w_, (cy0) + c_ / w_);                      \
+                if (cell_ == NULL)                                                                  \
+                {                                                                                   \
+                    continue;                                                                       \
+                }                                                                                   \
+            }                                                                                       \
+            for (int i_ = 0; i_ < cell_->count; i_++)                                               \
+            {                                                                                       \
+                int handle_ = cell_->items[i_];                                                     \
+                gm_spatial_item_t *item_ = &(sh)->items[handle_ - 1];                               \
+                if (item_->stamp != stamp_)                                                         \
+                {                                                                                   \
+                    item_->stamp = stamp_;                                                          \
+                    VISIT(handle_, item_);                                                          \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+    } while (0)
+
+// sh:queryRect(x, y, w, h [, out]) returns out and the number of items overlapping the box
+static int gm_spatial_lua_query_rect(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    float x0 = (float)luaL_checknumber(L, 2);
+    float y0 = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_checknumber(L, 4);
+    float h = (float)luaL_checknumber(L, 5);
+    luaL_argcheck(L, w >= 0.0f, 4, "negative width");
+    luaL_argcheck(L, h >= 0.0f, 5, "negative height");
+    float x1 = x0 + w;
+    float y1 = y0 + h;
+    gm_spatial_out_t out;
+    gm_spatial_out_begin(L, 6, &out);
+
+    int cx0 = gm_spatial_cell_coord(sh, x0), cy0 = gm_spatial_cell_coord(sh, y0);
+    int cx1 = gm_spatial_cell_coord(sh, x1), cy1 = gm_spatial_cell_coord(sh, y1);
+
+#define GM_SPATIAL_RECT_HIT(handle, item)                                                \
+    if ((item)->x0 <= x1 && x0 <= (item)->x1 && (item)->y0 <= y1 && y0 <= (item)->y1)    \
+    {                                                                                    \
+        gm_spatial_out_push(&out, handle);                                               \
+    }
+    GM_SPATIAL_VISIT_RANGE(sh, cx0, cy0, cx1, cy1, GM_SPATIAL_RECT_HIT);
+#undef GM_SPATIAL_RECT_HIT
+
+    return gm_spatial_out_end(&out, out.n);
+}
+
+// sh:queryRadius(x, y, r [, out]) returns out and the number of items whose box is within r of x, y
+static int gm_spatial_lua_query_radius(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float r = (float)luaL_checknumber(L, 4);
+    luaL_argcheck(L, r >= 0.0f, 4, "negative radius");
+    gm_spatial_out_t out;
+    gm_spatial_out_begin(L, 5, &out);
+
+    int cx0 = gm_spatial_cell_coord(sh, x - r), cy0 = gm_spatial_cell_coord(sh, y - r);
+    int cx1 = gm_spatial_cell_coord(sh, x + r), cy1 = gm_spatial_cell_coord(sh, y + r);
+    float r2 = r * r;
+
+    // distance from the centre to the closest point of the box
+#define GM_SPATIAL_RADIUS_HIT(handle, item)                         \
+    {                                                               \
+        float dx = x - SDL_clamp(x, (item)->x0, (item)->x1);        \
+        float dy = y - SDL_clamp(y, (item)->y0, (item)->y1);        \
+        if (dx * dx + dy * dy <= r2)                                \
+        {                                                           \
+            gm_spatial_out_push(&out, handle);                      \
+        }                                                           \
+    }
+    GM_SPATIAL_VISIT_RANGE(sh, cx0, cy0, cx1, cy1, GM_SPATIAL_RADIUS_HIT);
+#undef GM_SPATIAL_RADIUS_HIT
+
+    return gm_spatial_out_end(&out, out.n);
+}
+
+// sh:overlaps([out]) returns out holding a1, b1, a2, b2, ... and the number of pairs
+// of overlapping items. A pair sharing several cells is reported by the first one only.
+static int gm_spatial_lua_overlaps(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    gm_spatial_out_t out;
+    gm_spatial_out_begin(L, 2, &out);
+
+    int pairs = 0;
+    for (int c = 0; c < (1 << sh->cell_bits); c++)
+    {
+        const gm_spatial_cell_t *cell = &sh->cells[c];
+        if (!cell->used || cell->count < 2)
+        {
+            continue;
+        }
+        int kx = gm_spatial_key_x(cell->key), ky = gm_spatial_key_y(cell->key);
+        for (int i = 0; i < cell->count; i++)
+        {
+            const gm_spatial_item_t *a = &sh->items[cell->items[i] - 1];
+            for (int j = i + 1; j < cell->count; j++)
+            {
+                const gm_spatial_item_t *b = &sh->items[cell->items[j] - 1];
+                if (a->x0 > b->x1 || b->x0 > a->x1 || a->y0 > b->y1 || b->y0 > a->y1)
+                {
+                    continue;
+                }
+                // the first cell both boxes are in
+                if (SDL_max(a->cx0, b->cx0) != kx || SDL_max(a->cy0, b->cy0) != ky)
+                {
+                    continue;
+                }
+                gm_spatial_out_push(&out, cell->items[i]);
+                gm_spatial_out_push(&out, cell->items[j]);
+                pairs++;
+            }
+        }
+    }
+    return gm_spatial_out_end(&out, pairs);
+}
+
+// sh:stats() returns the number of items, of cells in use and of table slots
+static int gm_spatial_lua_stats(lua_State *L)
+{
+    gm_spatial_t *sh = gm_spatial_check(L, 1);
+    lua_pushinteger(L, sh->item_count);
+    lua_pushinteger(L, sh->cells_used);
+    lua_pushinteger(L, 1 << sh->cell_bits);
+    return 3;
+}
+
+void gm_spatial_register_lua(lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"insert", gm_spatial_lua_insert},
+        {"remove", gm_spatial_lua_remove},
+        {"move", gm_spatial_lua_move},
+        {"get", gm_spatial_lua_get},
+        {"count", gm_spatial_lua_count},
+        {"clear", gm_spatial_lua_clear},
+        {"queryRect", gm_spatial_lua_query_rect},
+        {"queryRadius", gm_spatial_lua_query_radius},
+        {"overlaps", gm_spatial_lua_overlaps},
+        {"stats", gm_spatial_lua_stats},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"newSpatialHash", gm_spatial_lua_new},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_SPATIAL_MT);
+    lua_pushcfunction(L, gm_spatial_lua_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    luaL_setfuncs(L, funcs, 0);
+    lua_pop(L, 1);
+}
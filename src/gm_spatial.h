@@ -0,0 +1,59 @@
+#ifndef __GM_SPATIAL_H__
+#define __GM_SPATIAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <lua.h>
+
+#define GM_SPATIAL_MT "gm.spatialhash"
+
+// an item may not cover more cells than this, it needs a larger cell size
+#define GM_SPATIAL_MAX_ITEM_CELLS 4096
+
+// A box in the hash, in the cells cx0..cx1 x cy0..cy1
+typedef struct
+{
+    float x0, y0, x1, y1;
+    int cx0, cy0, cx1, cy1;
+
+    // last query that reported it, so items spanning cells are reported once
+    uint32_t stamp;
+    bool live;
+    int next_free;
+} gm_spatial_item_t;
+
+// One grid cell, holding the handles of the items touching it.
+// Emptied cells stay until the table is rebuilt.
+typedef struct
+{
+    uint64_t key;
+    int *items;
+    int count;
+    int capacity;
+    bool used;
+} gm_spatial_cell_t;
+
+// Lua userdata behind gm.newSpatialHash: a sparse uniform grid.
+typedef struct
+{
+    float cell_size;
+    float inv_cell_size;
+
+    // open addressing, power of two sized
+    gm_spatial_cell_t *cells;
+    int cell_bits;
+    int cells_used;
+
+    // handle h is items[h - 1]
+    gm_spatial_item_t *items;
+    int item_capacity;
+    int item_count;
+    int first_free;
+
+    uint32_t stamp;
+} gm_spatial_t;
+
+// Adds gm.newSpatialHash to the game API.
+void gm_spatial_register_lua(lua_State *L);
+
+#endif // __GM_SPATIAL_H__
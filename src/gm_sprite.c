@@ -0,0 +1,374 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_sprite.h"
+#include "gm_lua.h"
+
+int gm_sprite_init(gm_sprite_t **sprite, SDL_Renderer *renderer, const gm_pack_t *pack)
+{
+    (*sprite) = (gm_sprite_t *)calloc(sizeof(gm_sprite_t), 1);
+    if ((*sprite) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_sprite_t.\n");
+        return 1;
+    }
+
+    (*sprite)->renderer = renderer;
+    (*sprite)->pack = pack;
+    return 0;
+}
+
+void gm_sprite_shutdown(gm_sprite_t *sprite)
+{
+    if (sprite)
+    {
+        free(sprite);
+    }
+}
+
+SDL_Surface *gm_sprite_load_surface(const gm_pack_t *pack, const char *path)
+{
+    SDL_IOStream *io = gm_pack_open_io(pack, path);
+    if (io == NULL)
+    {
+        io = SDL_IOFromFile(path, "rb");
+    }
+    if (io == NULL)
+    {
+        SDL_Log("Could not open image %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    const char *ext = SDL_strrchr(path, '.');
+    SDL_Surface *surface = (ext && SDL_strcasecmp(ext, ".bmp") == 0) ? SDL_LoadBMP_IO(io, true) : SDL_LoadPNG_IO(io, true);
+    if (surface == NULL)
+    {
+        SDL_Log("Could not load image %s: %s\n", path, SDL_GetError());
+    }
+    return surface;
+}
+
+SDL_Texture *gm_sprite_create_texture(SDL_Renderer *renderer, SDL_Surface *surface, const char *path)
+{
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture == NULL)
+    {
+        SDL_Log("Could not create texture for %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    // pixel art stays sharp when scaled
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+SDL_Texture *gm_sprite_load_texture(gm_sprite_t *sprite, const char *path, int *w, int *h)
+{
+    SDL_Surface *surface = gm_sprite_load_surface(sprite->pack, path);
+    if (surface == NULL)
+    {
+        return NULL;
+    }
+
+    SDL_Texture *texture = gm_sprite_create_texture(sprite->renderer, surface, path);
+    *w = surface->w;
+    *h = surface->h;
+    SDL_DestroySurface(surface);
+    return texture;
+}
+
+//----------------------------------------------------------------------------
+// Images
+//----------------------------------------------------------------------------
+
+static gm_sprite_t *gm_sprite_upvalue(lua_State *L)
+{
+    return (gm_sprite_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static gm_image_t *gm_sprite_check_image(lua_State *L, int idx)
+{
+    gm_image_t *img = (gm_image_t *)luaL_checkudata(L, idx, GM_IMAGE_MT);
+    luaL_argcheck(L, img->texture != NULL, idx, "image has been released");
+    return img;
+}
+
+gm_image_t *gm_sprite_push_image(lua_State *L)
+{
+    gm_image_t *img = (gm_image_t *)lua_newuserdatauv(L, sizeof(gm_image_t), 0);
+    img->texture = NULL;
+    img->w = 0;
+    img->h = 0;
+    luaL_setmetatable(L, GM_IMAGE_MT);
+    return img;
+}
+
+// gm.loadImage(path)
+static int gm_sprite_lua_load_image(lua_State *L)
+{
+    gm_sprite_t *sprite = gm_sprite_upvalue(L);
+    const char *path = luaL_checkstring(L, 1);
+
+    gm_image_t *img = gm_sprite_push_image(L);
+    img->texture = gm_sprite_load_texture(sprite, path, &img->w, &img->h);
+    if (img->texture == NULL)
+    {
+        return luaL_error(L, "could not load image %s", path);
+    }
+    return 1;
+}
+
+static int gm_sprite_lua_image_gc(lua_State *L)
+{
+    gm_image_t *img = (gm_image_t *)luaL_checkudata(L, 1, GM_IMAGE_MT);
+    if (img->texture)
+    {
+        SDL_DestroyTexture(img->texture);
+        img->texture = NULL;
+    }
+    return 0;
+}
+
+static int gm_sprite_lua_image_width(lua_State *L)
+{
+    lua_pushinteger(L, gm_sprite_check_image(L, 1)->w);
+    return 1;
+}
+
+static int gm_sprite_lua_image_height(lua_State *L)
+{
+    lua_pushinteger(L, gm_sprite_check_image(L, 1)->h);
+    return 1;
+}
+
+// gm:drawImage(img, x, y [, sx, sy, sw, sh])
+static int gm_sprite_lua_draw_image(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_sprite_t *sprite = gm_sprite_upvalue(L);
+    gm_image_t *img = gm_sprite_check_image(L, 2);
+
+    SDL_FRect src = {0.0f, 0.0f, (float)img->w, (float)img->h};
+    if (lua_gettop(L) >= 8)
+    {
+        src.x = (float)luaL_checknumber(L, 5);
+        src.y = (float)luaL_checknumber(L, 6);
+        src.w = (float)luaL_checknumber(L, 7);
+        src.h = (float)luaL_checknumber(L, 8);
+    }
+    SDL_FRect dst = {
+        .x = (float)luaL_checknumber(L, 3),
+        .y = (float)luaL_checknumber(L, 4),
+        .w = src.w,
+        .h = src.h};
+    SDL_RenderTexture(sprite->renderer, img->texture, &src, &dst);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Sprite batches
+//----------------------------------------------------------------------------
+
+static gm_sprite_batch_t *gm_sprite_check_batch(lua_State *L, int idx)
+{
+    return (gm_sprite_batch_t *)luaL_checkudata(L, idx, GM_SPRITE_BATCH_MT);
+}
+
+// gm.newSpriteBatch(image, capacity [, frameW [, frameH]])
+static int gm_sprite_lua_new_batch(lua_State *L)
+{
+    gm_image_t *img = gm_sprite_check_image(L, 1);
+    lua_Integer capacity = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, capacity > 0 && capacity <= GM_SPRITE_BATCH_MAX, 2, "capacity out of range");
+    lua_Integer fw = luaL_optinteger(L, 3, img->w);
+    lua_Integer fh = luaL_optinteger(L, 4, fw == img->w ? img->h : fw);
+    luaL_argcheck(L, fw > 0 && fw <= img->w, 3, "frame width out of range");
+    luaL_argcheck(L, fh > 0 && fh <= img->h, 4, "frame height out of range");
+
+    gm_sprite_batch_t *batch = (gm_sprite_batch_t *)lua_newuserdatauv(L, sizeof(gm_sprite_batch_t), 1);
+    memset(batch, 0, sizeof(gm_sprite_batch_t));
+    luaL_setmetatable(L, GM_SPRITE_BATCH_MT);
+
+    batch->capacity = (int)capacity;
+    batch->frame_w = (int)fw;
+    batch->frame_h = (int)fh;
+    batch->columns = img->w / batch->frame_w;
+    batch->frames = batch->columns * (img->h / batch->frame_h);
+    batch->inv_w = 1.0f / (float)img->w;
+    batch->inv_h = 1.0f / (float)img->h;
+    batch->color.r = batch->color.g = batch->color.b = batch->color.a = 1.0f;
+
+    batch->vertices = (SDL_Vertex *)malloc(sizeof(SDL_Vertex) * 4 * (size_t)capacity);
+    batch->indices = (int *)malloc(sizeof(int) * 6 * (size_t)capacity);
+    if (batch->vertices == NULL || batch->indices == NULL)
+    {
+        return luaL_error(L, "out of memory for a batch of %d sprites", (int)capacity);
+    }
+
+    // the index pattern never changes, so it is written once
+    for (int i = 0; i < batch->capacity; i++)
+    {
+        int *idx = &batch->indices[6 * i];
+        int v = 4 * i;
+        idx[0] = v;
+        idx[1] = v + 1;
+        idx[2] = v + 2;
+        idx[3] = v;
+        idx[4] = v + 2;
+        idx[5] = v + 3;
+    }
+
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
+}
+
+static int gm_sprite_lua_batch_gc(lua_State *L)
+{
+    gm_sprite_batch_t *batch = gm_sprite_check_batch(L, 1);
+    free(batch->vertices);
+    free(batch->indices);
+    batch->vertices = NULL;
+    batch->indices = NULL;
+    batch->capacity = 0;
+    batch->count = 0;
+    return 0;
+}
+
+// batch:add(frame, x, y [, scaleX [, scaleY]]), negative scales flip the sprite
+static int gm_sprite_lua_batch_add(lua_State *L)
+{
+    gm_sprite_batch_t *batch = gm_sprite_check_batch(L, 1);
+    lua_Integer frame = luaL_checkinteger(L, 2);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+    float sx = (float)luaL_optnumber(L, 5, 1.0);
+    float sy = (float)luaL_optnumber(L, 6, sx);
+
+    luaL_argcheck(L, frame >= 1 && frame <= batch->frames, 2, "invalid frame");
+    if (batch->count >= batch->capacity)
+    {
+        return luaL_error(L, "sprite batch is full (%d sprites)", batch->capacity);
+    }
+
+    int f = (int)frame - 1;
+    float u0 = (float)((f % batch->columns) * batch->frame_w) * batch->inv_w;
+    float v0 = (float)((f / batch->columns) * batch->frame_h) * batch->inv_h;
+    float u1 = u0 + (float)batch->frame_w * batch->inv_w;
+    float v1 = v0 + (float)batch->frame_h * batch->inv_h;
+    float x1 = x + (float)batch->frame_w * sx;
+    float y1 = y + (float)batch->frame_h * sy;
+
+    SDL_Vertex *v = &batch->vertices[4 * batch->count];
+    v[0].position.x = x;
+    v[0].position.y = y;
+    v[0].tex_coord.x = u0;
+    v[0].tex_coord.y = v0;
+    v[1].position.x = x1;
+    v[1].position.y = y;
+    v[1].tex_coord.x = u1;
+    v[1].tex_coord.y = v0;
+    v[2].position.x = x1;
+    v[2].position.y = y1;
+    v[2].tex_coord.x = u1;
+    v[2].tex_coord.y = v1;
+    v[3].position.x = x;
+    v[3].position.y = y1;
+    v[3].tex_coord.x = u0;
+    v[3].tex_coord.y = v1;
+    v[0].color = v[1].color = v[2].color = v[3].color = batch->color;
+
+    batch->count++;
+    return 0;
+}
+
+// batch:setColor(r, g, b [, a]) tints the sprites added after it
+static int gm_sprite_lua_batch_set_color(lua_State *L)
+{
+    gm_sprite_batch_t *batch = gm_sprite_check_batch(L, 1);
+    float c[4];
+    for (int i = 0; i < 4; i++)
+    {
+        lua_Integer v = (i < 3) ? luaL_checkinteger(L, 2 + i) : luaL_optinteger(L, 5, 255);
+        c[i] = (float)SDL_clamp(v, 0, 255) / 255.0f;
+    }
+    batch->color.r = c[0];
+    batch->color.g = c[1];
+    batch->color.b = c[2];
+    batch->color.a = c[3];
+    return 0;
+}
+
+static int gm_sprite_lua_batch_clear(lua_State *L)
+{
+    gm_sprite_check_batch(L, 1)->count = 0;
+    return 0;
+}
+
+static int gm_sprite_lua_batch_count(lua_State *L)
+{
+    lua_pushinteger(L, gm_sprite_check_batch(L, 1)->count);
+    return 1;
+}
+
+// gm:drawBatch(batch), one SDL_RenderGeometry call for the whole batch
+static int gm_sprite_lua_draw_batch(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_sprite_t *sprite = gm_sprite_upvalue(L);
+    gm_sprite_batch_t *batch = gm_sprite_check_batch(L, 2);
+    if (batch->count == 0)
+    {
+        return 0;
+    }
+
+    lua_getiuservalue(L, 2, 1);
+    gm_image_t *img = gm_sprite_check_image(L, -1);
+    SDL_RenderGeometry(sprite->renderer, img->texture,
+                       batch->vertices, 4 * batch->count,
+                       batch->indices, 6 * batch->count);
+    lua_pop(L, 1);
+    return 0;
+}
+
+void gm_sprite_register_lua(gm_sprite_t *sprite, lua_State *L)
+{
+    static const luaL_Reg image_methods[] = {
+        {"width", gm_sprite_lua_image_width},
+        {"height", gm_sprite_lua_image_height},
+        {NULL, NULL}};
+    static const luaL_Reg batch_methods[] = {
+        {"add", gm_sprite_lua_batch_add},
+        {"setColor", gm_sprite_lua_batch_set_color},
+        {"clear", gm_sprite_lua_batch_clear},
+        {"count", gm_sprite_lua_batch_count},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"loadImage", gm_sprite_lua_load_image},
+        {"drawImage", gm_sprite_lua_draw_image},
+        {"newSpriteBatch", gm_sprite_lua_new_batch},
+        {"drawBatch", gm_sprite_lua_draw_batch},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_IMAGE_MT);
+    lua_pushcfunction(L, gm_sprite_lua_image_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, image_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, GM_SPRITE_BATCH_MT);
+    lua_pushcfunction(L, gm_sprite_lua_batch_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, batch_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, sprite);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
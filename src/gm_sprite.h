@@ -0,0 +1,71 @@
+#ifndef __GM_SPRITE_H__
+#define __GM_SPRITE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_pack.h"
+
+#define GM_IMAGE_MT "gm.image"
+#define GM_SPRITE_BATCH_MT "gm.spritebatch"
+
+// upper bound for one batch, 4 vertices and 6 indices per sprite
+#define GM_SPRITE_BATCH_MAX 65536
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+    const gm_pack_t *pack;
+} gm_sprite_t;
+
+// Lua userdata behind gm.loadImage, the texture is destroyed when it is collected.
+typedef struct
+{
+    SDL_Texture *texture;
+    int w;
+    int h;
+} gm_image_t;
+
+// Lua userdata behind gm.newSpriteBatch. Its image is kept alive in user value 1.
+// Vertices and indices are allocated once, at creation.
+typedef struct
+{
+    int capacity;
+    int count;
+
+    // the atlas is a grid of frame_w x frame_h frames, numbered from 1, row by row
+    int frame_w;
+    int frame_h;
+    int columns;
+    int frames;
+    float inv_w;
+    float inv_h;
+
+    // tint applied to the sprites added next
+    SDL_FColor color;
+
+    SDL_Vertex *vertices;
+    int *indices;
+} gm_sprite_batch_t;
+
+int gm_sprite_init(gm_sprite_t **sprite, SDL_Renderer *renderer, const gm_pack_t *pack);
+void gm_sprite_shutdown(gm_sprite_t *sprite);
+
+// Decodes a PNG or BMP image from the pack or disk, NULL on failure. Safe to call from any thread.
+SDL_Surface *gm_sprite_load_surface(const gm_pack_t *pack, const char *path);
+
+// Uploads a decoded image with the settings every image gets, NULL on failure. Render thread only.
+SDL_Texture *gm_sprite_create_texture(SDL_Renderer *renderer, SDL_Surface *surface, const char *path);
+
+// Loads a PNG or BMP image from the pack or disk into a texture, NULL on failure.
+SDL_Texture *gm_sprite_load_texture(gm_sprite_t *sprite, const char *path, int *w, int *h);
+
+// Pushes a new gm.image without a texture yet, the texture is destroyed when it is collected.
+gm_image_t *gm_sprite_push_image(lua_State *L);
+
+// Adds gm.loadImage, gm.newSpriteBatch, gm:drawImage and gm:drawBatch to the game API.
+void gm_sprite_register_lua(gm_sprite_t *sprite, lua_State *L);
+
+#endif // __GM_SPRITE_H__
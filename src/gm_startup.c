@@ -0,0 +1,79 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include "gm_startup.h"
+
+typedef struct
+{
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    SDL_ThreadID thread;
+} gm_startup_phase_t;
+
+typedef struct
+{
+    uint64_t origin_ns;
+    SDL_ThreadID main_thread;
+    SDL_AtomicInt count;
+    gm_startup_phase_t phases[GM_STARTUP_MAX_PHASES];
+} gm_startup_t;
+
+static gm_startup_t gm_startup;
+
+void gm_startup_init(void)
+{
+    gm_startup.origin_ns = SDL_GetTicksNS();
+    gm_startup.main_thread = SDL_GetCurrentThreadID();
+    SDL_SetAtomicInt(&gm_startup.count, 0);
+}
+
+int gm_startup_begin(const char *name)
+{
+    // slots are claimed atomically so the Lua startup thread can record phases too
+    int phase = SDL_AddAtomicInt(&gm_startup.count, 1);
+    if (phase >= GM_STARTUP_MAX_PHASES)
+    {
+        return -1;
+    }
+    gm_startup_phase_t *p = &gm_startup.phases[phase];
+    p->name = name;
+    p->thread = SDL_GetCurrentThreadID();
+    p->end_ns = 0;
+    p->start_ns = SDL_GetTicksNS();
+    return phase;
+}
+
+void gm_startup_end(int phase)
+{
+    if (phase < 0 || phase >= GM_STARTUP_MAX_PHASES)
+    {
+        return;
+    }
+    gm_startup.phases[phase].end_ns = SDL_GetTicksNS();
+}
+
+void gm_startup_report(void)
+{
+    uint64_t now = SDL_GetTicksNS();
+    int count = SDL_GetAtomicInt(&gm_startup.count);
+    if (count > GM_STARTUP_MAX_PHASES)
+    {
+        count = GM_STARTUP_MAX_PHASES;
+    }
+
+    printf("startup profile (ms):\n");
+    printf("  %-20s %9s %9s  %s\n", "phase", "start", "duration", "thread");
+    for (int i = 0; i < count; i++)
+    {
+        const gm_startup_phase_t *p = &gm_startup.phases[i];
+        uint64_t end = p->end_ns ? p->end_ns : now;
+        printf("  %-20s %9.3f %9.3f  %s\n",
+               p->name,
+               (double)(p->start_ns - gm_startup.origin_ns) / 1e6,
+               (double)(end - p->start_ns) / 1e6,
+               p->thread == gm_startup.main_thread ? "main" : "worker");
+    }
+    printf("  time to first frame: %.3f ms\n", (double)(now - gm_startup.origin_ns) / 1e6);
+}
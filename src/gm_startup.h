@@ -0,0 +1,19 @@
+#ifndef __GM_STARTUP_H__
+#define __GM_STARTUP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GM_STARTUP_MAX_PHASES 32
+
+// Records named startup phases from any thread, relative to gm_startup_init.
+void gm_startup_init(void);
+
+// Starts a phase and returns its slot, pass it to gm_startup_end.
+int gm_startup_begin(const char *name);
+void gm_startup_end(int phase);
+
+// Prints every phase and the time to first frame, call once the first frame is presented.
+void gm_startup_report(void);
+
+#endif // __GM_STARTUP_H__
@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_task.h"
+#include "gm_lua.h"
+
+int gm_task_init(gm_task_sched_t **sched, gm_lua_t *lua_ctx, float budget_ms)
+{
+    (*sched) = (gm_task_sched_t *)calloc(sizeof(gm_task_sched_t), 1);
+    if ((*sched) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_task_sched_t.\n");
+        return 1;
+    }
+
+    (*sched)->lua_ctx = lua_ctx;
+    (*sched)->L = lua_ctx->L;
+    (*sched)->budget_ns = (uint64_t)(budget_ms * 1e6f);
+    (*sched)->next_id = 1;
+    return 0;
+}
+
+void gm_task_shutdown(gm_task_sched_t *sched)
+{
+    if (sched)
+    {
+        free(sched);
+    }
+}
+
+static void gm_task_remove(gm_task_sched_t *sched, int i)
+{
+    luaL_unref(sched->L, LUA_REGISTRYINDEX, sched->tasks[i].ref);
+
+    // keep the order, so the round robin does not skip anyone
+    memmove(&sched->tasks[i], &sched->tasks[i + 1], sizeof(gm_task_t) * (size_t)(sched->count - i - 1));
+    sched->count--;
+    if (sched->cursor > i)
+    {
+        sched->cursor--;
+    }
+}
+
+int gm_task_run(gm_task_sched_t *sched, char *err, size_t err_size)
+{
+    for (int i = sched->count - 1; i >= 0; i--)
+    {
+        if (sched->tasks[i].generation != sched->lua_ctx->generation)
+        {
+            gm_task_remove(sched, i);
+        }
+    }
+
+    int failed = 0;
+    uint64_t start = SDL_GetTicksNS();
+    while (sched->count > 0)
+    {
+        if (sched->cursor >= sched->count)
+        {
+            sched->cursor = 0;
+        }
+
+        gm_task_t *task = &sched->tasks[sched->cursor];
+        uint64_t t0 = SDL_GetTicksNS();
+        int nres = 0;
+        task->running = true;
+        int status = lua_resume(task->co, sched->L, 0, &nres);
+        uint64_t t1 = SDL_GetTicksNS();
+
+        // the task may have spawned or cancelled others, gm_task_remove keeps the cursor on it
+        task = &sched->tasks[sched->cursor];
+        task->running = false;
+
+        task->last_ns = t1 - t0;
+        task->total_ns += task->last_ns;
+        task->resumes++;
+
+        if (status == LUA_YIELD && !task->cancelled)
+        {
+            lua_pop(task->co, nres);
+            sched->cursor++;
+        }
+        else
+        {
+            if (status != LUA_OK && status != LUA_YIELD)
+            {
+                failed++;
+                const char *msg = lua_tostring(task->co, -1);
+                SDL_Log("task %d (%s) failed: %s\n", task->id, task->name, msg ? msg : "?");
+                if (err)
+                {
+                    SDL_snprintf(err, err_size, "task %s: %s", task->name, msg ? msg : "?");
+                }
+            }
+            gm_task_remove(sched, sched->cursor);
+        }
+
+        if (t1 - start >= sched->budget_ns)
+        {
+            break;
+        }
+    }
+    return failed;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_task_sched_t *gm_task_upvalue(lua_State *L)
+{
+    return (gm_task_sched_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// gm.spawnTask(fn [, name]), returns the task id. fn runs a slice at a time
+// after draw, up to each coroutine.yield().
+static int gm_task_lua_spawn(lua_State *L)
+{
+    gm_task_sched_t *sched = gm_task_upvalue(L);
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    const char *name = luaL_optstring(L, 2, NULL);
+    if (sched->count == GM_TASK_MAX)
+    {
+        return luaL_error(L, "too many tasks (%d)", GM_TASK_MAX);
+    }
+
+    gm_task_t *task = &sched->tasks[sched->count];
+    memset(task, 0, sizeof(gm_task_t));
+    task->co = lua_newthread(L);
+    lua_pushvalue(L, 1);
+    lua_xmove(L, task->co, 1);
+    task->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    task->id = sched->next_id++;
+    task->generation = sched->lua_ctx->generation;
+    if (name)
+    {
+        SDL_strlcpy(task->name, name, sizeof(task->name));
+    }
+    else
+    {
+        SDL_snprintf(task->name, sizeof(task->name), "task %d", task->id);
+    }
+    sched->count++;
+
+    lua_pushinteger(L, task->id);
+    return 1;
+}
+
+// gm.cancelTask(id), returns false if there is no such task
+static int gm_task_lua_cancel(lua_State *L)
+{
+    gm_task_sched_t *sched = gm_task_upvalue(L);
+    lua_Integer id = luaL_checkinteger(L, 1);
+    for (int i = 0; i < sched->count; i++)
+    {
+        if (sched->tasks[i].id == id)
+        {
+            // a running task is removed by gm_task_run once it yields
+            if (sched->tasks[i].running)
+            {
+                sched->tasks[i].cancelled = true;
+            }
+            else
+            {
+                gm_task_remove(sched, i);
+            }
+            lua_pushboolean(L, true);
+            return 1;
+        }
+    }
+    lua_pushboolean(L, false);
+    return 1;
+}
+
+// gm.taskBudget([ms]), returns the budget in milliseconds before the change
+static int gm_task_lua_budget(lua_State *L)
+{
+    gm_task_sched_t *sched = gm_task_upvalue(L);
+    lua_pushnumber(L, (lua_Number)sched->budget_ns / 1e6);
+    if (!lua_isnoneornil(L, 1))
+    {
+        lua_Number ms = luaL_checknumber(L, 1);
+        luaL_argcheck(L, ms >= 0 && ms <= GM_TASK_MAX_BUDGET_MS, 1, "budget out of range");
+        sched->budget_ns = (uint64_t)(ms * 1e6);
+    }
+    return 1;
+}
+
+// gm.taskStats() returns {id, name, time, last, resumes} per live task, times in milliseconds
+static int gm_task_lua_stats(lua_State *L)
+{
+    gm_task_sched_t *sched = gm_task_upvalue(L);
+    lua_createtable(L, sched->count, 0);
+    for (int i = 0; i < sched->count; i++)
+    {
+        const gm_task_t *task = &sched->tasks[i];
+        lua_createtable(L, 0, 5);
+        lua_pushinteger(L, task->id);
+        lua_setfield(L, -2, "id");
+        lua_pushstring(L, task->name);
+        lua_setfield(L, -2, "name");
+        lua_pushnumber(L, (lua_Number)task->total_ns / 1e6);
+        lua_setfield(L, -2, "time");
+        lua_pushnumber(L, (lua_Number)task->last_ns / 1e6);
+        lua_setfield(L, -2, "last");
+        lua_pushinteger(L, task->resumes);
+        lua_setfield(L, -2, "resumes");
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+void gm_task_register_lua(gm_task_sched_t *sched, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"spawnTask", gm_task_lua_spawn},
+        {"cancelTask", gm_task_lua_cancel},
+        {"taskBudget", gm_task_lua_budget},
+        {"taskStats", gm_task_lua_stats},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, sched);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
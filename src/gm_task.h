@@ -0,0 +1,62 @@
+#ifndef __GM_TASK_H__
+#define __GM_TASK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <lua.h>
+
+#include "gm_lua.h"
+
+#define GM_TASK_MAX 256
+#define GM_TASK_NAME_SIZE 32
+
+// time given to tasks after each draw, in milliseconds
+#define GM_TASK_DEFAULT_BUDGET_MS 4.0f
+#define GM_TASK_MAX_BUDGET_MS 1000.0f
+
+// A coroutine started by gm.spawnTask, resumed a slice at a time after draw
+typedef struct
+{
+    int id;
+    int ref;
+    lua_State *co;
+    char name[GM_TASK_NAME_SIZE];
+
+    uint64_t total_ns;
+    uint64_t last_ns;
+    uint32_t resumes;
+
+    // script load it was spawned by, tasks of a replaced script are dropped
+    int generation;
+
+    // a task cancelling itself is removed once it yields
+    bool running;
+    bool cancelled;
+} gm_task_t;
+
+typedef struct
+{
+    gm_lua_t *lua_ctx;
+    lua_State *L;
+    uint64_t budget_ns;
+
+    gm_task_t tasks[GM_TASK_MAX];
+    int count;
+    int next_id;
+
+    // round robin position, so a long task cannot starve the ones after it
+    int cursor;
+} gm_task_sched_t;
+
+int gm_task_init(gm_task_sched_t **sched, gm_lua_t *lua_ctx, float budget_ms);
+void gm_task_shutdown(gm_task_sched_t *sched);
+
+// Resumes tasks in turn until the budget is used up or none is left, after
+// dropping the tasks of a script that has been reloaded since.
+// Returns the number of tasks that failed, their errors are logged and copied to err.
+int gm_task_run(gm_task_sched_t *sched, char *err, size_t err_size);
+
+// Adds gm.spawnTask, gm.cancelTask, gm.taskBudget and gm.taskStats to the game API.
+void gm_task_register_lua(gm_task_sched_t *sched, lua_State *L);
+
+#endif // __GM_TASK_H__
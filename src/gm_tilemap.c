@@ -0,0 +1,436 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+
+#include "gm_tilemap.h"
+#include "gm_array.h"
+#include "gm_canvas.h"
+#include "gm_sprite.h"
+
+int gm_tilemap_init(gm_tilemap_ctx_t **ctx, SDL_Renderer *renderer, gm_lua_game_t *game)
+{
+    (*ctx) = (gm_tilemap_ctx_t *)calloc(sizeof(gm_tilemap_ctx_t), 1);
+    if ((*ctx) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_tilemap_ctx_t.\n");
+        return 1;
+    }
+
+    (*ctx)->renderer = renderer;
+    (*ctx)->game = game;
+    return 0;
+}
+
+void gm_tilemap_shutdown(gm_tilemap_ctx_t *ctx)
+{
+    if (ctx)
+    {
+        free(ctx);
+    }
+}
+
+static void gm_tilemap_mark(gm_tilemap_t *map, int x, int y)
+{
+    map->chunks[(y / GM_TILEMAP_CHUNK) * map->chunks_x + x / GM_TILEMAP_CHUNK].dirty = true;
+}
+
+static void gm_tilemap_mark_all(gm_tilemap_t *map)
+{
+    for (int i = 0; i < map->chunks_x * map->chunks_y; i++)
+    {
+        map->chunks[i].dirty = true;
+    }
+}
+
+static void gm_tilemap_drop(gm_tilemap_t *map, gm_tilemap_chunk_t *chunk)
+{
+    if (chunk->texture)
+    {
+        SDL_DestroyTexture(chunk->texture);
+        chunk->texture = NULL;
+
+        // the last cached chunk takes the freed slot
+        int last = map->cached_chunks[--map->cached];
+        map->cached_chunks[chunk->slot] = last;
+        map->chunks[last].slot = chunk->slot;
+    }
+}
+
+// Makes room for one more cached chunk by dropping the one drawn the longest ago.
+// Chunks on screen in the current draw are kept, returns false if all of them are.
+static bool gm_tilemap_evict(gm_tilemap_t *map)
+{
+    gm_tilemap_chunk_t *oldest = NULL;
+    for (int i = 0; i < map->cached; i++)
+    {
+        gm_tilemap_chunk_t *chunk = &map->chunks[map->cached_chunks[i]];
+        if (chunk->last_used != map->frame &&
+            (oldest == NULL || chunk->last_used < oldest->last_used))
+        {
+            oldest = chunk;
+        }
+    }
+    if (oldest == NULL)
+    {
+        return false;
+    }
+    gm_tilemap_drop(map, oldest);
+    return true;
+}
+
+// Draws the tiles of chunk cx, cy into its texture, creating it if needed.
+// Returns false if the texture could not be created.
+static bool gm_tilemap_render_chunk(gm_tilemap_ctx_t *ctx, gm_tilemap_t *map, SDL_Texture *tileset, int cx, int cy)
+{
+    gm_tilemap_chunk_t *chunk = &map->chunks[cy * map->chunks_x + cx];
+    int size = GM_TILEMAP_CHUNK * map->tile_size;
+    if (chunk->texture == NULL)
+    {
+        // the cache grows past its limit while more chunks than that are on screen
+        if (map->cached >= GM_TILEMAP_MAX_CACHED)
+        {
+            gm_tilemap_evict(map);
+        }
+        if (map->cached == map->cached_cap)
+        {
+            int cap = SDL_max(map->cached_cap * 2, GM_TILEMAP_MAX_CACHED);
+            int *list = (int *)realloc(map->cached_chunks, sizeof(int) * (size_t)cap);
+            if (list == NULL)
+            {
+                SDL_OutOfMemory();
+                return false;
+            }
+            map->cached_chunks = list;
+            map->cached_cap = cap;
+        }
+        chunk->texture = SDL_CreateTexture(ctx->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, size, size);
+        if (chunk->texture == NULL)
+        {
+            return false;
+        }
+        SDL_SetTextureScaleMode(chunk->texture, SDL_SCALEMODE_NEAREST);
+        SDL_SetTextureBlendMode(chunk->texture, SDL_BLENDMODE_BLEND);
+        chunk->slot = map->cached;
+        map->cached_chunks[map->cached++] = cy * map->chunks_x + cx;
+    }
+
+    // empty tiles stay transparent, so maps can be layered
+    gm_lua_game_t *game = ctx->game;
+    SDL_SetRenderTarget(ctx->renderer, chunk->texture);
+    gm_lua_set_draw_color(game, 0x00000000u);
+    SDL_RenderClear(ctx->renderer);
+
+    float ts = (float)map->tile_size;
+    int x1 = SDL_min((cx + 1) * GM_TILEMAP_CHUNK, map->w);
+    int y1 = SDL_min((cy + 1) * GM_TILEMAP_CHUNK, map->h);
+    for (int y = cy * GM_TILEMAP_CHUNK; y < y1; y++)
+    {
+        for (int x = cx * GM_TILEMAP_CHUNK; x < x1; x++)
+        {
+            int tile = map->tiles[y * map->w + x];
+            if (tile <= 0 || tile > map->frames)
+            {
+                continue;
+            }
+            SDL_FRect src = {
+                .x = (float)(((tile - 1) % map->columns) * map->tile_size),
+                .y = (float)(((tile - 1) / map->columns) * map->tile_size),
+                .w = ts,
+                .h = ts};
+            SDL_FRect dst = {
+                .x = (float)(x - cx * GM_TILEMAP_CHUNK) * ts,
+                .y = (float)(y - cy * GM_TILEMAP_CHUNK) * ts,
+                .w = ts,
+                .h = ts};
+            SDL_RenderTexture(ctx->renderer, tileset, &src, &dst);
+        }
+    }
+    SDL_SetRenderTarget(ctx->renderer, game->target);
+
+    chunk->dirty = false;
+    map->renders++;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_tilemap_ctx_t *gm_tilemap_upvalue(lua_State *L)
+{
+    return (gm_tilemap_ctx_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static gm_tilemap_t *gm_tilemap_check(lua_State *L, int idx)
+{
+    return (gm_tilemap_t *)luaL_checkudata(L, idx, GM_TILEMAP_MT);
+}
+
+// The tileset is a gm.image, or a gm.canvas for tiles drawn by the script.
+static SDL_Texture *gm_tilemap_check_tileset(lua_State *L, int idx, int *w, int *h)
+{
+    gm_image_t *img = (gm_image_t *)luaL_testudata(L, idx, GM_IMAGE_MT);
+    if (img)
+    {
+        *w = img->w;
+        *h = img->h;
+        return img->texture;
+    }
+    gm_canvas_t *cvs = (gm_canvas_t *)luaL_testudata(L, idx, GM_CANVAS_MT);
+    luaL_argexpected(L, cvs != NULL, idx, "image or canvas");
+    *w = cvs->w;
+    *h = cvs->h;
+    return cvs->texture;
+}
+
+// reads tile coordinates at idx, idx + 1, from 0
+static int gm_tilemap_check_index(lua_State *L, const gm_tilemap_t *map, int idx)
+{
+    lua_Integer x = luaL_checkinteger(L, idx);
+    lua_Integer y = luaL_checkinteger(L, idx + 1);
+    luaL_argcheck(L, x >= 0 && x < map->w, idx, "x out of range");
+    luaL_argcheck(L, y >= 0 && y < map->h, idx + 1, "y out of range");
+    return (int)(y * map->w + x);
+}
+
+// gm.newTilemap(tileset, w, h, tileSize), w x h tiles of tileSize pixels, all empty.
+// Tiles are cut from the tileset row by row.
+static int gm_tilemap_lua_new(lua_State *L)
+{
+    int tw = 0, th = 0;
+    gm_tilemap_check_tileset(L, 1, &tw, &th);
+    lua_Integer w = luaL_checkinteger(L, 2);
+    lua_Integer h = luaL_checkinteger(L, 3);
+    lua_Integer ts = luaL_checkinteger(L, 4);
+    luaL_argcheck(L, w > 0 && w <= GM_TILEMAP_MAX_SIZE, 2, "width out of range");
+    luaL_argcheck(L, h > 0 && h <= GM_TILEMAP_MAX_SIZE, 3, "height out of range");
+    luaL_argcheck(L, ts > 0 && ts <= tw && ts <= th && ts * GM_TILEMAP_CHUNK <= 4096, 4,
+                  "tile size out of range");
+
+    gm_tilemap_t *map = (gm_tilemap_t *)lua_newuserdatauv(L, sizeof(gm_tilemap_t), 1);
+    memset(map, 0, sizeof(gm_tilemap_t));
+    luaL_setmetatable(L, GM_TILEMAP_MT);
+
+    map->w = (int)w;
+    map->h = (int)h;
+    map->tile_size = (int)ts;
+    map->columns = tw / map->tile_size;
+    map->frames = map->columns * (th / map->tile_size);
+    map->chunks_x = (map->w + GM_TILEMAP_CHUNK - 1) / GM_TILEMAP_CHUNK;
+    map->chunks_y = (map->h + GM_TILEMAP_CHUNK - 1) / GM_TILEMAP_CHUNK;
+    map->tiles = (int32_t *)calloc((size_t)map->w * (size_t)map->h, sizeof(int32_t));
+    map->chunks = (gm_tilemap_chunk_t *)calloc((size_t)map->chunks_x * (size_t)map->chunks_y, sizeof(gm_tilemap_chunk_t));
+    if (map->tiles == NULL || map->chunks == NULL)
+    {
+        return luaL_error(L, "out of memory for a %dx%d tilemap", map->w, map->h);
+    }
+
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
+}
+
+static int gm_tilemap_lua_gc(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    while (map->cached > 0)
+    {
+        gm_tilemap_drop(map, &map->chunks[map->cached_chunks[map->cached - 1]]);
+    }
+    free(map->cached_chunks);
+    map->cached_chunks = NULL;
+    map->cached_cap = 0;
+    free(map->chunks);
+    free(map->tiles);
+    map->chunks = NULL;
+    map->tiles = NULL;
+    map->w = map->h = 0;
+    map->chunks_x = map->chunks_y = 0;
+    return 0;
+}
+
+static int gm_tilemap_lua_get(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    lua_pushinteger(L, map->tiles[gm_tilemap_check_index(L, map, 2)]);
+    return 1;
+}
+
+// map:set(x, y, tile), only the chunk holding the tile is drawn again
+static int gm_tilemap_lua_set(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    int i = gm_tilemap_check_index(L, map, 2);
+    int32_t tile = (int32_t)luaL_checkinteger(L, 4);
+    if (map->tiles[i] != tile)
+    {
+        map->tiles[i] = tile;
+        gm_tilemap_mark(map, i % map->w, i / map->w);
+    }
+    return 0;
+}
+
+// map:fill(tile [, x, y, w, h])
+static int gm_tilemap_lua_fill(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    int32_t tile = (int32_t)luaL_checkinteger(L, 2);
+    lua_Integer x0 = luaL_optinteger(L, 3, 0);
+    lua_Integer y0 = luaL_optinteger(L, 4, 0);
+    lua_Integer x1 = SDL_min(x0 + luaL_optinteger(L, 5, map->w), (lua_Integer)map->w);
+    lua_Integer y1 = SDL_min(y0 + luaL_optinteger(L, 6, map->h), (lua_Integer)map->h);
+    x0 = SDL_max(x0, 0);
+    y0 = SDL_max(y0, 0);
+    for (lua_Integer y = y0; y < y1; y++)
+    {
+        for (lua_Integer x = x0; x < x1; x++)
+        {
+            map->tiles[y * map->w + x] = tile;
+        }
+    }
+    for (lua_Integer cy = y0 / GM_TILEMAP_CHUNK; y1 > y0 && cy <= (y1 - 1) / GM_TILEMAP_CHUNK; cy++)
+    {
+        for (lua_Integer cx = x0 / GM_TILEMAP_CHUNK; x1 > x0 && cx <= (x1 - 1) / GM_TILEMAP_CHUNK; cx++)
+        {
+            map->chunks[cy * map->chunks_x + cx].dirty = true;
+        }
+    }
+    return 0;
+}
+
+// map:load(arr) copies the tiles from a u8 or i32 gm.array the size of the map
+static int gm_tilemap_lua_load(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    gm_array_t *arr = gm_array_check(L, 2);
+    luaL_argcheck(L, arr->w == map->w && arr->h == map->h, 2, "array and map differ in size");
+    luaL_argcheck(L, arr->type == GM_ARRAY_U8 || arr->type == GM_ARRAY_I32, 2, "tiles must be u8 or i32");
+
+    if (arr->type == GM_ARRAY_I32)
+    {
+        memcpy(map->tiles, arr->data, sizeof(int32_t) * arr->count);
+    }
+    else
+    {
+        const uint8_t *src = (const uint8_t *)arr->data;
+        for (size_t i = 0; i < arr->count; i++)
+        {
+            map->tiles[i] = src[i];
+        }
+    }
+    gm_tilemap_mark_all(map);
+    return 0;
+}
+
+// map:invalidate() draws every chunk again when next visible, after the tileset changed
+static int gm_tilemap_lua_invalidate(lua_State *L)
+{
+    gm_tilemap_mark_all(gm_tilemap_check(L, 1));
+    return 0;
+}
+
+static int gm_tilemap_lua_width(lua_State *L)
+{
+    lua_pushinteger(L, gm_tilemap_check(L, 1)->w);
+    return 1;
+}
+
+static int gm_tilemap_lua_height(lua_State *L)
+{
+    lua_pushinteger(L, gm_tilemap_check(L, 1)->h);
+    return 1;
+}
+
+static int gm_tilemap_lua_tile_size(lua_State *L)
+{
+    lua_pushinteger(L, gm_tilemap_check(L, 1)->tile_size);
+    return 1;
+}
+
+// map:stats() returns the number of cached chunks and of chunk redraws so far
+static int gm_tilemap_lua_stats(lua_State *L)
+{
+    gm_tilemap_t *map = gm_tilemap_check(L, 1);
+    lua_pushinteger(L, map->cached);
+    lua_pushinteger(L, map->renders);
+    return 2;
+}
+
+// gm:drawTilemap(map, x, y), x, y is where the map's top left corner goes, so
+// scrolling right means a decreasing x. Only the chunks on the target are drawn.
+static int gm_tilemap_lua_draw(lua_State *L)
+{
+    luaL_checkudata(L, 1, GM_GAME_MT);
+    gm_tilemap_ctx_t *ctx = gm_tilemap_upvalue(L);
+    gm_tilemap_t *map = gm_tilemap_check(L, 2);
+    float ox = SDL_floorf((float)luaL_checknumber(L, 3));
+    float oy = SDL_floorf((float)luaL_checknumber(L, 4));
+    gm_lua_game_t *game = ctx->game;
+
+    int tw = 0, th = 0;
+    lua_getiuservalue(L, 2, 1);
+    SDL_Texture *tileset = gm_tilemap_check_tileset(L, -1, &tw, &th);
+    lua_pop(L, 1);
+    luaL_argcheck(L, tileset != game->target, 2, "cannot draw a tilemap into its tileset");
+
+    // chunk range covering the current target
+    float size = (float)(GM_TILEMAP_CHUNK * map->tile_size);
+    int cx0 = SDL_max((int)SDL_floorf(-ox / size), 0);
+    int cy0 = SDL_max((int)SDL_floorf(-oy / size), 0);
+    int cx1 = SDL_min((int)SDL_floorf(((float)game->target_w - ox) / size), map->chunks_x - 1);
+    int cy1 = SDL_min((int)SDL_floorf(((float)game->target_h - oy) / size), map->chunks_y - 1);
+
+    map->frame++;
+    for (int cy = cy0; cy <= cy1; cy++)
+    {
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            gm_tilemap_chunk_t *chunk = &map->chunks[cy * map->chunks_x + cx];
+            chunk->last_used = map->frame;
+            if ((chunk->texture == NULL || chunk->dirty) && !gm_tilemap_render_chunk(ctx, map, tileset, cx, cy))
+            {
+                return luaL_error(L, "could not create a tilemap chunk: %s", SDL_GetError());
+            }
+            SDL_FRect dst = {ox + (float)cx * size, oy + (float)cy * size, size, size};
+            SDL_RenderTexture(ctx->renderer, chunk->texture, NULL, &dst);
+        }
+    }
+
+    // back under the limit once the view no longer needs the extra chunks
+    while (map->cached > GM_TILEMAP_MAX_CACHED && gm_tilemap_evict(map))
+    {
+    }
+    return 0;
+}
+
+void gm_tilemap_register_lua(gm_tilemap_ctx_t *ctx, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"get", gm_tilemap_lua_get},
+        {"set", gm_tilemap_lua_set},
+        {"fill", gm_tilemap_lua_fill},
+        {"load", gm_tilemap_lua_load},
+        {"invalidate", gm_tilemap_lua_invalidate},
+        {"width", gm_tilemap_lua_width},
+        {"height", gm_tilemap_lua_height},
+        {"tileSize", gm_tilemap_lua_tile_size},
+        {"stats", gm_tilemap_lua_stats},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"newTilemap", gm_tilemap_lua_new},
+        {"drawTilemap", gm_tilemap_lua_draw},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_TILEMAP_MT);
+    lua_pushcfunction(L, gm_tilemap_lua_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, ctx);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
@@ -0,0 +1,69 @@
+#ifndef __GM_TILEMAP_H__
+#define __GM_TILEMAP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_lua.h"
+
+#define GM_TILEMAP_MT "gm.tilemap"
+#define GM_TILEMAP_MAX_SIZE 16384
+
+// chunks are GM_TILEMAP_CHUNK x GM_TILEMAP_CHUNK tiles
+#define GM_TILEMAP_CHUNK 16
+
+// pre-rendered chunks kept per map, the least recently drawn is dropped beyond that,
+// chunks on screen are kept even if there are more of them
+#define GM_TILEMAP_MAX_CACHED 64
+
+typedef struct
+{
+    SDL_Renderer *renderer;
+    gm_lua_game_t *game;
+} gm_tilemap_ctx_t;
+
+// A chunk's tiles drawn into a texture, redrawn only after one of them changes
+typedef struct
+{
+    SDL_Texture *texture;
+    bool dirty;
+    uint32_t last_used;
+
+    // position in the map's list of cached chunks while it has a texture
+    int slot;
+} gm_tilemap_chunk_t;
+
+// Lua userdata behind gm.newTilemap. Its tileset image or canvas is kept alive in user value 1.
+typedef struct
+{
+    int w;
+    int h;
+
+    // tile n is frame n of the tileset, numbered from 1 row by row, 0 is empty
+    int32_t *tiles;
+    int tile_size;
+    int columns;
+    int frames;
+
+    gm_tilemap_chunk_t *chunks;
+    int chunks_x;
+    int chunks_y;
+    // indices of the chunks that have a texture, so eviction only looks at those
+    int *cached_chunks;
+    int cached_cap;
+    int cached;
+
+    // draw count, for the least recently used chunk
+    uint32_t frame;
+    uint32_t renders;
+} gm_tilemap_t;
+
+int gm_tilemap_init(gm_tilemap_ctx_t **ctx, SDL_Renderer *renderer, gm_lua_game_t *game);
+void gm_tilemap_shutdown(gm_tilemap_ctx_t *ctx);
+
+// Adds gm.newTilemap and gm:drawTilemap to the game API.
+void gm_tilemap_register_lua(gm_tilemap_ctx_t *ctx, lua_State *L);
+
+#endif // __GM_TILEMAP_H__
@@ -0,0 +1,344 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_trace.h"
+#include "gm_lua.h"
+
+// nesting limit for gm.traceBegin spans
+#define GM_TRACE_LUA_DEPTH 32
+
+// events this close to the write position may be overwritten while they are read
+#define GM_TRACE_READ_MARGIN 64
+
+typedef struct
+{
+    uint64_t start_ns;
+    uint64_t dur_ns;
+    char name[GM_TRACE_NAME_SIZE];
+} gm_trace_event_t;
+
+typedef struct
+{
+    char name[GM_TRACE_NAME_SIZE];
+    uint64_t start_ns;
+} gm_trace_span_t;
+
+// One per thread, written only by its thread. Buffers are never freed before
+// gm_trace_shutdown, so a trace can still be written after the thread exits.
+typedef struct gm_trace_buffer_t
+{
+    struct gm_trace_buffer_t *next;
+    SDL_ThreadID thread;
+    char thread_name[32];
+
+    // total events ever written, the slot is head % GM_TRACE_EVENTS
+    SDL_AtomicU32 head;
+    gm_trace_event_t events[GM_TRACE_EVENTS];
+
+    // open gm.traceBegin spans of the Lua state running on this thread
+    gm_trace_span_t lua_spans[GM_TRACE_LUA_DEPTH];
+    int lua_depth;
+} gm_trace_buffer_t;
+
+typedef struct
+{
+    bool enabled;
+    uint64_t origin_ns;
+    SDL_TLSID tls;
+
+    // lock-free list of all thread buffers, new buffers are pushed at the front
+    void *buffers;
+} gm_trace_t;
+
+static gm_trace_t gm_trace;
+
+void gm_trace_init(bool enabled)
+{
+    gm_trace.enabled = enabled;
+    gm_trace.origin_ns = SDL_GetTicksNS();
+    if (enabled)
+    {
+        gm_trace_thread_name("main");
+    }
+}
+
+void gm_trace_shutdown(void)
+{
+    gm_trace.enabled = false;
+    gm_trace_buffer_t *b = (gm_trace_buffer_t *)SDL_GetAtomicPointer(&gm_trace.buffers);
+    SDL_SetAtomicPointer(&gm_trace.buffers, NULL);
+    while (b)
+    {
+        gm_trace_buffer_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    SDL_SetTLS(&gm_trace.tls, NULL, NULL);
+}
+
+bool gm_trace_enabled(void)
+{
+    return gm_trace.enabled;
+}
+
+// Allocates a buffer and adds it to the list, the only allocation a traced thread makes.
+static gm_trace_buffer_t *gm_trace_buffer_new(void)
+{
+    gm_trace_buffer_t *b = (gm_trace_buffer_t *)calloc(sizeof(gm_trace_buffer_t), 1);
+    if (b == NULL)
+    {
+        return NULL;
+    }
+
+    void *head;
+    do
+    {
+        head = SDL_GetAtomicPointer(&gm_trace.buffers);
+        b->next = (gm_trace_buffer_t *)head;
+    } while (!SDL_CompareAndSwapAtomicPointer(&gm_trace.buffers, head, b));
+    return b;
+}
+
+static gm_trace_buffer_t *gm_trace_buffer(void)
+{
+    gm_trace_buffer_t *b = (gm_trace_buffer_t *)SDL_GetTLS(&gm_trace.tls);
+    if (b)
+    {
+        return b;
+    }
+
+    // first event on this thread
+    b = gm_trace_buffer_new();
+    if (b == NULL)
+    {
+        return NULL;
+    }
+    b->thread = SDL_GetCurrentThreadID();
+    SDL_snprintf(b->thread_name, sizeof(b->thread_name), "thread %llu", (unsigned long long)b->thread);
+    SDL_SetTLS(&gm_trace.tls, b, NULL);
+    return b;
+}
+
+gm_trace_buffer_t *gm_trace_thread_reserve(const char *name)
+{
+    if (!gm_trace.enabled)
+    {
+        return NULL;
+    }
+    gm_trace_buffer_t *b = gm_trace_buffer_new();
+    if (b)
+    {
+        SDL_strlcpy(b->thread_name, name, sizeof(b->thread_name));
+    }
+    return b;
+}
+
+void gm_trace_thread_attach(gm_trace_buffer_t *b)
+{
+    if (b == NULL || !gm_trace.enabled)
+    {
+        return;
+    }
+    b->thread = SDL_GetCurrentThreadID();
+    SDL_SetTLS(&gm_trace.tls, b, NULL);
+}
+
+void gm_trace_thread_name(const char *name)
+{
+    if (!gm_trace.enabled)
+    {
+        return;
+    }
+    gm_trace_buffer_t *b = gm_trace_buffer();
+    if (b)
+    {
+        SDL_strlcpy(b->thread_name, name, sizeof(b->thread_name));
+    }
+}
+
+uint64_t gm_trace_begin(void)
+{
+    return gm_trace.enabled ? SDL_GetTicksNS() : 0;
+}
+
+static void gm_trace_push(gm_trace_buffer_t *b, const char *name, uint64_t start_ns, uint64_t end_ns)
+{
+    uint32_t head = SDL_GetAtomicU32(&b->head);
+    gm_trace_event_t *ev = &b->events[head % GM_TRACE_EVENTS];
+    ev->start_ns = start_ns;
+    ev->dur_ns = end_ns - start_ns;
+    SDL_strlcpy(ev->name, name, sizeof(ev->name));
+
+    // publish the event before moving the head, for gm_trace_write on another thread
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicU32(&b->head, head + 1);
+}
+
+void gm_trace_end(const char *name, uint64_t start_ns)
+{
+    if (!gm_trace.enabled || start_ns == 0)
+    {
+        return;
+    }
+    gm_trace_buffer_t *b = gm_trace_buffer();
+    if (b)
+    {
+        gm_trace_push(b, name, start_ns, SDL_GetTicksNS());
+    }
+}
+
+// JSON string contents, names come from scripts so quotes and control characters are replaced
+static void gm_trace_write_name(SDL_IOStream *io, const char *name)
+{
+    char clean[GM_TRACE_NAME_SIZE];
+    size_t i = 0;
+    for (; name[i] != '\0' && i < sizeof(clean) - 1; i++)
+    {
+        char c = name[i];
+        clean[i] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    clean[i] = '\0';
+    SDL_IOprintf(io, "\"%s\"", clean);
+}
+
+int gm_trace_write(const char *path)
+{
+    if (!gm_trace.enabled)
+    {
+        return 1;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+    if (io == NULL)
+    {
+        SDL_Log("Could not write trace %s: %s\n", path, SDL_GetError());
+        return 1;
+    }
+
+    SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    uint32_t written = 0;
+    for (gm_trace_buffer_t *b = (gm_trace_buffer_t *)SDL_GetAtomicPointer(&gm_trace.buffers); b; b = b->next)
+    {
+        SDL_IOprintf(io, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":",
+                     first ? "" : ",\n", (unsigned long long)b->thread);
+        gm_trace_write_name(io, b->thread_name);
+        SDL_IOprintf(io, "}}");
+        first = false;
+
+        // the owning thread may still be writing, skip the slots it could be overwriting
+        uint32_t head = SDL_GetAtomicU32(&b->head);
+        SDL_MemoryBarrierAcquire();
+        uint32_t tail = (head > GM_TRACE_EVENTS - GM_TRACE_READ_MARGIN) ? head - (GM_TRACE_EVENTS - GM_TRACE_READ_MARGIN) : 0;
+        for (uint32_t i = tail; i != head; i++)
+        {
+            const gm_trace_event_t *ev = &b->events[i % GM_TRACE_EVENTS];
+            if (ev->start_ns < gm_trace.origin_ns)
+            {
+                continue;
+            }
+            SDL_IOprintf(io, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                         (unsigned long long)b->thread,
+                         (double)(ev->start_ns - gm_trace.origin_ns) / 1000.0,
+                         (double)ev->dur_ns / 1000.0);
+            gm_trace_write_name(io, ev->name);
+            SDL_IOprintf(io, "}");
+            written++;
+        }
+    }
+    SDL_IOprintf(io, "\n]}\n");
+    SDL_CloseIO(io);
+
+    SDL_Log("Trace written to %s: %u events\n", path, written);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+// gm.traceBegin(name), spans nest and are closed by gm.traceEnd
+static int gm_trace_lua_begin(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    if (!gm_trace.enabled)
+    {
+        return 0;
+    }
+    gm_trace_buffer_t *b = gm_trace_buffer();
+    if (b == NULL)
+    {
+        return 0;
+    }
+
+    // spans nested deeper than the limit are counted but not recorded
+    if (b->lua_depth < GM_TRACE_LUA_DEPTH)
+    {
+        gm_trace_span_t *span = &b->lua_spans[b->lua_depth];
+        SDL_strlcpy(span->name, name, sizeof(span->name));
+        span->start_ns = SDL_GetTicksNS();
+    }
+    b->lua_depth++;
+    return 0;
+}
+
+// gm.traceEnd() closes the innermost open span. An end without a begin is ignored,
+// so a script behaves the same whether it is traced or not.
+static int gm_trace_lua_end(lua_State *L)
+{
+    (void)L;
+    if (!gm_trace.enabled)
+    {
+        return 0;
+    }
+    gm_trace_buffer_t *b = gm_trace_buffer();
+    if (b == NULL || b->lua_depth == 0)
+    {
+        return 0;
+    }
+
+    b->lua_depth--;
+    if (b->lua_depth < GM_TRACE_LUA_DEPTH)
+    {
+        gm_trace_span_t *span = &b->lua_spans[b->lua_depth];
+        gm_trace_push(b, span->name, span->start_ns, SDL_GetTicksNS());
+    }
+    return 0;
+}
+
+void gm_trace_lua_reset(void)
+{
+    if (!gm_trace.enabled)
+    {
+        return;
+    }
+    gm_trace_buffer_t *b = (gm_trace_buffer_t *)SDL_GetTLS(&gm_trace.tls);
+    if (b)
+    {
+        b->lua_depth = 0;
+    }
+}
+
+// gm.traceSave(path), returns true if the trace was written
+static int gm_trace_lua_save(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    lua_pushboolean(L, gm_trace_write(path) == 0);
+    return 1;
+}
+
+void gm_trace_register_lua(lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"traceBegin", gm_trace_lua_begin},
+        {"traceEnd", gm_trace_lua_end},
+        {"traceSave", gm_trace_lua_save},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    luaL_setfuncs(L, funcs, 0);
+    lua_pop(L, 1);
+}
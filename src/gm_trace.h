@@ -0,0 +1,44 @@
+#ifndef __GM_TRACE_H__
+#define __GM_TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <lua.h>
+
+// events kept per thread, older ones are overwritten
+#define GM_TRACE_EVENTS 32768
+#define GM_TRACE_NAME_SIZE 40
+
+// Records timed spans from any thread into per-thread ring buffers and writes
+// them as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Everything is a no-op until gm_trace_init is called with enabled set.
+void gm_trace_init(bool enabled);
+void gm_trace_shutdown(void);
+bool gm_trace_enabled(void);
+
+// Names the calling thread in the trace.
+void gm_trace_thread_name(const char *name);
+
+typedef struct gm_trace_buffer_t gm_trace_buffer_t;
+
+// For threads that must not allocate, like the audio callback: the buffer is
+// allocated here on the calling thread, and taken by the traced thread with
+// gm_trace_thread_attach before its first event. NULL while tracing is off.
+gm_trace_buffer_t *gm_trace_thread_reserve(const char *name);
+void gm_trace_thread_attach(gm_trace_buffer_t *b);
+
+// Drops the gm.traceBegin spans a script left open on the calling thread, after
+// a draw error or a reload. Called at the start of every frame.
+void gm_trace_lua_reset(void);
+
+// Returns the start time of a span, pass it to gm_trace_end with the span's name.
+uint64_t gm_trace_begin(void);
+void gm_trace_end(const char *name, uint64_t start_ns);
+
+// Writes every buffered event, returns 0 on success.
+int gm_trace_write(const char *path);
+
+// Adds gm.traceBegin(name), gm.traceEnd() and gm.traceSave(path) to the game API.
+void gm_trace_register_lua(lua_State *L);
+
+#endif // __GM_TRACE_H__
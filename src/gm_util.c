@@ -23,3 +23,15 @@ time_t get_file_mtime(const char *path)
     }
     return st.st_mtime;
 }
+
+uint64_t gm_hash_fnv1a(const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -1,6 +1,8 @@
 #ifndef __GM_UTIL_H__
 #define __GM_UTIL_H__
 
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 // Function to check if a file exists
@@ -8,4 +10,7 @@ int file_exists(const char *filename);
 
 time_t get_file_mtime(const char *path);
 
+// 64-bit FNV-1a hash of a memory block
+uint64_t gm_hash_fnv1a(const void *data, size_t len);
+
 #endif // __GM_UTIL_H__
\ No newline at end of file
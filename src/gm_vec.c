@@ -0,0 +1,613 @@
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_vec.h"
+#include "gm_array.h"
+#include "gm_lua.h"
+
+//----------------------------------------------------------------------------
+// gm.vec2
+//----------------------------------------------------------------------------
+
+gm_vec2_t *gm_vec2_push(lua_State *L, double x, double y)
+{
+    gm_vec2_t *v = (gm_vec2_t *)lua_newuserdatauv(L, sizeof(gm_vec2_t), 0);
+    v->x = x;
+    v->y = y;
+    luaL_setmetatable(L, GM_VEC2_MT);
+    return v;
+}
+
+static gm_vec2_t *gm_vec2_check(lua_State *L, int idx)
+{
+    return (gm_vec2_t *)luaL_checkudata(L, idx, GM_VEC2_MT);
+}
+
+// Reads a vector given either as a gm.vec2 or as two numbers, returns the index after it.
+static int gm_vec2_check_xy(lua_State *L, int idx, double *x, double *y)
+{
+    const gm_vec2_t *v = (const gm_vec2_t *)luaL_testudata(L, idx, GM_VEC2_MT);
+    if (v)
+    {
+        *x = v->x;
+        *y = v->y;
+        return idx + 1;
+    }
+    *x = luaL_checknumber(L, idx);
+    *y = luaL_checknumber(L, idx + 1);
+    return idx + 2;
+}
+
+// in place methods return the vector, so calls can be chained
+static int gm_vec_self(lua_State *L)
+{
+    lua_settop(L, 1);
+    return 1;
+}
+
+// gm.vec2([x, y]) or gm.vec2(v)
+static int gm_vec2_lua_new(lua_State *L)
+{
+    double x = 0.0, y = 0.0;
+    if (!lua_isnoneornil(L, 1))
+    {
+        gm_vec2_check_xy(L, 1, &x, &y);
+    }
+    gm_vec2_push(L, x, y);
+    return 1;
+}
+
+// v.x and v.y, anything else is looked up in the method table (upvalue 1)
+static int gm_vec2_lua_index(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    if (lua_type(L, 2) == LUA_TSTRING)
+    {
+        size_t len = 0;
+        const char *key = lua_tolstring(L, 2, &len);
+        if (len == 1 && (key[0] == 'x' || key[0] == 'y'))
+        {
+            lua_pushnumber(L, key[0] == 'x' ? v->x : v->y);
+            return 1;
+        }
+    }
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    return 1;
+}
+
+static int gm_vec2_lua_newindex(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    const char *key = luaL_checkstring(L, 2);
+    if (SDL_strcmp(key, "x") == 0)
+    {
+        v->x = luaL_checknumber(L, 3);
+    }
+    else if (SDL_strcmp(key, "y") == 0)
+    {
+        v->y = luaL_checknumber(L, 3);
+    }
+    else
+    {
+        return luaL_error(L, "vec2 has no field '%s'", key);
+    }
+    return 0;
+}
+
+static int gm_vec2_lua_tostring(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    lua_pushfstring(L, "vec2(%f, %f)", v->x, v->y);
+    return 1;
+}
+
+static int gm_vec2_lua_eq(lua_State *L)
+{
+    const gm_vec2_t *a = (const gm_vec2_t *)luaL_testudata(L, 1, GM_VEC2_MT);
+    const gm_vec2_t *b = (const gm_vec2_t *)luaL_testudata(L, 2, GM_VEC2_MT);
+    lua_pushboolean(L, a && b && a->x == b->x && a->y == b->y);
+    return 1;
+}
+
+// v:set(x, y) or v:set(w)
+static int gm_vec2_lua_set(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    gm_vec2_check_xy(L, 2, &v->x, &v->y);
+    return gm_vec_self(L);
+}
+
+static int gm_vec2_lua_add(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    v->x += x;
+    v->y += y;
+    return gm_vec_self(L);
+}
+
+static int gm_vec2_lua_sub(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    v->x -= x;
+    v->y -= y;
+    return gm_vec_self(L);
+}
+
+// v:mul(x, y) or v:mul(w), component by component
+static int gm_vec2_lua_mul(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    v->x *= x;
+    v->y *= y;
+    return gm_vec_self(L);
+}
+
+static int gm_vec2_lua_scale(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double s = luaL_checknumber(L, 2);
+    v->x *= s;
+    v->y *= s;
+    return gm_vec_self(L);
+}
+
+// v:addScaled(w, s) or v:addScaled(x, y, s), v += w * s, e.g. pos:addScaled(vel, dt)
+static int gm_vec2_lua_add_scaled(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    int idx = gm_vec2_check_xy(L, 2, &x, &y);
+    double s = luaL_checknumber(L, idx);
+    v->x += x * s;
+    v->y += y * s;
+    return gm_vec_self(L);
+}
+
+// v:lerp(w, t) or v:lerp(x, y, t), moves v towards w by the fraction t
+static int gm_vec2_lua_lerp(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    int idx = gm_vec2_check_xy(L, 2, &x, &y);
+    double t = luaL_checknumber(L, idx);
+    v->x += (x - v->x) * t;
+    v->y += (y - v->y) * t;
+    return gm_vec_self(L);
+}
+
+// v:normalize() leaves the zero vector alone
+static int gm_vec2_lua_normalize(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double len = SDL_sqrt(v->x * v->x + v->y * v->y);
+    if (len > 0.0)
+    {
+        v->x /= len;
+        v->y /= len;
+    }
+    return gm_vec_self(L);
+}
+
+// v:limit(max) shortens v to at most max
+static int gm_vec2_lua_limit(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double max = luaL_checknumber(L, 2);
+    double len2 = v->x * v->x + v->y * v->y;
+    if (len2 > max * max && len2 > 0.0)
+    {
+        double s = max / SDL_sqrt(len2);
+        v->x *= s;
+        v->y *= s;
+    }
+    return gm_vec_self(L);
+}
+
+// v:rotate(angle), in radians
+static int gm_vec2_lua_rotate(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double a = luaL_checknumber(L, 2);
+    double c = SDL_cos(a), s = SDL_sin(a);
+    double x = v->x * c - v->y * s;
+    v->y = v->x * s + v->y * c;
+    v->x = x;
+    return gm_vec_self(L);
+}
+
+// v:perp() turns v a quarter to the left
+static int gm_vec2_lua_perp(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x = v->x;
+    v->x = -v->y;
+    v->y = x;
+    return gm_vec_self(L);
+}
+
+// v:transform(m) applies a gm.mat3 to the point v
+static int gm_vec2_lua_transform(lua_State *L)
+{
+    gm_vec2_t *v = gm_vec2_check(L, 1);
+    const double *m = ((const gm_mat3_t *)luaL_checkudata(L, 2, GM_MAT3_MT))->m;
+    double x = m[0] * v->x + m[1] * v->y + m[2];
+    v->y = m[3] * v->x + m[4] * v->y + m[5];
+    v->x = x;
+    return gm_vec_self(L);
+}
+
+// v:clone() is the only method that allocates
+static int gm_vec2_lua_clone(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    gm_vec2_push(L, v->x, v->y);
+    return 1;
+}
+
+static int gm_vec2_lua_unpack(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    lua_pushnumber(L, v->x);
+    lua_pushnumber(L, v->y);
+    return 2;
+}
+
+static int gm_vec2_lua_len(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    lua_pushnumber(L, SDL_sqrt(v->x * v->x + v->y * v->y));
+    return 1;
+}
+
+static int gm_vec2_lua_len2(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    lua_pushnumber(L, v->x * v->x + v->y * v->y);
+    return 1;
+}
+
+static int gm_vec2_lua_angle(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    lua_pushnumber(L, SDL_atan2(v->y, v->x));
+    return 1;
+}
+
+static int gm_vec2_lua_dot(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    lua_pushnumber(L, v->x * x + v->y * y);
+    return 1;
+}
+
+// v:cross(w) is the z of the 3D cross product, positive when w is to the left of v
+static int gm_vec2_lua_cross(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    lua_pushnumber(L, v->x * y - v->y * x);
+    return 1;
+}
+
+static int gm_vec2_lua_dist(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    lua_pushnumber(L, SDL_sqrt((v->x - x) * (v->x - x) + (v->y - y) * (v->y - y)));
+    return 1;
+}
+
+static int gm_vec2_lua_dist2(lua_State *L)
+{
+    const gm_vec2_t *v = gm_vec2_check(L, 1);
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    lua_pushnumber(L, (v->x - x) * (v->x - x) + (v->y - y) * (v->y - y));
+    return 1;
+}
+
+//----------------------------------------------------------------------------
+// gm.mat3
+//----------------------------------------------------------------------------
+
+static const double gm_mat3_identity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+gm_mat3_t *gm_mat3_push(lua_State *L)
+{
+    gm_mat3_t *m = (gm_mat3_t *)lua_newuserdatauv(L, sizeof(gm_mat3_t), 0);
+    memcpy(m->m, gm_mat3_identity, sizeof(m->m));
+    luaL_setmetatable(L, GM_MAT3_MT);
+    return m;
+}
+
+static gm_mat3_t *gm_mat3_check(lua_State *L, int idx)
+{
+    return (gm_mat3_t *)luaL_checkudata(L, idx, GM_MAT3_MT);
+}
+
+// out = a * b, out may be a or b
+static void gm_mat3_mul(double *out, const double *a, const double *b)
+{
+    double r[9];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            r[i * 3 + j] = a[i * 3] * b[j] + a[i * 3 + 1] * b[3 + j] + a[i * 3 + 2] * b[6 + j];
+        }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+// gm.mat3() is the identity
+static int gm_mat3_lua_new(lua_State *L)
+{
+    gm_mat3_push(L);
+    return 1;
+}
+
+static int gm_mat3_lua_tostring(lua_State *L)
+{
+    const double *m = gm_mat3_check(L, 1)->m;
+    lua_pushfstring(L, "mat3(%f, %f, %f, %f, %f, %f)", m[0], m[1], m[2], m[3], m[4], m[5]);
+    return 1;
+}
+
+static int gm_mat3_lua_identity(lua_State *L)
+{
+    memcpy(gm_mat3_check(L, 1)->m, gm_mat3_identity, sizeof(gm_mat3_identity));
+    return gm_vec_self(L);
+}
+
+// m:set(a, b, c, d, e, f) or m:set(n), x' = a x + b y + c, y' = d x + e y + f
+static int gm_mat3_lua_set(lua_State *L)
+{
+    gm_mat3_t *m = gm_mat3_check(L, 1);
+    const gm_mat3_t *n = (const gm_mat3_t *)luaL_testudata(L, 2, GM_MAT3_MT);
+    if (n)
+    {
+        memcpy(m->m, n->m, sizeof(m->m));
+    }
+    else
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            m->m[i] = luaL_checknumber(L, 2 + i);
+        }
+        m->m[6] = 0.0;
+        m->m[7] = 0.0;
+        m->m[8] = 1.0;
+    }
+    return gm_vec_self(L);
+}
+
+// translate, rotate and scale multiply on the right: the last one applied is
+// the first to act on a point, as with nested transforms
+static int gm_mat3_lua_translate(lua_State *L)
+{
+    double *m = gm_mat3_check(L, 1)->m;
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    m[2] += m[0] * x + m[1] * y;
+    m[5] += m[3] * x + m[4] * y;
+    return gm_vec_self(L);
+}
+
+static int gm_mat3_lua_rotate(lua_State *L)
+{
+    double *m = gm_mat3_check(L, 1)->m;
+    double a = luaL_checknumber(L, 2);
+    double c = SDL_cos(a), s = SDL_sin(a);
+    double r[9] = {c, -s, 0, s, c, 0, 0, 0, 1};
+    gm_mat3_mul(m, m, r);
+    return gm_vec_self(L);
+}
+
+// m:scale(s) or m:scale(sx, sy)
+static int gm_mat3_lua_scale(lua_State *L)
+{
+    double *m = gm_mat3_check(L, 1)->m;
+    double sx = luaL_checknumber(L, 2);
+    double sy = luaL_optnumber(L, 3, sx);
+    m[0] *= sx;
+    m[3] *= sx;
+    m[1] *= sy;
+    m[4] *= sy;
+    return gm_vec_self(L);
+}
+
+// m:mul(a) sets m = m * a, m:mul(a, b) sets m = a * b
+static int gm_mat3_lua_mul(lua_State *L)
+{
+    gm_mat3_t *m = gm_mat3_check(L, 1);
+    const gm_mat3_t *a = gm_mat3_check(L, 2);
+    if (lua_isnoneornil(L, 3))
+    {
+        gm_mat3_mul(m->m, m->m, a->m);
+    }
+    else
+    {
+        gm_mat3_mul(m->m, a->m, gm_mat3_check(L, 3)->m);
+    }
+    return gm_vec_self(L);
+}
+
+// m:invert() returns m, or nil and leaves m alone if it cannot be inverted
+static int gm_mat3_lua_invert(lua_State *L)
+{
+    double *m = gm_mat3_check(L, 1)->m;
+    double det = m[0] * m[4] - m[1] * m[3];
+    if (SDL_fabs(det) < 1e-12)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    double r[9] = {
+        m[4] / det, -m[1] / det, (m[1] * m[5] - m[2] * m[4]) / det,
+        -m[3] / det, m[0] / det, (m[2] * m[3] - m[0] * m[5]) / det,
+        0, 0, 1};
+    memcpy(m, r, sizeof(r));
+    return gm_vec_self(L);
+}
+
+// m:apply(x, y) or m:apply(v) returns the transformed point as two numbers
+static int gm_mat3_lua_apply(lua_State *L)
+{
+    const double *m = gm_mat3_check(L, 1)->m;
+    double x, y;
+    gm_vec2_check_xy(L, 2, &x, &y);
+    lua_pushnumber(L, m[0] * x + m[1] * y + m[2]);
+    lua_pushnumber(L, m[3] * x + m[4] * y + m[5]);
+    return 2;
+}
+
+// Transforms n points stored as x, y pairs from src into dst, which may be the same block.
+#define GM_MAT3_POINTS(TS, TD)                                              \
+    do                                                                      \
+    {                                                                       \
+        const TS *s = (const TS *)src->data;                                \
+        TD *d = (TD *)dst->data;                                            \
+        for (size_t i = 0; i < n; i++)                                      \
+        {                                                                   \
+            double x = (double)s[i * 2], y = (double)s[i * 2 + 1];          \
+            d[i * 2] = (TD)(m[0] * x + m[1] * y + m[2]);                    \
+            d[i * 2 + 1] = (TD)(m[3] * x + m[4] * y + m[5]);                \
+        }                                                                   \
+    } while (0)
+
+// m:transformPoints(src [, dst]) transforms a 2 x n f32 or f64 array of points,
+// one point per row, in place or into dst
+static int gm_mat3_lua_transform_points(lua_State *L)
+{
+    const double *m = gm_mat3_check(L, 1)->m;
+    gm_array_t *src = gm_array_check(L, 2);
+    gm_array_t *dst = lua_isnoneornil(L, 3) ? src : gm_array_check(L, 3);
+    luaL_argcheck(L, src->w == 2, 2, "points must be a 2 x n array");
+    luaL_argcheck(L, src->type == GM_ARRAY_F32 || src->type == GM_ARRAY_F64, 2, "points must be f32 or f64");
+    luaL_argcheck(L, dst->w == 2 && dst->h == src->h, 3, "arrays differ in size");
+    luaL_argcheck(L, dst->type == GM_ARRAY_F32 || dst->type == GM_ARRAY_F64, 3, "points must be f32 or f64");
+
+    size_t n = (size_t)src->h;
+    if (src->type == GM_ARRAY_F32)
+    {
+        if (dst->type == GM_ARRAY_F32)
+        {
+            GM_MAT3_POINTS(float, float);
+        }
+        else
+        {
+            GM_MAT3_POINTS(float, double);
+        }
+    }
+    else
+    {
+        if (dst->type == GM_ARRAY_F32)
+        {
+            GM_MAT3_POINTS(double, float);
+        }
+        else
+        {
+            GM_MAT3_POINTS(double, double);
+        }
+    }
+    lua_pushvalue(L, dst == src ? 2 : 3);
+    return 1;
+}
+
+static int gm_mat3_lua_clone(lua_State *L)
+{
+    const gm_mat3_t *m = gm_mat3_check(L, 1);
+    memcpy(gm_mat3_push(L)->m, m->m, sizeof(m->m));
+    return 1;
+}
+
+// m:unpack() returns a, b, c, d, e, f as taken by m:set
+static int gm_mat3_lua_unpack(lua_State *L)
+{
+    const double *m = gm_mat3_check(L, 1)->m;
+    for (int i = 0; i < 6; i++)
+    {
+        lua_pushnumber(L, m[i]);
+    }
+    return 6;
+}
+
+void gm_vec_register_lua(lua_State *L)
+{
+    static const luaL_Reg vec2_methods[] = {
+        {"set", gm_vec2_lua_set},
+        {"add", gm_vec2_lua_add},
+        {"sub", gm_vec2_lua_sub},
+        {"mul", gm_vec2_lua_mul},
+        {"scale", gm_vec2_lua_scale},
+        {"addScaled", gm_vec2_lua_add_scaled},
+        {"lerp", gm_vec2_lua_lerp},
+        {"normalize", gm_vec2_lua_normalize},
+        {"limit", gm_vec2_lua_limit},
+        {"rotate", gm_vec2_lua_rotate},
+        {"perp", gm_vec2_lua_perp},
+        {"transform", gm_vec2_lua_transform},
+        {"clone", gm_vec2_lua_clone},
+        {"unpack", gm_vec2_lua_unpack},
+        {"len", gm_vec2_lua_len},
+        {"len2", gm_vec2_lua_len2},
+        {"angle", gm_vec2_lua_angle},
+        {"dot", gm_vec2_lua_dot},
+        {"cross", gm_vec2_lua_cross},
+        {"dist", gm_vec2_lua_dist},
+        {"dist2", gm_vec2_lua_dist2},
+        {NULL, NULL}};
+    static const luaL_Reg mat3_methods[] = {
+        {"identity", gm_mat3_lua_identity},
+        {"set", gm_mat3_lua_set},
+        {"translate", gm_mat3_lua_translate},
+        {"rotate", gm_mat3_lua_rotate},
+        {"scale", gm_mat3_lua_scale},
+        {"mul", gm_mat3_lua_mul},
+        {"invert", gm_mat3_lua_invert},
+        {"apply", gm_mat3_lua_apply},
+        {"transformPoints", gm_mat3_lua_transform_points},
+        {"clone", gm_mat3_lua_clone},
+        {"unpack", gm_mat3_lua_unpack},
+        {NULL, NULL}};
+    static const luaL_Reg funcs[] = {
+        {"vec2", gm_vec2_lua_new},
+        {"mat3", gm_mat3_lua_new},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_VEC2_MT);
+    luaL_newlib(L, vec2_methods);
+    lua_pushcclosure(L, gm_vec2_lua_index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, gm_vec2_lua_newindex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pushcfunction(L, gm_vec2_lua_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, gm_vec2_lua_eq);
+    lua_setfield(L, -2, "__eq");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, GM_MAT3_MT);
+    luaL_newlib(L, mat3_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, gm_mat3_lua_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    luaL_setfuncs(L, funcs, 0);
+    lua_pop(L, 1);
+}
@@ -0,0 +1,29 @@
+#ifndef __GM_VEC_H__
+#define __GM_VEC_H__
+
+#include <lua.h>
+
+#define GM_VEC2_MT "gm.vec2"
+#define GM_MAT3_MT "gm.mat3"
+
+// Lua userdata behind gm.vec2, changed in place by its methods
+typedef struct
+{
+    double x;
+    double y;
+} gm_vec2_t;
+
+// Lua userdata behind gm.mat3, a 2D affine transform stored row major.
+// The last row is kept at 0 0 1, so points transform without a divide.
+typedef struct
+{
+    double m[9];
+} gm_mat3_t;
+
+gm_vec2_t *gm_vec2_push(lua_State *L, double x, double y);
+gm_mat3_t *gm_mat3_push(lua_State *L);
+
+// Adds gm.vec2 and gm.mat3 to the game API, needs no renderer.
+void gm_vec_register_lua(lua_State *L);
+
+#endif // __GM_VEC_H__
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#include "gm_watchdog.h"
+#include "gm_lua.h"
+
+static void gm_watchdog_hook(lua_State *L, void *userdata)
+{
+    gm_watchdog_t *wd = (gm_watchdog_t *)userdata;
+    if (!wd->armed || SDL_GetTicksNS() - wd->start_ns < (uint64_t)wd->budget_ms * SDL_NS_PER_MS)
+    {
+        return;
+    }
+
+    // stays armed, so a script catching the error with pcall is interrupted again
+    wd->trips++;
+    // level 0 is the interrupted function, luaL_error would name its caller instead
+    luaL_traceback(L, L, NULL, 0);
+    lua_pushfstring(L, "watchdog: %s ran for more than %d ms\n%s", wd->phase, wd->budget_ms, lua_tostring(L, -1));
+    lua_error(L);
+}
+
+int gm_watchdog_init(gm_watchdog_t **watchdog, gm_hook_t *hook, int budget_ms)
+{
+    (*watchdog) = (gm_watchdog_t *)calloc(sizeof(gm_watchdog_t), 1);
+    if ((*watchdog) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_watchdog_t.\n");
+        return 1;
+    }
+
+    gm_watchdog_t *wd = (*watchdog);
+    wd->hook = hook;
+    wd->hook_id = gm_hook_add(hook, gm_watchdog_hook, wd);
+    if (wd->hook_id < 0)
+    {
+        free(wd);
+        (*watchdog) = NULL;
+        return 1;
+    }
+    gm_watchdog_set_budget(wd, budget_ms);
+    return 0;
+}
+
+void gm_watchdog_shutdown(gm_watchdog_t *watchdog)
+{
+    if (watchdog)
+    {
+        gm_hook_enable(watchdog->hook, watchdog->hook_id, false);
+        free(watchdog);
+    }
+}
+
+void gm_watchdog_set_budget(gm_watchdog_t *watchdog, int budget_ms)
+{
+    watchdog->budget_ms = budget_ms;
+    gm_hook_enable(watchdog->hook, watchdog->hook_id, budget_ms > 0);
+}
+
+void gm_watchdog_arm(gm_watchdog_t *watchdog, const char *phase)
+{
+    watchdog->phase = phase;
+    watchdog->start_ns = SDL_GetTicksNS();
+    watchdog->armed = true;
+}
+
+void gm_watchdog_disarm(gm_watchdog_t *watchdog)
+{
+    watchdog->armed = false;
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings
+//----------------------------------------------------------------------------
+
+static gm_watchdog_t *gm_watchdog_upvalue(lua_State *L)
+{
+    return (gm_watchdog_t *)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// gm.watchdog([ms]) sets the time draw and tasks may run before they are stopped, 0 turns
+// it off. It applies to the running frame too. Returns the budget that was in place.
+static int gm_watchdog_lua_budget(lua_State *L)
+{
+    gm_watchdog_t *wd = gm_watchdog_upvalue(L);
+    int previous = wd->budget_ms;
+    if (!lua_isnoneornil(L, 1))
+    {
+        lua_Integer ms = luaL_checkinteger(L, 1);
+        luaL_argcheck(L, ms >= 0 && ms <= GM_WATCHDOG_MAX_MS, 1, "budget out of range");
+        gm_watchdog_set_budget(wd, (int)ms);
+    }
+    lua_pushinteger(L, previous);
+    return 1;
+}
+
+void gm_watchdog_register_lua(gm_watchdog_t *watchdog, lua_State *L)
+{
+    static const luaL_Reg funcs[] = {
+        {"watchdog", gm_watchdog_lua_budget},
+        {NULL, NULL}};
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, watchdog);
+    luaL_setfuncs(L, funcs, 1);
+    lua_pop(L, 1);
+}
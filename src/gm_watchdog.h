@@ -0,0 +1,44 @@
+#ifndef __GM_WATCHDOG_H__
+#define __GM_WATCHDOG_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <lua.h>
+
+#include "gm_hook.h"
+
+#define GM_WATCHDOG_DEFAULT_MS 1000
+#define GM_WATCHDOG_MAX_MS 600000
+
+// Stops Lua code that runs for too long. While armed, the shared hook checks the
+// clock every GM_HOOK_COUNT instructions and raises an error with a stack trace
+// once the budget is used up, so a stuck draw or task fails like any other error.
+typedef struct
+{
+    gm_hook_t *hook;
+    int hook_id;
+
+    // 0 when the watchdog is off
+    int budget_ms;
+
+    // what is running, for the error message
+    const char *phase;
+    uint64_t start_ns;
+    bool armed;
+
+    uint64_t trips;
+} gm_watchdog_t;
+
+int gm_watchdog_init(gm_watchdog_t **watchdog, gm_hook_t *hook, int budget_ms);
+void gm_watchdog_shutdown(gm_watchdog_t *watchdog);
+
+// Gives the Lua code run until gm_watchdog_disarm budget_ms from now, phase names it in the error.
+void gm_watchdog_arm(gm_watchdog_t *watchdog, const char *phase);
+void gm_watchdog_disarm(gm_watchdog_t *watchdog);
+
+void gm_watchdog_set_budget(gm_watchdog_t *watchdog, int budget_ms);
+
+// Adds gm.watchdog(ms) to the game API.
+void gm_watchdog_register_lua(gm_watchdog_t *watchdog, lua_State *L);
+
+#endif // __GM_WATCHDOG_H__
@@ -0,0 +1,866 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "gm_worker.h"
+#include "gm_array.h"
+#include "gm_bytecode.h"
+#include "gm_lua.h"
+#include "gm_trace.h"
+#include "gm_vec.h"
+#include "gm_util.h"
+
+// value tags in a serialized message
+enum
+{
+    GM_WORKER_NIL,
+    GM_WORKER_FALSE,
+    GM_WORKER_TRUE,
+    GM_WORKER_INT,
+    GM_WORKER_NUM,
+    GM_WORKER_STR,
+    GM_WORKER_TABLE,
+    GM_WORKER_END,
+    GM_WORKER_ARRAY
+};
+
+// Lua userdata behind gm.worker, holds one reference to the worker
+typedef struct
+{
+    gm_worker_t *worker;
+} gm_worker_ref_t;
+
+//----------------------------------------------------------------------------
+// Messages
+//----------------------------------------------------------------------------
+
+static void gm_worker_msg_free(gm_worker_msg_t *msg)
+{
+    if (msg)
+    {
+        // blocks that were never received are still owned by the message
+        for (int i = 0; i < msg->array_count; i++)
+        {
+            free(msg->arrays[i]);
+        }
+        free(msg->arrays);
+        free(msg->data);
+        free(msg);
+    }
+}
+
+static bool gm_worker_msg_write(gm_worker_msg_t *msg, const void *src, size_t size)
+{
+    if (msg->size + size > msg->capacity)
+    {
+        size_t capacity = msg->capacity ? msg->capacity : 256;
+        while (capacity < msg->size + size)
+        {
+            capacity *= 2;
+        }
+        uint8_t *data = (uint8_t *)realloc(msg->data, capacity);
+        if (data == NULL)
+        {
+            return false;
+        }
+        msg->data = data;
+        msg->capacity = capacity;
+    }
+    memcpy(msg->data + msg->size, src, size);
+    msg->size += size;
+    return true;
+}
+
+static bool gm_worker_msg_tag(gm_worker_msg_t *msg, uint8_t tag)
+{
+    return gm_worker_msg_write(msg, &tag, 1);
+}
+
+// Serializes the value at idx, raises a Lua error on values that cannot be sent.
+static void gm_worker_encode(lua_State *L, int idx, gm_worker_msg_t *msg, gm_array_t **handoff, int depth)
+{
+    bool ok = true;
+    idx = lua_absindex(L, idx);
+    switch (lua_type(L, idx))
+    {
+    case LUA_TNIL:
+        ok = gm_worker_msg_tag(msg, GM_WORKER_NIL);
+        break;
+    case LUA_TBOOLEAN:
+        ok = gm_worker_msg_tag(msg, lua_toboolean(L, idx) ? GM_WORKER_TRUE : GM_WORKER_FALSE);
+        break;
+    case LUA_TNUMBER:
+        if (lua_isinteger(L, idx))
+        {
+            lua_Integer v = lua_tointeger(L, idx);
+            ok = gm_worker_msg_tag(msg, GM_WORKER_INT) && gm_worker_msg_write(msg, &v, sizeof(v));
+        }
+        else
+        {
+            lua_Number v = lua_tonumber(L, idx);
+            ok = gm_worker_msg_tag(msg, GM_WORKER_NUM) && gm_worker_msg_write(msg, &v, sizeof(v));
+        }
+        break;
+    case LUA_TSTRING:
+    {
+        size_t len = 0;
+        const char *s = lua_tolstring(L, idx, &len);
+        ok = gm_worker_msg_tag(msg, GM_WORKER_STR) && gm_worker_msg_write(msg, &len, sizeof(len)) &&
+             gm_worker_msg_write(msg, s, len);
+        break;
+    }
+    case LUA_TTABLE:
+        if (depth >= GM_WORKER_MAX_DEPTH)
+        {
+            luaL_error(L, "message nested deeper than %d tables", GM_WORKER_MAX_DEPTH);
+        }
+        luaL_checkstack(L, 3, "message too deep");
+        ok = gm_worker_msg_tag(msg, GM_WORKER_TABLE);
+        lua_pushnil(L);
+        while (ok && lua_next(L, idx) != 0)
+        {
+            gm_worker_encode(L, -2, msg, handoff, depth + 1);
+            gm_worker_encode(L, -1, msg, handoff, depth + 1);
+            lua_pop(L, 1);
+        }
+        ok = ok && gm_worker_msg_tag(msg, GM_WORKER_END);
+        break;
+    case LUA_TUSERDATA:
+    {
+        // typed arrays change hands without a copy, the sender's array is emptied on success
+        gm_array_t *arr = (gm_array_t *)luaL_testudata(L, idx, GM_ARRAY_MT);
+        if (arr == NULL || arr->data == NULL)
+        {
+            luaL_error(L, "cannot send a %s", arr ? "handed off array" : luaL_typename(L, idx));
+        }
+        for (int i = 0; i < msg->array_count; i++)
+        {
+            if (handoff[i] == arr)
+            {
+                luaL_error(L, "cannot send the same array twice in one message");
+            }
+        }
+        if (msg->array_count == GM_WORKER_MAX_ARRAYS)
+        {
+            luaL_error(L, "more than %d arrays in one message", GM_WORKER_MAX_ARRAYS);
+        }
+        void **arrays = (void **)realloc(msg->arrays, sizeof(void *) * (size_t)(msg->array_count + 1));
+        if (arrays == NULL)
+        {
+            luaL_error(L, "out of memory encoding a message");
+        }
+        msg->arrays = arrays;
+
+        uint8_t type = (uint8_t)arr->type;
+        int32_t dims[2] = {arr->w, arr->h};
+        int32_t slot = msg->array_count;
+        ok = gm_worker_msg_tag(msg, GM_WORKER_ARRAY) && gm_worker_msg_write(msg, &type, 1) &&
+             gm_worker_msg_write(msg, dims, sizeof(dims)) && gm_worker_msg_write(msg, &slot, sizeof(slot));
+        if (ok)
+        {
+            // the block is not owned by the message until the whole value is encoded
+            handoff[msg->array_count] = arr;
+            msg->arrays[msg->array_count] = NULL;
+            msg->array_count++;
+        }
+        break;
+    }
+    default:
+        luaL_error(L, "cannot send a %s", luaL_typename(L, idx));
+        break;
+    }
+
+    if (!ok)
+    {
+        luaL_error(L, "out of memory encoding a message");
+    }
+}
+
+static int gm_worker_encode_protected(lua_State *L)
+{
+    gm_worker_msg_t *msg = (gm_worker_msg_t *)lua_touserdata(L, 2);
+    gm_array_t **handoff = (gm_array_t **)lua_touserdata(L, 3);
+    gm_worker_encode(L, 1, msg, handoff, 0);
+    return 0;
+}
+
+// Moves the value at idx into a new message, raises a Lua error if it cannot be sent.
+static gm_worker_msg_t *gm_worker_pack(lua_State *L, int idx)
+{
+    gm_worker_msg_t *msg = (gm_worker_msg_t *)calloc(sizeof(gm_worker_msg_t), 1);
+    gm_array_t *handoff[GM_WORKER_MAX_ARRAYS];
+    if (msg == NULL)
+    {
+        luaL_error(L, "out of memory encoding a message");
+    }
+
+    // encode under pcall, so a bad value frees the partial message instead of leaking it
+    lua_pushcfunction(L, gm_worker_encode_protected);
+    lua_pushvalue(L, idx);
+    lua_pushlightuserdata(L, msg);
+    lua_pushlightuserdata(L, handoff);
+    if (lua_pcall(L, 3, 0, 0) != LUA_OK)
+    {
+        gm_worker_msg_free(msg);
+        lua_error(L);
+    }
+
+    // success: the message takes over the array blocks
+    for (int i = 0; i < msg->array_count; i++)
+    {
+        msg->arrays[i] = handoff[i]->data;
+        handoff[i]->data = NULL;
+    }
+    return msg;
+}
+
+typedef struct
+{
+    const gm_worker_msg_t *msg;
+    size_t pos;
+    bool *taken;
+} gm_worker_reader_t;
+
+static bool gm_worker_read(gm_worker_reader_t *r, void *dst, size_t size)
+{
+    if (r->pos + size > r->msg->size)
+    {
+        return false;
+    }
+    memcpy(dst, r->msg->data + r->pos, size);
+    r->pos += size;
+    return true;
+}
+
+// Pushes the next value of the message onto L.
+static void gm_worker_decode(lua_State *L, gm_worker_reader_t *r)
+{
+    luaL_checkstack(L, 4, "message too deep");
+    uint8_t tag = GM_WORKER_END;
+    gm_worker_read(r, &tag, 1);
+    switch (tag)
+    {
+    case GM_WORKER_NIL:
+        lua_pushnil(L);
+        break;
+    case GM_WORKER_FALSE:
+    case GM_WORKER_TRUE:
+        lua_pushboolean(L, tag == GM_WORKER_TRUE);
+        break;
+    case GM_WORKER_INT:
+    {
+        lua_Integer v = 0;
+        gm_worker_read(r, &v, sizeof(v));
+        lua_pushinteger(L, v);
+        break;
+    }
+    case GM_WORKER_NUM:
+    {
+        lua_Number v = 0;
+        gm_worker_read(r, &v, sizeof(v));
+        lua_pushnumber(L, v);
+        break;
+    }
+    case GM_WORKER_STR:
+    {
+        size_t len = 0;
+        gm_worker_read(r, &len, sizeof(len));
+        lua_pushlstring(L, (const char *)r->msg->data + r->pos, len);
+        r->pos += len;
+        break;
+    }
+    case GM_WORKER_TABLE:
+        lua_newtable(L);
+        while (r->pos < r->msg->size && r->msg->data[r->pos] != GM_WORKER_END)
+        {
+            gm_worker_decode(L, r);
+            gm_worker_decode(L, r);
+            if (lua_isnil(L, -2))
+            {
+                lua_pop(L, 2);
+                continue;
+            }
+            lua_rawset(L, -3);
+        }
+        r->pos++;
+        break;
+    case GM_WORKER_ARRAY:
+    {
+        uint8_t type = 0;
+        int32_t dims[2] = {0, 0};
+        int32_t slot = 0;
+        gm_worker_read(r, &type, 1);
+        gm_worker_read(r, dims, sizeof(dims));
+        gm_worker_read(r, &slot, sizeof(slot));
+        if (gm_array_push(L, (gm_array_type_t)type, dims[0], dims[1], r->msg->arrays[slot]) != NULL)
+        {
+            r->taken[slot] = true;
+        }
+        break;
+    }
+    default:
+        lua_pushnil(L);
+        break;
+    }
+}
+
+static int gm_worker_decode_protected(lua_State *L)
+{
+    gm_worker_reader_t *r = (gm_worker_reader_t *)lua_touserdata(L, 1);
+    gm_worker_decode(L, r);
+    return 1;
+}
+
+// Pushes the message's value, or nothing and false if Lua ran out of memory.
+// The message is freed either way; array blocks already pushed belong to L.
+static bool gm_worker_unpack(lua_State *L, gm_worker_msg_t *msg)
+{
+    bool taken[GM_WORKER_MAX_ARRAYS] = {false};
+    gm_worker_reader_t r = {msg, 0, taken};
+
+    lua_pushcfunction(L, gm_worker_decode_protected);
+    lua_pushlightuserdata(L, &r);
+    bool ok = lua_pcall(L, 1, 1, 0) == LUA_OK;
+    if (!ok)
+    {
+        SDL_Log("could not decode a worker message: %s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+
+    for (int i = 0; i < msg->array_count; i++)
+    {
+        if (taken[i])
+        {
+            msg->arrays[i] = NULL;
+        }
+    }
+    gm_worker_msg_free(msg);
+    return ok;
+}
+
+static void gm_worker_queue_push(gm_worker_queue_t *q, gm_worker_msg_t *msg)
+{
+    msg->next = NULL;
+    if (q->tail)
+    {
+        q->tail->next = msg;
+    }
+    else
+    {
+        q->head = msg;
+    }
+    q->tail = msg;
+    q->count++;
+}
+
+static gm_worker_msg_t *gm_worker_queue_pop(gm_worker_queue_t *q)
+{
+    gm_worker_msg_t *msg = q->head;
+    if (msg)
+    {
+        q->head = msg->next;
+        if (q->head == NULL)
+        {
+            q->tail = NULL;
+        }
+        q->count--;
+    }
+    return msg;
+}
+
+static void gm_worker_queue_clear(gm_worker_queue_t *q)
+{
+    gm_worker_msg_t *msg;
+    while ((msg = gm_worker_queue_pop(q)) != NULL)
+    {
+        gm_worker_msg_free(msg);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Workers
+//----------------------------------------------------------------------------
+
+static void gm_worker_release(gm_worker_t *w)
+{
+    if (SDL_AddAtomicInt(&w->refs, -1) == 1)
+    {
+        gm_worker_queue_clear(&w->inbox);
+        gm_worker_queue_clear(&w->outbox);
+        SDL_DestroyMutex(w->lock);
+        free(w);
+    }
+}
+
+static void gm_worker_set_error(gm_worker_t *w, const char *msg)
+{
+    SDL_Log("worker %s: %s\n", w->path, msg);
+    SDL_LockMutex(w->lock);
+    SDL_strlcpy(w->error, msg, sizeof(w->error));
+    SDL_UnlockMutex(w->lock);
+}
+
+// Queues the worker on the pool unless it is already queued or running.
+static void gm_worker_schedule(gm_worker_t *w)
+{
+    if (!SDL_CompareAndSwapAtomicInt(&w->scheduled, 0, 1))
+    {
+        return;
+    }
+
+    gm_worker_pool_t *pool = w->pool;
+    SDL_LockMutex(pool->lock);
+    w->next_run = NULL;
+    if (pool->run_tail)
+    {
+        pool->run_tail->next_run = w;
+    }
+    else
+    {
+        pool->run_head = w;
+    }
+    pool->run_tail = w;
+    SDL_SignalCondition(pool->wake);
+    SDL_UnlockMutex(pool->lock);
+}
+
+// gm.send(value) inside a worker, queues a message for the main state
+static int gm_worker_lua_post(lua_State *L)
+{
+    gm_worker_t *w = (gm_worker_t *)lua_touserdata(L, lua_upvalueindex(1));
+    luaL_checkany(L, 1);
+    gm_worker_msg_t *msg = gm_worker_pack(L, 1);
+    SDL_LockMutex(w->lock);
+    gm_worker_queue_push(&w->outbox, msg);
+    SDL_UnlockMutex(w->lock);
+    return 0;
+}
+
+// Count hook of every worker state, coroutines inherit it along with the extra space.
+static void gm_worker_hook(lua_State *L, lua_Debug *ar)
+{
+    (void)ar;
+    gm_worker_t *w = *(gm_worker_t **)lua_getextraspace(L);
+    if (SDL_GetAtomicInt(&w->pool->stopping))
+    {
+        luaL_error(L, "worker stopped, the game is shutting down");
+    }
+    if (SDL_GetAtomicInt(&w->closing))
+    {
+        luaL_error(L, "worker stopped, it was closed");
+    }
+}
+
+static bool gm_worker_load(gm_worker_t *w)
+{
+    lua_State *L = luaL_newstate();
+    if (L == NULL)
+    {
+        gm_worker_set_error(w, "failed to create Lua state");
+        return false;
+    }
+    w->L = L;
+    *(gm_worker_t **)lua_getextraspace(L) = w;
+    lua_sethook(L, gm_worker_hook, LUA_MASKCOUNT, GM_WORKER_HOOK_COUNT);
+
+    // the same libraries as the game state
+    luaL_requiref(L, "_G", luaopen_base, 1);
+    luaL_requiref(L, LUA_MATHLIBNAME, luaopen_math, 1);
+    luaL_requiref(L, LUA_TABLIBNAME, luaopen_table, 1);
+    luaL_requiref(L, LUA_COLIBNAME, luaopen_coroutine, 1);
+    lua_pop(L, 4);
+    gm_lua_open_package(L, w->pool->pack);
+
+    // gm is a plain table here, with typed arrays, vector maths and gm.send
+    luaL_newmetatable(L, GM_GAME_MT);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -3, "__index");
+    lua_pushlightuserdata(L, w);
+    lua_pushcclosure(L, gm_worker_lua_post, 1);
+    lua_setfield(L, -2, "send");
+    lua_setglobal(L, "gm");
+    lua_pop(L, 1);
+    gm_array_register_lua(NULL, L);
+    gm_vec_register_lua(L);
+
+    int status;
+    size_t size = 0;
+    const char *packed = file_exists(w->path) ? NULL : (const char *)gm_pack_find(w->pool->pack, w->path, &size);
+    if (packed)
+    {
+        char chunk_name[300];
+        SDL_snprintf(chunk_name, sizeof(chunk_name), "@%s", w->path);
+        status = luaL_loadbufferx(L, packed, size, chunk_name, "b");
+    }
+    else
+    {
+        status = gm_bytecode_load(L, w->path);
+    }
+    if (status != LUA_OK || lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        gm_worker_set_error(w, lua_tostring(L, -1));
+        return false;
+    }
+    return true;
+}
+
+static void gm_worker_deliver(gm_worker_t *w, gm_worker_msg_t *msg)
+{
+    lua_State *L = w->L;
+    lua_getglobal(L, "onMessage");
+    if (!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        gm_worker_msg_free(msg);
+        gm_worker_set_error(w, "script must define onMessage(msg)");
+        return;
+    }
+    if (!gm_worker_unpack(L, msg))
+    {
+        lua_pop(L, 1);
+        return;
+    }
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+    {
+        gm_worker_set_error(w, lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+}
+
+// Runs on a pool thread, handles up to GM_WORKER_BATCH messages.
+// Returns true if the worker must go back on the run queue.
+static bool gm_worker_step(gm_worker_t *w)
+{
+    for (int handled = 0;; handled++)
+    {
+        if (SDL_GetAtomicInt(&w->closing))
+        {
+            if (w->L)
+            {
+                lua_close(w->L);
+                w->L = NULL;
+            }
+            gm_worker_release(w);
+            return false;
+        }
+        if (handled == GM_WORKER_BATCH)
+        {
+            return true;
+        }
+
+        if (!w->loaded)
+        {
+            w->loaded = true;
+            w->failed = !gm_worker_load(w);
+        }
+
+        SDL_LockMutex(w->lock);
+        gm_worker_msg_t *msg = gm_worker_queue_pop(&w->inbox);
+        SDL_UnlockMutex(w->lock);
+        if (msg)
+        {
+            uint64_t span = gm_trace_begin();
+            if (w->failed)
+            {
+                gm_worker_msg_free(msg);
+            }
+            else
+            {
+                gm_worker_deliver(w, msg);
+            }
+            gm_trace_end(w->path, span);
+            continue;
+        }
+
+        // idle, unless a message or a close slipped in after the queue was found empty
+        SDL_SetAtomicInt(&w->scheduled, 0);
+        SDL_LockMutex(w->lock);
+        bool more = w->inbox.count > 0;
+        SDL_UnlockMutex(w->lock);
+        if ((more || SDL_GetAtomicInt(&w->closing)) && SDL_CompareAndSwapAtomicInt(&w->scheduled, 0, 1))
+        {
+            continue;
+        }
+        return false;
+    }
+}
+
+static int gm_worker_thread(void *data)
+{
+    gm_worker_pool_t *pool = (gm_worker_pool_t *)data;
+    gm_trace_thread_name("lua worker");
+    for (;;)
+    {
+        SDL_LockMutex(pool->lock);
+        while (pool->run_head == NULL && !pool->quit)
+        {
+            SDL_WaitCondition(pool->wake, pool->lock);
+        }
+
+        // pending work is finished before quitting, so closing workers are freed
+        gm_worker_t *w = pool->run_head;
+        if (w == NULL)
+        {
+            SDL_UnlockMutex(pool->lock);
+            break;
+        }
+        pool->run_head = w->next_run;
+        if (pool->run_head == NULL)
+        {
+            pool->run_tail = NULL;
+        }
+        SDL_UnlockMutex(pool->lock);
+
+        if (gm_worker_step(w))
+        {
+            // back of the line, still marked scheduled
+            SDL_LockMutex(pool->lock);
+            w->next_run = NULL;
+            if (pool->run_tail)
+            {
+                pool->run_tail->next_run = w;
+            }
+            else
+            {
+                pool->run_head = w;
+            }
+            pool->run_tail = w;
+            SDL_UnlockMutex(pool->lock);
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Pool
+//----------------------------------------------------------------------------
+
+int gm_worker_pool_init(gm_worker_pool_t **pool, const gm_pack_t *pack)
+{
+    (*pool) = (gm_worker_pool_t *)calloc(sizeof(gm_worker_pool_t), 1);
+    if ((*pool) == NULL)
+    {
+        SDL_Log("Unable to allocate memory for gm_worker_pool_t.\n");
+        return 1;
+    }
+
+    (*pool)->pack = pack;
+    (*pool)->lock = SDL_CreateMutex();
+    (*pool)->wake = SDL_CreateCondition();
+    if ((*pool)->lock == NULL || (*pool)->wake == NULL)
+    {
+        SDL_Log("Could not create the worker pool lock: %s\n", SDL_GetError());
+        return 1;
+    }
+    return 0;
+}
+
+static bool gm_worker_pool_start(gm_worker_pool_t *pool)
+{
+    if (pool->thread_count > 0)
+    {
+        return true;
+    }
+
+    // one core stays with the main thread
+    int count = SDL_clamp(SDL_GetNumLogicalCPUCores() - 1, 1, GM_WORKER_MAX_THREADS);
+    for (int i = 0; i < count; i++)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "gm_worker_%d", i);
+        pool->threads[pool->thread_count] = SDL_CreateThread(gm_worker_thread, name, pool);
+        if (pool->threads[pool->thread_count] == NULL)
+        {
+            SDL_Log("Could not start worker thread %d: %s\n", i, SDL_GetError());
+            break;
+        }
+        pool->thread_count++;
+    }
+    return pool->thread_count > 0;
+}
+
+void gm_worker_pool_shutdown(gm_worker_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    if (pool->lock)
+    {
+        SDL_SetAtomicInt(&pool->stopping, 1);
+        SDL_LockMutex(pool->lock);
+        pool->quit = true;
+        SDL_BroadcastCondition(pool->wake);
+        SDL_UnlockMutex(pool->lock);
+    }
+    for (int i = 0; i < pool->thread_count; i++)
+    {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+    if (pool->wake)
+    {
+        SDL_DestroyCondition(pool->wake);
+    }
+    if (pool->lock)
+    {
+        SDL_DestroyMutex(pool->lock);
+    }
+    free(pool);
+}
+
+//----------------------------------------------------------------------------
+// Lua bindings, main state side
+//----------------------------------------------------------------------------
+
+static gm_worker_t *gm_worker_check(lua_State *L, int idx)
+{
+    gm_worker_ref_t *ref = (gm_worker_ref_t *)luaL_checkudata(L, idx, GM_WORKER_MT);
+    luaL_argcheck(L, ref->worker != NULL, idx, "worker has been released");
+    return ref->worker;
+}
+
+static void gm_worker_close(gm_worker_t *w)
+{
+    if (SDL_CompareAndSwapAtomicInt(&w->closing, 0, 1))
+    {
+        // a queued or running worker sees the flag itself, otherwise queue it to close
+        gm_worker_schedule(w);
+    }
+}
+
+// gm.worker(path), starts path in a new Lua state on the worker pool
+static int gm_worker_lua_new(lua_State *L)
+{
+    gm_worker_pool_t *pool = (gm_worker_pool_t *)lua_touserdata(L, lua_upvalueindex(1));
+    const char *path = luaL_checkstring(L, 1);
+    luaL_argcheck(L, SDL_strlen(path) < sizeof(((gm_worker_t *)NULL)->path), 1, "path too long");
+    if (!gm_worker_pool_start(pool))
+    {
+        return luaL_error(L, "could not start the worker threads");
+    }
+
+    gm_worker_ref_t *ref = (gm_worker_ref_t *)lua_newuserdatauv(L, sizeof(gm_worker_ref_t), 0);
+    ref->worker = NULL;
+    luaL_setmetatable(L, GM_WORKER_MT);
+
+    gm_worker_t *w = (gm_worker_t *)calloc(sizeof(gm_worker_t), 1);
+    if (w == NULL || (w->lock = SDL_CreateMutex()) == NULL)
+    {
+        free(w);
+        return luaL_error(L, "could not create worker %s", path);
+    }
+    w->pool = pool;
+    SDL_strlcpy(w->path, path, sizeof(w->path));
+
+    // one reference for the userdata, one for the pool until the worker is closed
+    SDL_SetAtomicInt(&w->refs, 2);
+    ref->worker = w;
+
+    // the first run loads the script
+    gm_worker_schedule(w);
+    return 1;
+}
+
+// worker:send(value), tables are copied, typed arrays are handed over
+static int gm_worker_lua_send(lua_State *L)
+{
+    gm_worker_t *w = gm_worker_check(L, 1);
+    luaL_checkany(L, 2);
+    luaL_argcheck(L, !SDL_GetAtomicInt(&w->closing), 1, "worker is closed");
+
+    gm_worker_msg_t *msg = gm_worker_pack(L, 2);
+    SDL_LockMutex(w->lock);
+    gm_worker_queue_push(&w->inbox, msg);
+    SDL_UnlockMutex(w->lock);
+    gm_worker_schedule(w);
+    return 0;
+}
+
+// worker:receive() returns the next message from the worker, or nil
+static int gm_worker_lua_receive(lua_State *L)
+{
+    gm_worker_t *w = gm_worker_check(L, 1);
+    SDL_LockMutex(w->lock);
+    gm_worker_msg_t *msg = gm_worker_queue_pop(&w->outbox);
+    SDL_UnlockMutex(w->lock);
+    if (msg == NULL || !gm_worker_unpack(L, msg))
+    {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+// worker:pending() returns the number of messages waiting on each side: to the worker, from it
+static int gm_worker_lua_pending(lua_State *L)
+{
+    gm_worker_t *w = gm_worker_check(L, 1);
+    SDL_LockMutex(w->lock);
+    lua_pushinteger(L, w->inbox.count);
+    lua_pushinteger(L, w->outbox.count);
+    SDL_UnlockMutex(w->lock);
+    return 2;
+}
+
+// worker:error() returns the last error of the worker's script, or nil
+static int gm_worker_lua_error(lua_State *L)
+{
+    gm_worker_t *w = gm_worker_check(L, 1);
+    SDL_LockMutex(w->lock);
+    if (w->error[0])
+    {
+        lua_pushstring(L, w->error);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+    SDL_UnlockMutex(w->lock);
+    return 1;
+}
+
+// worker:close(), messages not handled yet are dropped
+static int gm_worker_lua_close(lua_State *L)
+{
+    gm_worker_close(gm_worker_check(L, 1));
+    return 0;
+}
+
+static int gm_worker_lua_gc(lua_State *L)
+{
+    gm_worker_ref_t *ref = (gm_worker_ref_t *)luaL_checkudata(L, 1, GM_WORKER_MT);
+    if (ref->worker)
+    {
+        gm_worker_close(ref->worker);
+        gm_worker_release(ref->worker);
+        ref->worker = NULL;
+    }
+    return 0;
+}
+
+void gm_worker_register_lua(gm_worker_pool_t *pool, lua_State *L)
+{
+    static const luaL_Reg methods[] = {
+        {"send", gm_worker_lua_send},
+        {"receive", gm_worker_lua_receive},
+        {"pending", gm_worker_lua_pending},
+        {"error", gm_worker_lua_error},
+        {"close", gm_worker_lua_close},
+        {NULL, NULL}};
+
+    luaL_newmetatable(L, GM_WORKER_MT);
+    lua_pushcfunction(L, gm_worker_lua_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_newlib(L, methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    gm_lua_push_api(L);
+    lua_pushlightuserdata(L, pool);
+    lua_pushcclosure(L, gm_worker_lua_new, 1);
+    lua_setfield(L, -2, "worker");
+    lua_pop(L, 1);
+}
@@ -0,0 +1,97 @@
+#ifndef __GM_WORKER_H__
+#define __GM_WORKER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+#include "gm_pack.h"
+
+#define GM_WORKER_MT "gm.worker"
+#define GM_WORKER_MAX_THREADS 64
+
+// messages a worker handles before it yields its pool thread to the next worker
+#define GM_WORKER_BATCH 64
+
+// nesting limit for tables in a message
+#define GM_WORKER_MAX_DEPTH 32
+#define GM_WORKER_MAX_ARRAYS 256
+
+// instructions between two checks for a pool shutdown or a close while a worker runs Lua
+#define GM_WORKER_HOOK_COUNT 1000
+
+// A serialized Lua value. Typed arrays are not copied, their blocks are listed in
+// `arrays` and owned by the message until it is received.
+typedef struct gm_worker_msg_t
+{
+    struct gm_worker_msg_t *next;
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    void **arrays;
+    int array_count;
+} gm_worker_msg_t;
+
+typedef struct
+{
+    gm_worker_msg_t *head;
+    gm_worker_msg_t *tail;
+    int count;
+} gm_worker_queue_t;
+
+typedef struct gm_worker_pool_t gm_worker_pool_t;
+
+// One worker: a Lua state of its own running a script, driven by its inbox.
+// Shared by the main state's userdata and the pool, freed when both let go.
+typedef struct gm_worker_t
+{
+    gm_worker_pool_t *pool;
+    char path[256];
+
+    // only touched by the pool thread currently running the worker
+    lua_State *L;
+    bool loaded;
+    bool failed;
+
+    // guards both queues and the error message
+    SDL_Mutex *lock;
+    gm_worker_queue_t inbox;
+    gm_worker_queue_t outbox;
+    char error[256];
+
+    // set while the worker is queued or running, so it is never run twice at once
+    SDL_AtomicInt scheduled;
+    SDL_AtomicInt closing;
+    SDL_AtomicInt refs;
+
+    struct gm_worker_t *next_run;
+} gm_worker_t;
+
+// Threads that run workers with pending messages, started on the first gm.worker.
+struct gm_worker_pool_t
+{
+    const gm_pack_t *pack;
+    SDL_Mutex *lock;
+    SDL_Condition *wake;
+    gm_worker_t *run_head;
+    gm_worker_t *run_tail;
+    bool quit;
+
+    // read by the worker states' count hook, so a script stuck in a loop cannot block shutdown
+    SDL_AtomicInt stopping;
+
+    SDL_Thread *threads[GM_WORKER_MAX_THREADS];
+    int thread_count;
+};
+
+int gm_worker_pool_init(gm_worker_pool_t **pool, const gm_pack_t *pack);
+
+// Call after the main Lua state is closed: runs the pending closes and joins the threads.
+void gm_worker_pool_shutdown(gm_worker_pool_t *pool);
+
+// Adds gm.worker to the game API.
+void gm_worker_register_lua(gm_worker_pool_t *pool, lua_State *L);
+
+#endif // __GM_WORKER_H__
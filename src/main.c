@@ -24,74 +24,426 @@
 #include "gm_lua.h"
 #include "gm_fps.h"
 #include "gm_console.h"
+#include "gm_config.h"
+#include "gm_bytecode.h"
+#include "gm_font.h"
+#include "gm_startup.h"
+#include "gm_input.h"
+#include "gm_audio.h"
+#include "gm_replay.h"
+#include "gm_fill.h"
+#include "gm_sprite.h"
+#include "gm_canvas.h"
+#include "gm_batch.h"
+#include "gm_profile.h"
+#include "gm_trace.h"
+#include "gm_array.h"
+#include "gm_task.h"
+#include "gm_worker.h"
+#include "gm_vec.h"
+#include "gm_spatial.h"
+#include "gm_particles.h"
+#include "gm_tilemap.h"
+#include "gm_post.h"
+#include "gm_asset.h"
+#include "gm_hook.h"
+#include "gm_watchdog.h"
+
+int gm_sdl_init(gm_t *gmctx, const gm_config_t *config);
+void gm_sdl_shutdown(gm_t *gmctx);
 
-#define CNV_W 320
-#define CNV_H 240
+// Lua state creation and game.lua compilation, run in parallel with SDL startup
+typedef struct
+{
+    const gm_pack_t *pack;
+    gm_lua_t *lua_ctx;
+    gm_lua_error_t err;
+} gm_lua_startup_t;
 
-#define GFX_W (CNV_W * 2)
-#define GFX_H (CNV_H * 2)
+static int gm_lua_startup_thread(void *data)
+{
+    gm_lua_startup_t *job = (gm_lua_startup_t *)data;
+    gm_trace_thread_name("lua_startup");
 
-int gm_sdl_init(gm_t *gmctx);
-void gm_sdl_shutdown(gm_t *gmctx);
-int gm_sdl_load_fonts(gm_t *gmctx);
+    int phase = gm_startup_begin("lua_state");
+    job->err = gm_lua_init(&job->lua_ctx, job->pack);
+    gm_startup_end(phase);
+
+    if (job->err.code <= 100)
+    {
+        phase = gm_startup_begin("lua_compile");
+        gm_lua_precompile(job->lua_ctx);
+        gm_startup_end(phase);
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
-    // 1. Allocate and initialize the game context
+    gm_startup_init();
+    int phase = gm_startup_begin("config");
+
+    // 0. Resolve the configuration: defaults, then conf.lua, then command line flags
+    gm_config_t config;
+    gm_config_defaults(&config);
+    int args = gm_config_parse_args(&config, argc, argv);
+    if (args != 0)
+    {
+        return args == 2 ? 0 : 1;
+    }
+
+    if (config.compile_only)
+    {
+        return gm_bytecode_compile_dir(".") == 0 ? 0 : 1;
+    }
+
+    if (config.pack_build)
+    {
+        return gm_pack_build(config.pack_path, ".");
+    }
+
+    // Map the asset pack if there is one, conf.lua may live inside it
+    gm_pack_t *pack = NULL;
+    if (file_exists(config.pack_path) && gm_pack_open(&pack, config.pack_path))
+    {
+        return 1;
+    }
+    if (gm_config_load_file(&config, GM_CONFIG_FILE, pack))
+    {
+        gm_pack_close(pack);
+        return 1;
+    }
+    // flags are applied again so they override conf.lua
+    if (gm_config_parse_args(&config, argc, argv) != 0)
+    {
+        gm_pack_close(pack);
+        return 1;
+    }
+    gm_trace_init(config.trace_path[0] != '\0');
+
+    // Batch mode renders offline on worker threads and never opens a window
+    if (config.batch_path[0])
+    {
+        gm_batch_t *batch = NULL;
+        int failed = 1;
+        if (gm_batch_init(&batch, config.batch_path, pack, config.cvs_width, config.cvs_height, config.batch_frames,
+                          config.watchdog_ms) == 0)
+        {
+            failed = gm_batch_run(batch, config.batch_jobs);
+        }
+        gm_batch_shutdown(batch);
+        if (gm_trace_enabled())
+        {
+            gm_trace_write(config.trace_path);
+        }
+        gm_trace_shutdown();
+        gm_pack_close(pack);
+        SDL_Quit();
+        return failed == 0 ? 0 : 1;
+    }
+
+    // A replay runs on the recorded canvas, so mouse positions mean the same thing
+    gm_replay_t *replay = NULL;
+    if (config.replay_path[0])
+    {
+        if (gm_replay_open(&replay, config.replay_path))
+        {
+            gm_pack_close(pack);
+            return 1;
+        }
+        config.cvs_width = replay->cvs_width;
+        config.cvs_height = replay->cvs_height;
+    }
+    else if (config.record_path[0] &&
+             gm_replay_record(&replay, config.record_path, SDL_GetPerformanceCounter(), config.cvs_width, config.cvs_height))
+    {
+        gm_pack_close(pack);
+        return 1;
+    }
+    bool playback = replay && !replay->recording;
+    gm_startup_end(phase);
+
+    // 1. Start creating the Lua state and compiling game.lua, SDL is not needed for that
+    gm_lua_startup_t lua_startup;
+    memset(&lua_startup, 0, sizeof(lua_startup));
+    lua_startup.pack = pack;
+    SDL_Thread *lua_thread = SDL_CreateThread(gm_lua_startup_thread, "gm_lua_startup", &lua_startup);
+    if (lua_thread == NULL)
+    {
+        SDL_Log("Could not start Lua startup thread, initializing inline: %s\n", SDL_GetError());
+        gm_lua_startup_thread(&lua_startup);
+    }
+
+    // 2. Allocate and initialize the game context, window and renderer
     gm_t *gmctx = (gm_t *)calloc(sizeof(gm_t), 1);
     if (gmctx == NULL)
     {
         printf("Unable to allocate memory.\n");
+        SDL_WaitThread(lua_thread, NULL);
+        gm_lua_shutdown(lua_startup.lua_ctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
         return -1;
     }
+    gmctx->pack = pack;
 
-    gm_sdl_init(gmctx);
+    if (gm_sdl_init(gmctx, &config))
+    {
+        SDL_WaitThread(lua_thread, NULL);
+        gm_lua_shutdown(lua_startup.lua_ctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
+        free(gmctx);
+        return 1;
+    }
+
+    // 3. The engine font is shared by the fps display and the console, and opened on first use
+    if (gm_font_init(&gmctx->font, gmctx->pack, 10.0f))
+    {
+        SDL_WaitThread(lua_thread, NULL);
+        gm_lua_shutdown(lua_startup.lua_ctx);
+        gm_sdl_shutdown(gmctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
+        free(gmctx);
+        return 1;
+    }
 
-    // 2. Initialize the on-screen console
+    // 4. Initialize the on-screen console
     gm_console_t *console = NULL;
-    if (gm_console_init(&console))
+    if (gm_console_init(&console, gmctx->font))
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize console.\n");
+        SDL_WaitThread(lua_thread, NULL);
+        gm_lua_shutdown(lua_startup.lua_ctx);
         gm_sdl_shutdown(gmctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
         free(gmctx);
         return 1;
     }
     gm_console_add_text(console, "Console initialized. Press ` to toggle.");
 
-    // 3. Initialize the Lua Bindings
-    gm_lua_t *lua_ctx = NULL;
-    gm_lua_error_t err = gm_lua_init(&lua_ctx, gmctx->renderer, gmctx->texture, gmctx->cvs_width, gmctx->cvs_height);
+    // 5. Wait for the Lua state, then bind it to the renderer
+    phase = gm_startup_begin("lua_wait");
+    SDL_WaitThread(lua_thread, NULL);
+    gm_startup_end(phase);
+
+    gm_lua_t *lua_ctx = lua_startup.lua_ctx;
+    gm_lua_error_t err = lua_startup.err;
     if (err.code > 100)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize Lua context: %s\n", err.message);
         gm_console_add_text(console, err.message);
         gm_console_show(console);
+        gm_console_shutdown(console);
+        gm_lua_shutdown(lua_ctx);
         gm_sdl_shutdown(gmctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
         free(gmctx);
         return 1;
     }
 
-    // 4. Initialize the FPS display
+    // recorded and replayed sessions share the seed, so math.random repeats
+    if (replay)
+    {
+        gm_lua_seed_random(lua_ctx, replay->seed);
+        SDL_srand(replay->seed);
+    }
+
+    phase = gm_startup_begin("lua_api");
+    gm_lua_register_game_api(lua_ctx, gmctx->renderer, gmctx->texture, gmctx->cvs_width, gmctx->cvs_height);
+    gm_startup_end(phase);
+
+    // 6. Initialize the FPS display, game input, audio and the drawing modules
     gm_fps_t *fps = NULL;
-    if (gm_fps_init(&fps))
+    gm_input_t *input = NULL;
+    gm_audio_t *audio = NULL;
+    gm_fill_t *fill = NULL;
+    gm_sprite_t *sprite = NULL;
+    gm_canvas_ctx_t *canvas = NULL;
+    gm_hook_t *hook = NULL;
+    gm_profile_t *profile = NULL;
+    gm_watchdog_t *watchdog = NULL;
+    gm_array_ctx_t *array = NULL;
+    gm_particles_ctx_t *particles = NULL;
+    gm_tilemap_ctx_t *tilemap = NULL;
+    gm_post_t *post = NULL;
+    gm_asset_mgr_t *assets = NULL;
+    gm_task_sched_t *tasks = NULL;
+    gm_worker_pool_t *workers = NULL;
+    phase = gm_startup_begin("subsystems");
+    if (gm_fps_init(&fps) || gm_input_init(&input, gmctx->cvs_on_win_rect, gmctx->scale) ||
+        gm_audio_init(&audio, gmctx->pack, config.audio ? config.audio_frames : -1) ||
+        gm_fill_init(&fill, gmctx->renderer, gmctx->cvs_width, gmctx->cvs_height) ||
+        gm_sprite_init(&sprite, gmctx->renderer, gmctx->pack) ||
+        gm_canvas_init(&canvas, gmctx->renderer, lua_ctx->gm) ||
+        gm_array_init(&array, gmctx->renderer) ||
+        gm_particles_init(&particles, gmctx->renderer, gmctx->cvs_width, gmctx->cvs_height) ||
+        gm_tilemap_init(&tilemap, gmctx->renderer, lua_ctx->gm) ||
+        gm_post_init(&post, gmctx->renderer, gmctx->cvs_width, gmctx->cvs_height) ||
+        gm_asset_init(&assets, gmctx->renderer, gmctx->pack, true) ||
+        gm_task_init(&tasks, lua_ctx, GM_TASK_DEFAULT_BUDGET_MS) ||
+        gm_worker_pool_init(&workers, gmctx->pack) ||
+        gm_hook_init(&hook, lua_ctx->L) ||
+        gm_profile_init(&profile, hook, config.profile_hz) ||
+        gm_watchdog_init(&watchdog, hook, config.watchdog_ms))
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize FPS tracking.\n");
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize FPS tracking, input, audio, fills, sprites, canvases, arrays, particles, tilemaps, post-processing, assets, tasks, workers, the profiler or the watchdog.\n");
+        gm_watchdog_shutdown(watchdog);
+        gm_profile_shutdown(profile);
+        gm_worker_pool_shutdown(workers);
+        gm_task_shutdown(tasks);
+        gm_particles_shutdown(particles);
+        gm_tilemap_shutdown(tilemap);
+        gm_post_shutdown(post);
+        gm_asset_shutdown(assets);
+        gm_array_shutdown(array);
+        gm_canvas_shutdown(canvas);
+        gm_sprite_shutdown(sprite);
+        gm_fill_shutdown(fill);
+        gm_audio_shutdown(audio);
+        gm_input_shutdown(input);
+        gm_fps_shutdown(fps);
         gm_console_shutdown(console);
         gm_lua_shutdown(lua_ctx);
+        gm_hook_shutdown(hook);
         gm_sdl_shutdown(gmctx);
+        gm_replay_close(replay);
+        gm_pack_close(pack);
         free(gmctx);
         return 1;
     }
 
-    // 5. load the Lua game program
+    gm_startup_end(phase);
+
+    gm_input_register_lua(input, lua_ctx->L);
+    gm_audio_register_lua(audio, lua_ctx->L);
+    gm_fill_register_lua(fill, lua_ctx->L);
+    gm_sprite_register_lua(sprite, lua_ctx->L);
+    gm_canvas_register_lua(canvas, lua_ctx->L);
+    gm_array_register_lua(array, lua_ctx->L);
+    gm_vec_register_lua(lua_ctx->L);
+    gm_spatial_register_lua(lua_ctx->L);
+    gm_particles_register_lua(particles, lua_ctx->L);
+    gm_tilemap_register_lua(tilemap, lua_ctx->L);
+    gm_post_register_lua(post, lua_ctx->L);
+    gm_asset_register_lua(assets, lua_ctx->L);
+    gm_task_register_lua(tasks, lua_ctx->L);
+    gm_worker_register_lua(workers, lua_ctx->L);
+    gm_profile_register_lua(profile, lua_ctx->L);
+    gm_watchdog_register_lua(watchdog, lua_ctx->L);
+    gm_trace_register_lua(lua_ctx->L);
+    if (config.profile)
+    {
+        gm_profile_enable(profile, true);
+    }
+
+    // 7. run the Lua game program
+    phase = gm_startup_begin("lua_run");
+    gm_watchdog_arm(watchdog, "script load");
     gm_lua_load_file(lua_ctx);
+    gm_watchdog_disarm(watchdog);
+    gm_startup_end(phase);
 
-    // 6. Enter the draw loop
+    // 8. Enter the draw loop
+    bool first_frame = true;
+    phase = gm_startup_begin("first_frame");
     uint64_t prev = SDL_GetTicks();
     while (gmctx->quit == 0)
     {
-        // 1. Hot reload the Lua game program
-        gm_lua_error_t err = gm_lua_hot_reload(lua_ctx);
+        uint64_t frame_start = SDL_GetTicksNS();
+        uint64_t frame_span = gm_trace_begin();
+        gm_trace_lua_reset();
+
+        // 1. Handle the events generated, game input is batched for this frame's draw
+        uint64_t span = gm_trace_begin();
+        gm_input_begin_frame(input);
+        while (SDL_PollEvent(&gmctx->evt))
+        {
+            if (gmctx->evt.type == SDL_EVENT_QUIT)
+            {
+                gmctx->quit = 1;
+            }
+
+            // Check if the pressed key is Escape
+            if (gmctx->evt.type == SDL_EVENT_KEY_DOWN && gmctx->evt.key.key == SDLK_ESCAPE)
+            {
+                SDL_Log("Escape key pressed, quitting.");
+                // Set your loop condition to false
+                gmctx->quit = 1;
+            }
+
+            // Check if the pressed key is the backtick (`) key
+            if (gmctx->evt.type == SDL_EVENT_KEY_DOWN)
+            {
+
+                if (gmctx->evt.key.key == SDLK_GRAVE)
+                {
+                    bool console_shown = gm_console_toggle(console);
+                    SDL_Log("Toggled console, now %s", console_shown ? "hidden" : "shown");
+                }
+
+                // F9 starts the profiler, or stops it and writes what it collected
+                if (gmctx->evt.key.key == SDLK_F9 && !gmctx->evt.key.repeat)
+                {
+                    bool start = !profile->enabled;
+                    gm_profile_enable(profile, start);
+                    if (!start && gm_profile_write(profile, GM_PROFILE_FILE) == 0)
+                    {
+                        gm_console_add_text(console, "Profile written to " GM_PROFILE_FILE);
+                        gm_profile_reset(profile);
+                    }
+                }
+
+                // F10 writes the trace collected so far
+                if (gmctx->evt.key.key == SDLK_F10 && !gmctx->evt.key.repeat && gm_trace_enabled() &&
+                    gm_trace_write(config.trace_path) == 0)
+                {
+                    gm_console_add_text(console, "Trace written.");
+                }
+            }
+
+            // during playback the game only sees recorded input
+            if (!playback)
+            {
+                gm_input_push_sdl(input, &gmctx->evt);
+            }
+        }
+
+        gm_trace_end("events", span);
+
+        // A replayed frame brings its own dt, input and reload
+        float replay_dt = 0.0f;
+        bool replay_reload = false;
+        if (playback && !gm_replay_read_frame(replay, &replay_dt, &replay_reload, input))
+        {
+            SDL_Log("End of recording.\n");
+            break;
+        }
+
+        // 2. Hot reload the Lua game program
+        span = gm_trace_begin();
+        gm_lua_error_t err;
+        gm_watchdog_arm(watchdog, "script load");
+        if (playback)
+        {
+            memset(&err, 0, sizeof(err));
+            if (replay_reload)
+            {
+                err = gm_lua_load_file(lua_ctx);
+            }
+        }
+        else
+        {
+            err = gm_lua_hot_reload(lua_ctx);
+            if (replay && (err.reloaded || err.code != 0))
+            {
+                gm_replay_mark_reload(replay);
+            }
+        }
+        gm_watchdog_disarm(watchdog);
         if (err.code != 0)
         {
             SDL_Log("Lua hot reload error: %s\n", err.message);
@@ -103,108 +455,173 @@ int main(int argc, char *argv[])
             gm_console_add_text(console, "Lua script reloaded successfully.");
             gm_console_hide(console);
         }
+        gm_trace_end("hot_reload", span);
+
+        // images loaded in the background are uploaded before draw can use them
+        gm_asset_update(assets, lua_ctx->L);
 
-        // 2. Render game commands into the offscreen canvas texture
+        // 3. Render game commands into the offscreen canvas texture
         SDL_SetRenderTarget(gmctx->renderer, gmctx->texture);
 
-        // 3. Call the draw function in the game program
+        // 4. Call the draw function in the game program
         uint64_t now = SDL_GetTicks();
-        float dt = (float)(now - prev);
+        float dt = playback ? replay_dt : (float)(now - prev);
+        if (replay && replay->recording)
+        {
+            gm_replay_write_frame(replay, dt, input);
+        }
+        gm_input_consume(input, SDL_GetTicksNS());
+        gm_profile_begin_frame(profile);
+        span = gm_trace_begin();
+        gm_watchdog_arm(watchdog, "draw");
         err = gm_lua_call_draw(lua_ctx, dt);
+        gm_watchdog_disarm(watchdog);
+        gm_trace_end("draw", span);
         if (err.code != 0)
         {
             SDL_Log("Draw error: %s\n", err.message);
             gm_console_add_text(console, err.message);
             gm_console_show(console);
         }
+
+        // background tasks get what is left of the frame, up to their budget
+        span = gm_trace_begin();
+        gm_watchdog_arm(watchdog, "tasks");
+        int failed_tasks = gm_task_run(tasks, err.message, sizeof(err.message));
+        gm_watchdog_disarm(watchdog);
+        if (failed_tasks > 0)
+        {
+            gm_console_add_text(console, err.message);
+            gm_console_show(console);
+        }
+        gm_trace_end("tasks", span);
         prev = now;
 
         // Switch back to the window backbuffer for compositing UI + present
         SDL_SetRenderTarget(gmctx->renderer, NULL);
 
-        // 4. Clear renderer with a dark colour
+        // 5. Clear renderer with a dark colour
+        span = gm_trace_begin();
         SDL_SetRenderDrawColor(gmctx->renderer, 0, 0, 10, SDL_ALPHA_OPAQUE);
         SDL_RenderClear(gmctx->renderer);
 
-        // 5. Draw the game
-        SDL_RenderTexture(gmctx->renderer, gmctx->texture, NULL, (const SDL_FRect *)&(gmctx->cvs_on_win_rect));
+        // 6. Draw the game, through the post-processing effects
+        gm_post_composite(post, gmctx->texture, (const SDL_FRect *)&(gmctx->cvs_on_win_rect));
+        gm_trace_end("composite", span);
 
-        // 6. Draw the fps
+        // 7. Draw the fps
+        span = gm_trace_begin();
         gm_fps_draw(fps, gmctx->renderer, gmctx->font, 10, 10);
+        gm_trace_end("fps", span);
 
-        // 7. Draw the console
+        // 8. Draw the console
+        span = gm_trace_begin();
         gm_console_draw(console, gmctx->renderer);
+        gm_trace_end("console", span);
 
-        // 8. Show the screen
+        // 9. Show the screen
+        span = gm_trace_begin();
         SDL_RenderPresent(gmctx->renderer);
-
-        // 9. Handle the events generated
-        while (SDL_PollEvent(&gmctx->evt))
+        gm_trace_end("present", span);
+        if (first_frame)
         {
-            if (gmctx->evt.type == SDL_EVENT_QUIT)
+            first_frame = false;
+            gm_startup_end(phase);
+            if (config.startup_profile)
             {
-                gmctx->quit = 1;
+                gm_startup_report();
             }
+        }
 
-            // Check if the pressed key is Escape
-            if (gmctx->evt.key.key == SDLK_ESCAPE)
-            {
-                SDL_Log("Escape key pressed, quitting.");
-                // Set your loop condition to false
-                gmctx->quit = 1;
-            }
+        if (replay)
+        {
+            gm_replay_frame_time(replay, SDL_GetTicksNS() - frame_start);
+        }
+        gm_trace_end("frame", frame_span);
+    }
 
-            // Check if the pressed key is the backtick (`) key
-            if (gmctx->evt.type == SDL_EVENT_KEY_DOWN)
-            {
+    if (replay)
+    {
+        gm_replay_report(replay);
+        gm_replay_close(replay);
+    }
 
-                if (gmctx->evt.key.key == SDLK_GRAVE)
-                {
-                    bool console_shown = gm_console_toggle(console);
-                    SDL_Log("Toggled console, now %s", console_shown ? "hidden" : "shown");
-                }
-            }
-        }
+    // a profile still running at exit is written out, so staging runs keep their data
+    if (profile->enabled)
+    {
+        gm_profile_write(profile, GM_PROFILE_FILE);
     }
 
-    // 7. Shutdown and exit
+    // 9. Shutdown and exit, audio first so the mixer stops before SDL quits
+    gm_audio_shutdown(audio);
+    gm_watchdog_shutdown(watchdog);
+    gm_profile_shutdown(profile);
+    gm_task_shutdown(tasks);
     gm_lua_shutdown(lua_ctx);
+    gm_hook_shutdown(hook);
+
+    // after the Lua state, whose collected workers and assets are released through these
+    gm_worker_pool_shutdown(workers);
+    gm_asset_shutdown(assets);
+    gm_fill_shutdown(fill);
+    gm_sprite_shutdown(sprite);
+    gm_canvas_shutdown(canvas);
+    gm_array_shutdown(array);
+    gm_particles_shutdown(particles);
+    gm_tilemap_shutdown(tilemap);
+    gm_post_shutdown(post);
     gm_sdl_shutdown(gmctx);
     gm_fps_shutdown(fps);
     gm_console_shutdown(console);
+    gm_input_shutdown(input);
+    gm_pack_close(gmctx->pack);
     free(gmctx);
 
+    if (gm_trace_enabled())
+    {
+        gm_trace_write(config.trace_path);
+    }
+    gm_trace_shutdown();
+
     return 0;
 }
 
-int gm_sdl_init(gm_t *gmctx)
+int gm_sdl_init(gm_t *gmctx, const gm_config_t *config)
 {
-    memset(gmctx, 0, sizeof(gm_t));
-
     // dimensions of the canvas
-    gmctx->cvs_width = CNV_W;
-    gmctx->cvs_height = CNV_H;
+    gmctx->cvs_width = config->cvs_width;
+    gmctx->cvs_height = config->cvs_height;
+    gmctx->scale = config->scale;
     gmctx->cvs_on_win_rect.x = 0;
     gmctx->cvs_on_win_rect.y = 0;
-    gmctx->cvs_on_win_rect.w = GFX_W;
-    gmctx->cvs_on_win_rect.h = GFX_H;
+    gmctx->cvs_on_win_rect.w = (float)(config->cvs_width * config->scale);
+    gmctx->cvs_on_win_rect.h = (float)(config->cvs_height * config->scale);
 
     // dimensions of the window
-    gmctx->win_width = GFX_W;
-    gmctx->win_height = GFX_H;
+    gmctx->win_width = config->cvs_width * config->scale;
+    gmctx->win_height = config->cvs_height * config->scale;
+
+    // headless replays render into a window that is never shown
+    if (config->headless)
+    {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
 
     // initialize SDL3
+    int phase = gm_startup_begin("sdl_init");
     if (!SDL_Init(SDL_INIT_VIDEO))
     {
         SDL_Log("SDL Init failed.\n");
         return 1;
     }
     SDL_Log("SDL Init succeeded.\n");
+    gm_startup_end(phase);
 
     SDL_srand((unsigned int)time(NULL));
 
     // create a window with the given dimensions and title
-    gmctx->window = SDL_CreateWindow("GMCORE", gmctx->win_width, gmctx->win_height, 0);
+    phase = gm_startup_begin("window");
+    gmctx->window = SDL_CreateWindow("GMCORE", gmctx->win_width, gmctx->win_height, config->headless ? SDL_WINDOW_HIDDEN : 0);
     if (gmctx->window == NULL)
     {
         SDL_Log("Could not get window... %s\n", SDL_GetError());
@@ -212,26 +629,36 @@ int gm_sdl_init(gm_t *gmctx)
         return 2;
     }
 
-    gm_sdl_load_fonts(gmctx);
+    gm_startup_end(phase);
 
-    // create renderer
-    gmctx->renderer = SDL_CreateRenderer(gmctx->window, NULL);
+    // create renderer, NULL lets SDL pick the best available driver
+    phase = gm_startup_begin("renderer");
+    const char *driver = config->renderer[0] ? config->renderer : NULL;
+    gmctx->renderer = SDL_CreateRenderer(gmctx->window, driver);
     if (!gmctx->renderer)
     {
-        SDL_Log("SDL_CreateRenderer failed: %s\n", SDL_GetError());
+        SDL_Log("SDL_CreateRenderer(%s) failed: %s\n", driver ? driver : "auto", SDL_GetError());
         exit(1);
     }
     else
     {
-        // Enable VSync
-        if (SDL_SetRenderVSync(gmctx->renderer, 1) == false)
+        SDL_Log("Renderer: %s, canvas %dx%d, scale %d, vsync %s\n",
+                SDL_GetRendererName(gmctx->renderer),
+                gmctx->cvs_width, gmctx->cvs_height, gmctx->scale,
+                config->vsync ? "on" : "off");
+
+        // Enable or disable VSync
+        if (SDL_SetRenderVSync(gmctx->renderer, config->vsync ? 1 : SDL_RENDERER_VSYNC_DISABLED) == false)
         {
-            SDL_Log("Could not enable VSync! SDL error: %s\n", SDL_GetError());
+            SDL_Log("Could not set VSync! SDL error: %s\n", SDL_GetError());
             exit(1);
         }
     }
 
+    gm_startup_end(phase);
+
     // create the texture
+    phase = gm_startup_begin("canvas");
     gmctx->texture = SDL_CreateTexture(
         gmctx->renderer,
         SDL_PIXELFORMAT_RGBA8888,
@@ -253,6 +680,7 @@ int gm_sdl_init(gm_t *gmctx)
     SDL_SetRenderDrawColor(gmctx->renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderClear(gmctx->renderer);
     SDL_SetRenderTarget(gmctx->renderer, NULL);
+    gm_startup_end(phase);
 
     // init game loop vars
     gmctx->quit = 0;
@@ -276,37 +704,7 @@ void gm_sdl_shutdown(gm_t *gmctx)
         SDL_DestroyWindow(gmctx->window);
     }
 
-    if (gmctx->font)
-    {
-        TTF_CloseFont(gmctx->font);
-    }
-    TTF_Quit();
+    gm_font_shutdown(gmctx->font);
 
     SDL_Quit();
 }
-
-int gm_sdl_load_fonts(gm_t *gmctx)
-{
-    if (!TTF_Init())
-    {
-        SDL_Log("Couldn't initialize SDL_ttf: %s\n", SDL_GetError());
-        return SDL_APP_FAILURE;
-    }
-
-    const char *base_path = SDL_GetBasePath();
-    if (base_path)
-    {
-        char font_path[1024];
-
-        SDL_snprintf(font_path, sizeof(font_path), "%s/SourceCodePro-Regular.ttf", base_path);
-
-        gmctx->font = TTF_OpenFont(font_path, 10.0f);
-        if (gmctx->font == NULL)
-        {
-            SDL_Log("Failed to load font: %s", SDL_GetError());
-            return -1;
-        }
-        SDL_Log("Loading font from: %s\n", font_path);
-    }
-    return 0;
-}